@@ -0,0 +1,36 @@
+#!/bin/sh
+# Builds the interpreter with every dispatch mode and times them running the same program.
+# Usage: bench/dispatch.sh [programa.asm] [repetições]
+
+set -e
+
+PROGRAM=${1:-bench/programs/count_loop.asm}
+RUNS=${2:-3}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+for mode in switch threaded; do
+    make -s DISPATCH=$mode > /dev/null 2>&1
+    cp bin/main "$WORK/main-$mode"
+done
+
+echo "programa: $PROGRAM"
+for mode in switch threaded; do
+    best=
+    run=0
+    while [ $run -lt "$RUNS" ]; do
+        start=$(date +%s%N)
+        "$WORK/main-$mode" --quiet "$PROGRAM" > /dev/null
+        end=$(date +%s%N)
+        elapsed=$(((end - start) / 1000000))
+        if [ -z "$best" ] || [ $elapsed -lt "$best" ]; then
+            best=$elapsed
+        fi
+        run=$((run + 1))
+    done
+    echo "$mode: $best ms"
+    eval "best_$mode=$best"
+done
+
+awk -v switch="$best_switch" -v threaded="$best_threaded" \
+    'BEGIN { if (threaded > 0) printf "threaded/switch: %.2fx\n", switch / threaded }'
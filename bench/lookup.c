@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "keyword.h"
+
+/*
+ * Times find_keyword against the linear strcmp over every mnemonic and register name it replaced, on
+ * the words of a typical line of assembly plus some that are no keyword at all.
+ * Usage: make bench-lookup
+ */
+
+#define ROUNDS 2000000
+
+static const char *const MNEMONIC_TAGS[] = {
+#define MNEMONIC(name, format) #name,
+#define REGISTER(name, number)
+#include "keywords.def"
+#undef MNEMONIC
+#undef REGISTER
+};
+
+static const char *const REGISTER_TAGS[] = {
+#define MNEMONIC(name, format)
+#define REGISTER(name, number) "$" #name,
+#include "keywords.def"
+#undef MNEMONIC
+#undef REGISTER
+};
+
+static const char *const WORDS[] = {
+    "ADDI", "$t0", "$t0", "LW", "$s1", "$sp", "BNE", "$t1", "$zero", "SW", "$ra", "$fp",
+    "JAL", "ORI", "$a0", "$v0", "SUBU", "$t9", "NOP", "$8", "ADDIU", "$t10", "label", "SW",
+};
+
+static int linear_lookup(const char *word);
+static double time_lookups(int (*lookup)(const char *word));
+static int hash_lookup(const char *word);
+
+static volatile int sink;
+
+int main(void)
+{
+    double linear = time_lookups(linear_lookup);
+    double hash = time_lookups(hash_lookup);
+
+    printf("strcmp linear: %6.2f ns por palavra\n", linear);
+    printf("hash perfeito: %6.2f ns por palavra\n", hash);
+    printf("ganho:         %6.2fx\n", linear / hash);
+    return 0;
+}
+
+static int linear_lookup(const char *word)
+{
+    for (size_t i = 0; i < sizeof(MNEMONIC_TAGS) / sizeof(MNEMONIC_TAGS[0]); i++)
+    {
+        if (strcmp(word, MNEMONIC_TAGS[i]) == 0)
+        {
+            return i;
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(REGISTER_TAGS) / sizeof(REGISTER_TAGS[0]); i++)
+    {
+        if (strcmp(word, REGISTER_TAGS[i]) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static int hash_lookup(const char *word)
+{
+    const Keyword *keyword = find_keyword(word, strlen(word));
+    return keyword != NULL ? keyword->value : -1;
+}
+
+/// @brief Nanoseconds per word looked up.
+static double time_lookups(int (*lookup)(const char *word))
+{
+    size_t count = sizeof(WORDS) / sizeof(WORDS[0]);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            sink = lookup(WORDS[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsed = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    return elapsed / ((double)ROUNDS * count);
+}
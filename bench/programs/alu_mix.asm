@@ -0,0 +1,13 @@
+ADDI $s0, $zero, 10000000
+ADDI $t0, $zero, 3
+ADDI $t1, $zero, 5
+ADDU $t2, $t0, $t1
+MUL $t3, $t2, $t1
+AND $t4, $t3, $t2
+OR $t5, $t4, $t0
+ADDU $t0, $t5, $t3
+MUL $t1, $t1, $t0
+AND $t6, $t1, $t5
+OR $t1, $t6, $t2
+ADDI $s0, $s0, -1
+BNE $s0, $zero, 12
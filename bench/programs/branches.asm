@@ -0,0 +1,13 @@
+ADDI $s0, $zero, 10000000
+ADDI $s3, $zero, 12345
+ADDI $s4, $zero, 1103515245
+MUL $s3, $s3, $s4
+ADDI $s3, $s3, 1
+ANDI $t0, $s3, 65536
+BEQ $t0, $zero, 32
+ADDI $s1, $s1, 1
+ANDI $t1, $s3, 131072
+BNE $t1, $zero, 44
+ADDI $s2, $s2, 1
+ADDI $s0, $s0, -1
+BGTZ $s0, $zero, 12
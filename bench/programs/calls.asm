@@ -0,0 +1,11 @@
+ADDI $s0, $zero, 10000000
+JAL 20
+ADDI $s0, $s0, -1
+BNE $s0, $zero, 4
+J 44
+ADD $s7, $ra, $zero
+JAL 36
+ADD $ra, $s7, $zero
+JR $ra
+ADDI $s1, $s1, 1
+JR $ra
@@ -0,0 +1,4 @@
+ADDI $t0, $zero, 50000000
+ADDI $t1, $t1, 1
+ADDI $t0, $t0, -1
+BNE $t0, $zero, 4
@@ -0,0 +1,7 @@
+ADDI $s0, $zero, 10000
+ADDI $t0, $zero, 3000
+ADDI $t1, $t1, 1
+ADDI $t0, $t0, -1
+BNE $t0, $zero, 8
+ADDI $s0, $s0, -1
+BNE $s0, $zero, 4
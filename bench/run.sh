@@ -0,0 +1,85 @@
+#!/bin/sh
+# Runs every program in bench/programs with and without the JIT for a fixed instruction budget,
+# reports the best of several runs and compares the throughput against a stored baseline.
+# Usage: bench/run.sh [--save-baseline]
+#
+# The baseline only means something on the machine it was recorded on, so it is not kept in the
+# repository: the first run records it, and --save-baseline records it again.
+#
+# BENCH_BUDGET     instruções executadas por programa, com --stop-after (80000000)
+# BENCH_RUNS       repetições de cada programa (5)
+# BENCH_TOLERANCE  queda de MIPS aceita em relação à base, em porcento (20)
+# BENCH_CSV        arquivo com os resultados (bench/results.csv)
+# BENCH_BASELINE   arquivo com a base de comparação (bench/baseline.csv)
+
+set -e
+
+BUDGET=${BENCH_BUDGET:-80000000}
+RUNS=${BENCH_RUNS:-5}
+TOLERANCE=${BENCH_TOLERANCE:-20}
+CSV=${BENCH_CSV:-bench/results.csv}
+BASELINE=${BENCH_BASELINE:-bench/baseline.csv}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+make -s > /dev/null
+
+echo "programa,motor,instrucoes,segundos,mips,ns_por_instrucao,rss_kib" > "$CSV"
+
+for program in bench/programs/*.asm; do
+    name=$(basename "$program" .asm)
+    for engine in interpretador jit; do
+        threshold=0
+        if [ $engine = jit ]; then
+            threshold=1
+        fi
+
+        # Keeps the fastest run, the others only measure noise
+        run=0
+        : > "$WORK/runs"
+        while [ $run -lt "$RUNS" ]; do
+            ./bin/main --quiet --stats --jit-threshold $threshold --stop-after "$BUDGET" "$program" 2>> "$WORK/runs" \
+                > /dev/null
+            run=$((run + 1))
+        done
+
+        # A program that ends before the budget would be measured on less work than the others
+        awk -v name="$name" -v engine="$engine" -v budget="$BUDGET" '
+            /^ESTATISTICAS/ {
+                for (i = 2; i <= NF; i++) { split($i, pair, "="); value[pair[1]] = pair[2] }
+                if (best == "" || value["mips"] + 0 > best + 0) {
+                    best = value["mips"]
+                    line = name "," engine "," value["instrucoes"] "," value["segundos"] "," value["mips"] "," \
+                           value["ns_por_instrucao"] "," value["rss_kib"]
+                }
+            }
+            END {
+                split(line, fields, ",")
+                if (fields[3] + 0 < budget + 0) {
+                    printf "ERRO: %s terminou com %s instruções, antes do orçamento de %s\n", name, fields[3], budget \
+                        > "/dev/stderr"
+                    exit 1
+                }
+                print line
+            }' "$WORK/runs" >> "$CSV"
+    done
+done
+
+awk -F, 'NR > 1 { printf "%-14s %-14s %12s instr %10s MIPS %8s ns/instr %8s KiB\n", $1, $2, $3, $5, $6, $7 }' "$CSV"
+
+if [ "$1" = "--save-baseline" ] || [ ! -f "$BASELINE" ]; then
+    cp "$CSV" "$BASELINE"
+    echo "base salva em $BASELINE"
+    exit 0
+fi
+
+awk -F, -v tolerance="$TOLERANCE" '
+    FNR == 1 { next }
+    NR == FNR { base[$1 "," $2] = $5; next }
+    ($1 "," $2) in base {
+        change = ($5 - base[$1 "," $2]) / base[$1 "," $2] * 100
+        status = change < -tolerance ? "REGRESSÃO" : "ok"
+        if (change < -tolerance) failed = 1
+        printf "%-14s %-14s %10s -> %10s MIPS %+7.1f%% %s\n", $1, $2, base[$1 "," $2], $5, change, status
+    }
+    END { exit failed }' "$BASELINE" "$CSV"
@@ -0,0 +1,40 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+typedef struct ArenaChunk ArenaChunk;
+typedef struct Arena Arena;
+
+struct ArenaChunk
+{
+    /// @brief Chunk filled before this one.
+    ArenaChunk *previous;
+
+    size_t size;
+    size_t used;
+    max_align_t data[];
+};
+
+/// @brief Memory handed out by bumping a pointer, and given back all at once.
+///
+/// Chunks double in size as they fill, so a program takes a handful of them however many objects it
+/// allocates. A zeroed Arena is empty and ready to use.
+struct Arena
+{
+    /// @brief Chunk allocations come from, NULL until the first one.
+    ArenaChunk *chunk;
+
+    /// @brief Start of the last allocation, the only one that can still grow in place.
+    void *last;
+};
+
+void *arena_allocate(Arena *arena, size_t size);
+void *arena_grow(Arena *arena, void *allocation, size_t size, size_t new_size);
+char *arena_copy(Arena *arena, const char *string, size_t length);
+void reset_arena(Arena *arena);
+void free_arena(Arena *arena);
+
+#endif
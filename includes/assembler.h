@@ -0,0 +1,96 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "memory.h"
+#include "program.h"
+#include "source.h"
+
+#define ASSEMBLER_BUFFER_SIZE (64 * 1024)
+
+/// @brief Address of the first byte of the .data section, the same as SPIM and MARS.
+#define DATA_BASE 0x10010000
+
+#define LABEL_NONE UINT32_MAX
+#define LABELS_INITIAL_CAPACITY 64
+
+typedef enum Section Section;
+typedef struct Label Label;
+typedef struct Fixup Fixup;
+typedef struct Assembler Assembler;
+
+enum Section
+{
+    SECTION_TEXT,
+    SECTION_DATA,
+};
+
+struct Label
+{
+    char *name;
+    uint32_t length;
+    uint32_t address;
+
+    /// @brief Whether the label was found yet, or only used by a reference ahead of it.
+    bool defined;
+
+    /// @brief Next label defined since anything was last emitted, or LABEL_NONE.
+    uint32_t next_pending;
+};
+
+/// @brief A use of a label that was not defined yet, patched once the whole source has been read.
+struct Fixup
+{
+    /// @brief Address of the instruction whose immediate, or of the data word, that gets the label address.
+    uint32_t address;
+
+    uint32_t label;
+    unsigned int line_number;
+
+    /// @brief Whether address is a word of .data instead of an instruction.
+    bool data;
+};
+
+/// @brief State of a single pass over an assembly source, allocated from the arena of its program.
+struct Assembler
+{
+    Program *program;
+
+    /// @brief Where .data goes, or NULL when only code can be assembled.
+    Memory *memory;
+
+    FILE *output;
+    unsigned int line_number;
+
+    Section section;
+    uint32_t text_address;
+    uint32_t data_address;
+
+    /// @brief Every label seen, in the order it was first defined or used.
+    Label *labels;
+    uint32_t label_count;
+    uint32_t label_capacity;
+
+    /// @brief Open addressed table of indices into labels plus one, where 0 is a free slot.
+    uint32_t *slots;
+
+    /// @brief Amount of slots minus one, which is a power of two.
+    uint32_t slot_mask;
+
+    /// @brief First label defined at the current address, which moves with it if it gets aligned.
+    uint32_t pending;
+
+    Fixup *fixups;
+    size_t fixup_count;
+    size_t fixup_capacity;
+};
+
+bool assemble_program(Program *program, Memory *memory, Source *input, FILE *output);
+bool assemble_file(Source *input, FILE *output, bool little_endian);
+bool next_source_line(Source *source, Slice *line);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+#include "cpu.h"
+#include "interpreter.h"
+#include "program.h"
+#include "trace.h"
+
+typedef struct BatchJob BatchJob;
+typedef struct WorkQueue WorkQueue;
+typedef struct Batch Batch;
+typedef struct Worker Worker;
+
+/// @brief One program of a batch and everything it printed.
+struct BatchJob
+{
+    char *path;
+    char *output;
+    size_t output_length;
+    int status;
+};
+
+/// @brief Jobs owned by one worker, from top to bottom - 1.
+///
+/// The owner takes jobs from the bottom, and idle workers steal them from the top.
+struct WorkQueue
+{
+    pthread_mutex_t lock;
+    unsigned int top;
+    unsigned int bottom;
+};
+
+/// @brief State shared by the workers of a batch, which is never written once they start.
+struct Batch
+{
+    BatchJob *jobs;
+    WorkQueue *queues;
+    unsigned int worker_count;
+    const Options *options;
+    TraceLevel trace_level;
+};
+
+struct Worker
+{
+    Batch *batch;
+    unsigned int index;
+};
+
+int run_file(CPU *cpu, Program *program, const char *path, const Options *options);
+int run_directory(const char *directory, const Options *options, TraceLevel trace_level, unsigned int threads);
+
+#endif
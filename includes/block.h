@@ -0,0 +1,129 @@
+#ifndef BLOCK_H
+#define BLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "instruction.h"
+#include "jit.h"
+
+#define BLOCK_MAX_LENGTH 64
+
+typedef enum Superinstruction Superinstruction;
+typedef struct BlockOperation BlockOperation;
+typedef struct Block Block;
+typedef struct BlockCache BlockCache;
+
+/// @brief Handlers that only exist inside translated blocks, numbered after the opcodes.
+enum Superinstruction
+{
+    /// @brief Leaves a block that does not end in a branch or jump.
+    BLOCK_END = OPCODE_COUNT,
+
+    /// @brief Leaves a block once the delay slot of its final branch or jump executes.
+    BLOCK_BRANCH_END,
+
+    /// @brief Executes any branch or jump that is followed by its delay slot.
+    BLOCK_DELAYED_BRANCH,
+    SUPER_ADDI_BEQ,
+    SUPER_ADDI_BNE,
+    SUPER_ADDI_BLEZ,
+    SUPER_ADDI_BGTZ,
+    SUPER_SUB_BEQ,
+    SUPER_SUB_BNE,
+    SUPER_SUB_BLEZ,
+    SUPER_SUB_BGTZ,
+    SUPER_ADD_ADD,
+    SUPER_ADDI_ADDI,
+
+    // Record what the instruction of the operation is about to overwrite into an undo log, then execute it
+    BLOCK_RECORD_RD,
+    BLOCK_RECORD_RT,
+    BLOCK_RECORD_RA,
+    BLOCK_RECORD_STORE,
+    BLOCK_RECORD_HI_LO,
+
+    /// @brief Records only the address of an instruction that overwrites nothing, then executes it.
+    BLOCK_RECORD_NOTHING,
+
+    /// @brief Records $v0 and the heap break, which are all a syscall can overwrite besides memory it reads
+    /// into, then executes it.
+    BLOCK_RECORD_SYSCALL,
+
+    HANDLER_COUNT
+};
+
+/// @brief One step of a translated block.
+///
+/// A superinstruction executes its own instruction and the one in the next operation, which is
+/// kept as it was so the block still describes every instruction it covers.
+struct BlockOperation
+{
+    union
+    {
+        /// @brief Opcode or Superinstruction that executes this operation.
+        uintptr_t kind;
+
+        /// @brief Address of the handler for kind, filled by threaded dispatch.
+        const void *handler;
+    };
+
+    Instruction instruction;
+};
+
+/// @brief A straight-line run of instructions, translated once and reused every time it runs.
+struct Block
+{
+    /// @brief Address of the first instruction.
+    unsigned int start;
+
+    /// @brief Amount of instructions covered, the last one being the branch or jump, if any, or its delay slot.
+    unsigned int length;
+
+    /// @brief Blocks reached when the final branch is not taken [0] or taken [1], linked as they are found.
+    Block *successors[2];
+
+    /// @brief Times the block was interpreted, counted until it is compiled.
+    unsigned int executions;
+
+    /// @brief The last instruction is the delay slot of the branch or jump before it.
+    bool delayed;
+
+    /// @brief Compiled version of the block, NULL while it is interpreted.
+    NativeBlock native;
+
+    /// @brief Length operations plus a BLOCK_END when the block does not end in a branch or jump, or a
+    /// BLOCK_BRANCH_END after a delay slot.
+    BlockOperation operations[];
+};
+
+struct BlockCache
+{
+    /// @brief Translated block starting at every address, indexed like the instructions of the program.
+    Block **blocks;
+
+    /// @brief Amount of addresses blocks has room for.
+    unsigned int capacity;
+
+    /// @brief Owns every translated block, so dropping them all is a single reset.
+    Arena arena;
+
+    /// @brief Native code of the compiled blocks.
+    JitBuffer jit;
+
+    /// @brief Every operation is one of the BLOCK_RECORD handlers, and none of them are fused.
+    bool recording;
+
+    /// @brief Blocks that end in a branch or jump also cover its delay slot.
+    bool delay_slots;
+};
+
+Block *translate_block(BlockCache *cache, const Instruction *instructions, unsigned int length, unsigned int base,
+                       unsigned int program_counter, const void *const *handlers);
+void flush_blocks(BlockCache *cache);
+unsigned int measure_block(const Instruction *instructions, unsigned int length, unsigned int first, bool delay_slots);
+bool ends_block(uint8_t opcode);
+void free_blocks(BlockCache *cache);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "memory.h"
+
+#define REGISTER_COUNT 32
+
+#define REGISTER_ZERO 0
+#define REGISTER_V0 2
+#define REGISTER_A0 4
+#define REGISTER_A1 5
+#define REGISTER_GP 28
+#define REGISTER_SP 29
+#define REGISTER_RA 31
+
+// Exception codes of the Cause register
+#define EXCEPTION_ADDRESS_LOAD 4
+#define EXCEPTION_ADDRESS_STORE 5
+#define EXCEPTION_RESERVED 10
+#define EXCEPTION_OVERFLOW 12
+
+#define CAUSE_CODE_SHIFT 2
+
+/// @brief Set in Cause when the exception was taken in a delay slot, with EPC at its branch.
+#define CAUSE_BRANCH_DELAY 0x80000000u
+
+typedef struct Cop0 Cop0;
+typedef struct CPU CPU;
+
+/// @brief The coprocessor 0 registers that describe the last exception.
+///
+/// There is no kernel to handle exceptions, so one stops execution at the instruction that raised it
+/// and these say why, as MARS does when a program has no handler.
+struct Cop0
+{
+    /// @brief BadVAddr, the address an address error was raised for.
+    uint32_t bad_address;
+
+    /// @brief Cause, with the exception code in bits 6 to 2 and CAUSE_BRANCH_DELAY.
+    uint32_t cause;
+
+    /// @brief EPC, the instruction that raised the exception or the branch before it.
+    uint32_t epc;
+};
+
+struct CPU
+{
+    unsigned int program_counter;
+
+    /// @brief General purpose registers, indexed by their architectural number.
+    uint32_t gpr[REGISTER_COUNT];
+
+    /// @brief High word of multiplication and remainder of division results.
+    uint32_t hi;
+
+    /// @brief Low word of multiplication and quotient of division results.
+    uint32_t lo;
+
+    /// @brief Instructions executed so far.
+    uint64_t instructions;
+
+    /// @brief End of the heap that sbrk grows, 0 until the first call starts it at HEAP_BASE.
+    uint32_t heap_break;
+
+    /// @brief The program asked to exit through a syscall, with exit_status.
+    bool exited;
+    uint32_t exit_status;
+
+    Cop0 cop0;
+
+    Memory memory;
+};
+
+/// @brief Assembly name of every register, indexed by its architectural number.
+extern const char *const REGISTER_NAMES[REGISTER_COUNT];
+
+void print_registers(const CPU *cpu, FILE *output);
+void raise_exception(CPU *cpu, uint8_t code, uint32_t program_counter, bool delay_slot, uint32_t bad_address);
+void print_exception(const CPU *cpu, FILE *output);
+
+#endif
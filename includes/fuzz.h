@@ -0,0 +1,137 @@
+#ifndef FUZZ_H
+#define FUZZ_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "cpu.h"
+#include "instruction.h"
+#include "interpreter.h"
+#include "program.h"
+#include "undo.h"
+
+// Generated programs hold between FUZZ_MIN_LENGTH and FUZZ_MAX_LENGTH instructions
+#define FUZZ_MIN_LENGTH 4
+#define FUZZ_MAX_LENGTH 48
+
+/// @brief Instructions a program may execute before it is cut short, as backward branches often loop forever.
+#define FUZZ_INSTRUCTION_LIMIT 2048
+
+/// @brief Bytes of random data around each of $gp and $sp, which loads and stores go to.
+#define FUZZ_DATA_SIZE 512
+
+// Loads and stores reach FUZZ_OFFSET_RANGE bytes from their base, before or after it
+#define FUZZ_OFFSET_RANGE 128
+
+#define FUZZ_GLOBAL_POINTER 0x10008000
+#define FUZZ_STACK_POINTER 0x7FFFEFFC
+
+typedef enum FuzzEngine FuzzEngine;
+typedef struct FuzzCase FuzzCase;
+typedef struct FuzzState FuzzState;
+typedef struct Divergence Divergence;
+typedef struct Fuzzer Fuzzer;
+typedef struct FuzzWorker FuzzWorker;
+
+/// @brief The ways a program can be executed, all of which have to agree.
+enum FuzzEngine
+{
+    /// @brief Every instruction through its own handler, as blocks that record an undo log run them,
+    /// with nothing fused or compiled, which makes it the reference for the others.
+    FUZZ_UNFUSED,
+
+    /// @brief Threaded handlers with superinstructions, as programs normally run before the JIT takes over.
+    FUZZ_INTERPRETER,
+
+    /// @brief Blocks compiled to native code the first time they run.
+    FUZZ_JIT,
+
+    FUZZ_ENGINES,
+};
+
+/// @brief A generated program and the state it starts from, all of it derived from its seed.
+struct FuzzCase
+{
+    uint64_t seed;
+    bool delay_slots;
+    unsigned int length;
+    Instruction instructions[FUZZ_MAX_LENGTH];
+    uint32_t gpr[REGISTER_COUNT];
+    uint32_t hi;
+    uint32_t lo;
+
+    // What the data around $gp and $sp starts with
+    uint8_t global_data[FUZZ_DATA_SIZE];
+    uint8_t stack_data[FUZZ_DATA_SIZE];
+};
+
+/// @brief What is compared between engines after every block.
+struct FuzzState
+{
+    unsigned int program_counter;
+    uint32_t gpr[REGISTER_COUNT];
+    uint32_t hi;
+    uint32_t lo;
+    uint64_t instructions;
+    uint32_t heap_break;
+    bool exited;
+    uint32_t exit_status;
+
+    /// @brief Whether the engine stopped at the instruction limit instead of running off or faulting.
+    bool paused;
+
+    uint8_t fault;
+    uint32_t fault_address;
+
+    /// @brief Coprocessor 0, which tells which exception stopped the program, and where.
+    Cop0 cop0;
+
+    /// @brief Hash of the pages written since the previous comparison, along with their page numbers.
+    uint64_t memory_hash;
+};
+
+/// @brief The first difference found between the reference and another engine.
+struct Divergence
+{
+    FuzzEngine engine;
+
+    /// @brief Instructions the reference had executed when the states were compared.
+    uint64_t instructions;
+
+    FuzzState expected;
+    FuzzState found;
+};
+
+/// @brief State shared by the workers, which only change the counters and the report, under lock.
+struct Fuzzer
+{
+    uint64_t seed;
+    uint64_t count;
+    unsigned int worker_count;
+
+    pthread_mutex_t lock;
+    uint64_t executed;
+    uint64_t instructions;
+
+    /// @brief Set once a divergence is reported, which stops every worker.
+    bool diverged;
+};
+
+/// @brief A CPU and a program for each engine, reused from one case to the next.
+struct FuzzWorker
+{
+    Fuzzer *fuzzer;
+    unsigned int index;
+    CPU cpus[FUZZ_ENGINES];
+    Program programs[FUZZ_ENGINES];
+    UndoLog undo;
+
+    /// @brief Receives the errors engines print when a program faults, which are not compared.
+    FILE *output;
+};
+
+int run_fuzz(uint64_t count, uint64_t seed, unsigned int threads);
+
+#endif
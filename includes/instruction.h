@@ -0,0 +1,125 @@
+#ifndef INSTRUCTION_H
+#define INSTRUCTION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "source.h"
+
+#define INSTRUCTION_ARGS 3
+
+typedef enum Opcode Opcode;
+typedef struct Instruction Instruction;
+
+enum Opcode
+{
+    /// @brief Address that holds no instruction yet.
+    OPCODE_EMPTY,
+    OPCODE_ADD,
+    OPCODE_ADDU,
+    OPCODE_ADDI,
+    OPCODE_SUB,
+    OPCODE_SUBU,
+    OPCODE_J,
+    OPCODE_MULT,
+    OPCODE_AND,
+    OPCODE_OR,
+    OPCODE_ANDI,
+    OPCODE_ORI,
+    OPCODE_BEQ,
+    OPCODE_BNE,
+    OPCODE_BLEZ,
+    OPCODE_BGTZ,
+    OPCODE_JAL,
+    OPCODE_JR,
+    OPCODE_NOP,
+    OPCODE_LB,
+    OPCODE_LBU,
+    OPCODE_LH,
+    OPCODE_LHU,
+    OPCODE_LW,
+    OPCODE_SB,
+    OPCODE_SH,
+    OPCODE_SW,
+    OPCODE_MUL,
+    OPCODE_MULTU,
+    OPCODE_DIV,
+    OPCODE_DIVU,
+    OPCODE_MADD,
+    OPCODE_MADDU,
+    OPCODE_MSUB,
+    OPCODE_MSUBU,
+    OPCODE_MFHI,
+    OPCODE_MFLO,
+    OPCODE_MTHI,
+    OPCODE_MTLO,
+    OPCODE_XOR,
+    OPCODE_NOR,
+    OPCODE_SLT,
+    OPCODE_SLTU,
+    OPCODE_MOVZ,
+    OPCODE_MOVN,
+    OPCODE_SLL,
+    OPCODE_SRL,
+    OPCODE_SRA,
+    OPCODE_SLLV,
+    OPCODE_SRLV,
+    OPCODE_SRAV,
+    OPCODE_CLZ,
+    OPCODE_CLO,
+    OPCODE_ADDIU,
+    OPCODE_SLTI,
+    OPCODE_SLTIU,
+    OPCODE_XORI,
+    OPCODE_LUI,
+    OPCODE_BLTZ,
+    OPCODE_BGEZ,
+    OPCODE_BLTZAL,
+    OPCODE_BGEZAL,
+    OPCODE_JALR,
+    OPCODE_LWL,
+    OPCODE_LWR,
+    OPCODE_SWL,
+    OPCODE_SWR,
+    OPCODE_SYSCALL,
+
+    /// @brief Word that no instruction has, kept in immediate, which raises a reserved instruction exception.
+    OPCODE_RESERVED,
+    OPCODE_COUNT
+};
+
+/// @brief An instruction decoded once from its source, so executing it never touches strings.
+///
+/// Registers keep the order they were written in: R instructions are "rd, rs, rt", I instructions
+/// are "rt, rs, immediate", branches are "rs, rt, address" and loads and stores are
+/// "rt, immediate(rs)". Shifts are "rd, rt, immediate" or "rd, rt, rs", with the amount in
+/// immediate, and MULT, DIV and the rest that only use HI and LO are "rs, rt".
+struct Instruction
+{
+    /// @brief One of Opcode.
+    uint8_t opcode;
+
+    /// @brief Destination register of R instructions.
+    uint8_t rd;
+
+    /// @brief First source register.
+    uint8_t rs;
+
+    /// @brief Second source register, or the destination of I instructions.
+    uint8_t rt;
+
+    /// @brief Immediate value, or the target address of branches and jumps.
+    int32_t immediate;
+};
+
+bool decode_instruction(Slice line, Instruction *instruction, Slice *symbol, FILE *output);
+bool decode_word(uint32_t word, uint32_t program_counter, Instruction *instruction);
+bool encode_instruction(const Instruction *instruction, uint32_t program_counter, uint32_t *word);
+const char *opcode_name(uint8_t opcode);
+int disassemble_instruction(const Instruction *instruction, char *buffer, size_t size);
+
+bool is_label(const char *word, size_t length);
+
+#endif
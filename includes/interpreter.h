@@ -0,0 +1,85 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "cpu.h"
+#include "instruction.h"
+#include "pipeline.h"
+#include "profile.h"
+#include "program.h"
+#include "syscall.h"
+#include "trace.h"
+#include "undo.h"
+
+#define DEFAULT_JIT_THRESHOLD 50
+
+typedef enum DelaySlots DelaySlots;
+typedef struct Options Options;
+
+enum DelaySlots
+{
+    /// @brief Only ELF executables have delay slots, which compilers fill, while assembly and ".bin" images
+    /// run as on SPIM and MARS.
+    DELAY_SLOTS_AUTO,
+    DELAY_SLOTS_ON,
+    DELAY_SLOTS_OFF,
+};
+
+struct Options
+{
+    /// @brief Where errors and reports about the program are written to.
+    FILE *output;
+
+    /// @brief Receives every executed instruction, NULL when nothing is traced.
+    Trace *trace;
+
+    /// @brief Counts what the program executes, NULL when it is not profiled.
+    Profile *profile;
+
+    /// @brief Works out the cycles the executed instructions take on a 5-stage pipeline, NULL when it is not timed.
+    Pipeline *pipeline;
+
+    /// @brief Records what every instruction overwrites, so execution can go backwards, NULL for no history.
+    UndoLog *undo;
+
+    /// @brief Takes what the program prints through syscalls and hands it what it reads, NULL drops the
+    /// output and leaves it without input.
+    Console *console;
+
+    /// @brief Times a block is interpreted before it is compiled to native code, 0 never compiles.
+    unsigned int jit_threshold;
+
+    /// @brief Raw ".bin" images hold little endian words instead of big endian ones.
+    bool little_endian;
+
+    /// @brief Whether branches and jumps of the loaded programs take effect after their delay slot.
+    DelaySlots delay_slots;
+
+    /// @brief Reports the instructions executed, the time taken and the peak memory use of a program.
+    bool statistics;
+
+    /// @brief Execution pauses at the first block boundary once CPU.instructions reaches it, 0 for never.
+    uint64_t instruction_limit;
+
+    /// @brief Snapshots applied in order once the program is loaded, each on top of the previous one.
+    const char *const *restore_paths;
+    unsigned int restore_count;
+
+    /// @brief Where a full snapshot is written when the program stops, NULL for nowhere.
+    const char *snapshot_path;
+
+    /// @brief Writes a snapshot to checkpoint_prefix.N every this many instructions, 0 for never.
+    ///
+    /// The first checkpoint is full and the following ones are incremental.
+    uint64_t checkpoint_interval;
+    const char *checkpoint_prefix;
+};
+
+bool run_program(CPU *cpu, Program *program, const Options *options);
+bool seek_instruction(CPU *cpu, Program *program, const Options *options, uint64_t instructions);
+bool reverse_to(CPU *cpu, Program *program, const Options *options, unsigned int address);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu.h"
+
+#define JIT_BUFFER_SIZE (4 * 1024 * 1024)
+
+typedef struct Block Block;
+typedef struct JitExit JitExit;
+typedef struct JitBuffer JitBuffer;
+
+/// @brief Where compiled code gave control back to the interpreter.
+struct JitExit
+{
+    /// @brief Address of the next instruction to execute.
+    uint32_t program_counter;
+
+    /// @brief Exit that can be linked to the compiled block at program_counter, NULL if its target varies.
+    uint8_t *link;
+};
+
+/// @brief JitExit.link of compiled code that stopped at an instruction that overflowed, which never retired.
+#define JIT_TRAP ((uint8_t *)1)
+
+/// @brief A block compiled to native code, called with the CPU it runs on and the CPU.instructions that
+/// bounded blocks stop at.
+typedef JitExit (*NativeBlock)(CPU *cpu, uint64_t limit);
+
+/// @brief Memory that compiled blocks are written to, one after the other, and run from once written.
+struct JitBuffer
+{
+    uint8_t *memory;
+    size_t size;
+    size_t used;
+
+    /// @brief Blocks are compiled to give control back when linked to once CPU.instructions reaches the limit.
+    bool bounded;
+};
+
+bool jit_compile(JitBuffer *buffer, Block *block);
+void jit_link(const JitBuffer *buffer, uint8_t *exit, NativeBlock target);
+void jit_reset(JitBuffer *buffer);
+void jit_free(JitBuffer *buffer);
+
+#endif
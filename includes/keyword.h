@@ -0,0 +1,60 @@
+#ifndef KEYWORD_H
+#define KEYWORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define KEYWORD_SLOTS 256
+#define KEYWORD_BUCKETS 64
+
+typedef enum KeywordKind KeywordKind;
+typedef struct Keyword Keyword;
+
+enum KeywordKind
+{
+    KEYWORD_MNEMONIC,
+    KEYWORD_REGISTER,
+};
+
+/// @brief A word of includes/keywords.def, as stored in the slot the perfect hash gives it.
+struct Keyword
+{
+    /// @brief The word itself, or NULL for a slot no keyword hashes to.
+    const char *name;
+    uint8_t length;
+
+    /// @brief One of KeywordKind.
+    uint8_t kind;
+
+    /// @brief Opcode of a mnemonic, or number of a register.
+    uint8_t value;
+};
+
+const Keyword *find_keyword(const char *word, size_t length);
+
+/// @brief 64-bit FNV-1a of the word, shared by find_keyword and the generator of its table.
+///
+/// FNV-1a alone leaves words that only differ in their last character, like "$1" and "$17", with
+/// close low bits, so the result goes through the finalizer of MurmurHash3 as well.
+static inline uint64_t hash_keyword(const char *word, size_t length)
+{
+    uint64_t hash = 0xCBF29CE484222325;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ (uint8_t)word[i]) * 0x100000001B3;
+    }
+
+    hash = (hash ^ hash >> 33) * 0xFF51AFD7ED558CCD;
+    hash = (hash ^ hash >> 33) * 0xC4CEB9FE1A85EC53;
+    return hash ^ hash >> 33;
+}
+
+/// @brief Slot of a word with the given hash, once its bucket has been displaced by seed.
+static inline unsigned int keyword_slot(uint64_t hash, uint8_t seed)
+{
+    uint32_t first = hash >> 32;
+    uint32_t step = (uint32_t)(hash >> 16) | 1;
+    return (first + seed * step) & (KEYWORD_SLOTS - 1);
+}
+
+#endif
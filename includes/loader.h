@@ -0,0 +1,16 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "cpu.h"
+#include "program.h"
+
+bool load_file(Program *program, CPU *cpu, const char *path, bool little_endian, FILE *output);
+bool load_elf(Program *program, CPU *cpu, const uint8_t *image, size_t size, FILE *output);
+bool load_words(Program *program, const uint8_t *words, size_t size, uint32_t base, bool little_endian, FILE *output);
+
+#endif
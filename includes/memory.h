@@ -0,0 +1,236 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define PAGE_BITS 12
+#define PAGE_SIZE (1u << PAGE_BITS)
+#define PAGE_MASK (PAGE_SIZE - 1)
+
+// The 20 bits of a page number are split evenly between the directory and its tables
+#define TABLE_BITS 10
+#define TABLE_SIZE (1u << TABLE_BITS)
+
+#define ARENA_PAGES 16
+
+typedef enum MemoryFault MemoryFault;
+typedef struct Memory Memory;
+typedef struct PageTable PageTable;
+typedef struct PageArena PageArena;
+typedef struct Mapping Mapping;
+
+/// @brief Why the last failed access failed.
+enum MemoryFault
+{
+    MEMORY_OK,
+    MEMORY_MISALIGNED,
+
+    /// @brief The page could not be allocated.
+    MEMORY_EXHAUSTED,
+};
+
+struct PageTable
+{
+    uint8_t *pages[TABLE_SIZE];
+
+    /// @brief Pages written since the last snapshot, one bit each.
+    uint32_t dirty[TABLE_SIZE / 32];
+};
+
+/// @brief A chunk of pages handed out one at a time, so touching a new page rarely allocates.
+struct PageArena
+{
+    PageArena *next;
+    unsigned int used;
+    uint8_t pages[ARENA_PAGES][PAGE_SIZE];
+};
+
+/// @brief A file mapped privately whose contents back some pages, such as a restored snapshot.
+struct Mapping
+{
+    Mapping *next;
+    void *address;
+    size_t size;
+};
+
+/// @brief Byte addressable 32-bit address space, where pages only exist once they are touched.
+///
+/// A zeroed Memory is empty and ready to use.
+struct Memory
+{
+    /// @brief Page number of cached_page plus one, so 0 means no page is cached.
+    uint32_t cached_tag;
+
+    /// @brief Last page accessed.
+    uint8_t *cached_page;
+
+    /// @brief Like cached_tag and cached_page, for the last page written, which is already marked dirty.
+    uint32_t written_tag;
+    uint8_t *written_page;
+
+    PageTable *directory[TABLE_SIZE];
+    PageArena *arena;
+    Mapping *mappings;
+
+    /// @brief Words are stored least significant byte first.
+    bool little_endian;
+
+    /// @brief Series and sequence of the last snapshot written or restored, so an incremental one only
+    /// applies right after the one before it, with a series of 0 when there is none.
+    uint64_t snapshot_series;
+    uint32_t snapshot_sequence;
+
+    /// @brief What made the last access fail and its address, kept for whoever reports it.
+    MemoryFault fault;
+    uint32_t fault_address;
+};
+
+uint8_t *find_page(Memory *memory, uint32_t address);
+uint8_t *find_written_page(Memory *memory, uint32_t address);
+bool map_page(Memory *memory, uint32_t page_number, uint8_t *data);
+void clean_pages(Memory *memory);
+uint32_t *list_pages(const Memory *memory, bool dirty, uint32_t *page_count);
+void misaligned_access(Memory *memory, uint32_t address);
+bool write_memory(Memory *memory, uint32_t address, const uint8_t *bytes, size_t length);
+void print_memory_fault(const Memory *memory, FILE *output);
+void free_memory(Memory *memory);
+
+/// @brief Host address of a guest byte, or NULL when its page could not be allocated.
+static inline uint8_t *translate_address(Memory *memory, uint32_t address)
+{
+    // Consecutive accesses mostly hit the same page, which costs a compare and an add
+    if ((address >> PAGE_BITS) + 1 == memory->cached_tag)
+    {
+        return memory->cached_page + (address & PAGE_MASK);
+    }
+
+    return find_page(memory, address);
+}
+
+/// @brief Host address of a guest byte about to be written, marking its page dirty.
+static inline uint8_t *translate_write(Memory *memory, uint32_t address)
+{
+    if ((address >> PAGE_BITS) + 1 == memory->written_tag)
+    {
+        return memory->written_page + (address & PAGE_MASK);
+    }
+
+    return find_written_page(memory, address);
+}
+
+static inline bool is_dirty(const PageTable *table, unsigned int index)
+{
+    return (table->dirty[index / 32] >> (index % 32)) & 1;
+}
+
+static inline bool load_word(Memory *memory, uint32_t address, uint32_t *value)
+{
+    if ((address & 3) != 0)
+    {
+        misaligned_access(memory, address);
+        return false;
+    }
+
+    const uint8_t *bytes = translate_address(memory, address);
+    if (bytes == NULL)
+    {
+        return false;
+    }
+
+    if (memory->little_endian)
+    {
+        *value = (uint32_t)bytes[3] << 24 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[1] << 8 | bytes[0];
+    }
+    else
+    {
+        *value = (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 8 | bytes[3];
+    }
+    return true;
+}
+
+static inline bool load_half(Memory *memory, uint32_t address, uint16_t *value)
+{
+    if ((address & 1) != 0)
+    {
+        misaligned_access(memory, address);
+        return false;
+    }
+
+    const uint8_t *bytes = translate_address(memory, address);
+    if (bytes == NULL)
+    {
+        return false;
+    }
+
+    *value = memory->little_endian ? bytes[1] << 8 | bytes[0] : bytes[0] << 8 | bytes[1];
+    return true;
+}
+
+static inline bool load_byte(Memory *memory, uint32_t address, uint8_t *value)
+{
+    const uint8_t *bytes = translate_address(memory, address);
+    if (bytes == NULL)
+    {
+        return false;
+    }
+
+    *value = bytes[0];
+    return true;
+}
+
+static inline bool store_word(Memory *memory, uint32_t address, uint32_t value)
+{
+    if ((address & 3) != 0)
+    {
+        misaligned_access(memory, address);
+        return false;
+    }
+
+    uint8_t *bytes = translate_write(memory, address);
+    if (bytes == NULL)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        bytes[memory->little_endian ? i : 3 - i] = value >> (8 * i);
+    }
+    return true;
+}
+
+static inline bool store_half(Memory *memory, uint32_t address, uint16_t value)
+{
+    if ((address & 1) != 0)
+    {
+        misaligned_access(memory, address);
+        return false;
+    }
+
+    uint8_t *bytes = translate_write(memory, address);
+    if (bytes == NULL)
+    {
+        return false;
+    }
+
+    bytes[memory->little_endian ? 0 : 1] = value;
+    bytes[memory->little_endian ? 1 : 0] = value >> 8;
+    return true;
+}
+
+static inline bool store_byte(Memory *memory, uint32_t address, uint8_t value)
+{
+    uint8_t *bytes = translate_write(memory, address);
+    if (bytes == NULL)
+    {
+        return false;
+    }
+
+    bytes[0] = value;
+    return true;
+}
+
+#endif
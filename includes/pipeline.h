@@ -0,0 +1,73 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "block.h"
+#include "cpu.h"
+
+/// @brief Cycles lost by a taken branch or a jump, whose target is only known once it leaves ID.
+#define PIPELINE_BRANCH_PENALTY 1
+
+typedef struct Pipeline Pipeline;
+
+/// @brief Timing of the executed instructions on a classic 5-stage pipeline, kept apart from execution.
+///
+/// Cycles are counted by the cycle every instruction spends in ID, where it waits for its operands.
+struct Pipeline
+{
+    /// @brief Cycle the next instruction gets to ID in, unless it has to stall there.
+    uint64_t cycle;
+
+    /// @brief First cycle the value of every register can be forwarded in.
+    uint64_t ready[REGISTER_COUNT];
+
+    /// @brief Cycle the last value of every register is written back to the register file in.
+    uint64_t written[REGISTER_COUNT];
+
+    uint64_t instructions;
+
+    /// @brief Operands taken from a later stage because their register was not written back yet.
+    uint64_t forwarded;
+
+    /// @brief Cycles, and the times it happened, an instruction waited on a load right before it.
+    uint64_t load_stalls;
+    uint64_t load_hazards;
+
+    /// @brief Cycles, and the times it happened, a branch or JR waited on its operands in ID.
+    uint64_t branch_stalls;
+    uint64_t branch_hazards;
+
+    /// @brief Cycles lost to the instruction fetched after taken branches and jumps, and how many there were.
+    uint64_t flush_cycles;
+    uint64_t flushes;
+
+    /// @brief Block entered last, timed once the next one tells where it went, NULL outside of run_program.
+    const Block *pending;
+};
+
+void time_block(Pipeline *pipeline, const Block *block, unsigned int count, unsigned int next);
+void print_pipeline(const Pipeline *pipeline, FILE *output);
+
+static inline void enter_pipeline(Pipeline *pipeline, const Block *block)
+{
+    if (pipeline->pending != NULL)
+    {
+        time_block(pipeline, pipeline->pending, pipeline->pending->length, block->start);
+    }
+    pipeline->pending = block;
+}
+
+/// @brief Times the last block entered, once execution stops at next.
+static inline void leave_pipeline(Pipeline *pipeline, unsigned int next)
+{
+    if (pipeline->pending != NULL)
+    {
+        time_block(pipeline, pipeline->pending, pipeline->pending->length, next);
+        pipeline->pending = NULL;
+    }
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "program.h"
+
+#define PROFILE_HOT_SPOTS 20
+#define PROFILE_INITIAL_NODES 64
+#define PROFILE_INITIAL_FRAMES 64
+
+typedef struct CallNode CallNode;
+typedef struct CallFrame CallFrame;
+typedef struct Profile Profile;
+
+/// @brief A function reached through one particular chain of calls.
+struct CallNode
+{
+    /// @brief Address the function was called at.
+    uint32_t function;
+
+    /// @brief Indexes of the caller, the first callee and the next callee of the caller, 0 for none.
+    unsigned int parent;
+    unsigned int child;
+    unsigned int sibling;
+
+    /// @brief Instructions executed inside the function itself, not its callees.
+    uint64_t instructions;
+};
+
+struct CallFrame
+{
+    unsigned int node;
+
+    /// @brief Address of the JAL that made the call.
+    uint32_t call_site;
+};
+
+/// @brief Execution counters of a program, gathered while it runs with profiling enabled.
+///
+/// Only block entries are counted while running: every instruction of a block runs once per entry,
+/// so per instruction and per opcode counts are worked out from them when the report is printed.
+struct Profile
+{
+    /// @brief Amount of instructions the arrays below have room for, indexed like the program.
+    unsigned int length;
+
+    /// @brief Times a block was entered at every address.
+    uint64_t *entries;
+
+    /// @brief Times the branch at every address was taken.
+    uint64_t *taken;
+
+    /// @brief Calling context tree, the root (index 0) being the code outside of any call.
+    CallNode *nodes;
+    unsigned int node_count;
+    unsigned int node_capacity;
+
+    /// @brief Calls not returned from yet, the top one being the function that is running.
+    CallFrame *frames;
+    unsigned int depth;
+    unsigned int frame_capacity;
+};
+
+bool reserve_profile(Profile *profile, unsigned int length, uint32_t entry);
+void profile_call(Profile *profile, uint32_t call_site, uint32_t target);
+void profile_return(Profile *profile, uint32_t target);
+void profile_delayed(Profile *profile, uint8_t opcode, unsigned int index, uint32_t address, uint32_t target, bool taken);
+void print_profile(const Profile *profile, const Program *program);
+bool write_folded_stacks(const Profile *profile, const char *path);
+void free_profile(Profile *profile);
+
+static inline void profile_block(Profile *profile, unsigned int index, unsigned int length)
+{
+    profile->entries[index]++;
+    profile->nodes[profile->frames[profile->depth - 1].node].instructions += length;
+}
+
+#endif
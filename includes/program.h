@@ -0,0 +1,48 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "arena.h"
+#include "block.h"
+#include "instruction.h"
+
+#define PROGRAM_INITIAL_CAPACITY 64
+
+// Most empty addresses a single instruction may leave before itself, as instructions are stored densely
+#define PROGRAM_MAX_GAP (1u << 20)
+
+typedef struct Program Program;
+
+struct Program
+{
+    /// @brief Address of the first stored instruction.
+    unsigned int base;
+
+    /// @brief Every stored instruction, already decoded, indexed by (program_counter - base) / 4.
+    Instruction *instructions;
+
+    /// @brief Amount of stored instructions.
+    unsigned int length;
+
+    /// @brief Amount of instructions that fit in instructions before growing it.
+    unsigned int capacity;
+
+    /// @brief Branches and jumps take effect after the instruction that follows them, their delay slot.
+    ///
+    /// Otherwise they take effect right away, as on SPIM and MARS, and link the address after themselves.
+    bool delay_slots;
+
+    /// @brief Blocks translated from instructions, dropped whenever a stored instruction changes.
+    BlockCache blocks;
+
+    /// @brief Owns instructions and everything the assembler builds while filling it.
+    Arena arena;
+};
+
+bool store_instruction(Program *program, unsigned int program_counter, Instruction instruction, FILE *output);
+void reset_program(Program *program);
+void free_program(Program *program);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "cpu.h"
+
+#define SNAPSHOT_MAGIC "MIPSSNAP"
+#define SNAPSHOT_VERSION 4
+#define SNAPSHOT_MAX_RESTORES 64
+
+typedef enum SnapshotFlag SnapshotFlag;
+typedef struct SnapshotHeader SnapshotHeader;
+
+enum SnapshotFlag
+{
+    /// @brief Only holds the pages written since the previous snapshot, and applies on top of it.
+    SNAPSHOT_INCREMENTAL = 1,
+
+    /// @brief Memory stores words least significant byte first.
+    SNAPSHOT_LITTLE_ENDIAN = 2,
+
+    /// @brief The program had exited, with exit_status.
+    SNAPSHOT_EXITED = 4,
+};
+
+/// @brief Start of a snapshot file, in host byte order.
+///
+/// The header is followed by page_count page numbers, then by the pages themselves, starting at the
+/// first multiple of PAGE_SIZE, so restoring maps them straight from the file.
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+
+    /// @brief Identifies the full snapshot a series of incremental ones builds on, and is shared by all of them.
+    uint64_t series;
+
+    /// @brief Position in the series, 0 for the full snapshot and one more for each incremental one after it.
+    uint32_t sequence;
+
+    uint32_t program_counter;
+    uint32_t gpr[REGISTER_COUNT];
+    uint32_t hi;
+    uint32_t lo;
+    uint32_t heap_break;
+    uint32_t exit_status;
+
+    /// @brief The last exception raised, kept after it stopped the program.
+    Cop0 cop0;
+
+    uint32_t page_count;
+    uint64_t instructions;
+};
+
+bool write_snapshot(CPU *cpu, const char *path, bool incremental, FILE *output);
+bool restore_snapshot(CPU *cpu, const char *path, FILE *output);
+
+#endif
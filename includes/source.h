@@ -0,0 +1,57 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define SOURCE_BLOCK_SIZE (64 * 1024)
+
+typedef struct Slice Slice;
+typedef struct Source Source;
+
+/// @brief Characters of a text that is owned by someone else and is not NUL terminated.
+struct Slice
+{
+    const char *start;
+    size_t length;
+};
+
+/// @brief Text read one line at a time, either all in memory or from a descriptor in large blocks.
+struct Source
+{
+    const char *text;
+    size_t size;
+
+    /// @brief Offset in text of the next line.
+    size_t position;
+
+    /// @brief Number of the last line returned, counting from 1.
+    unsigned int line_number;
+
+    /// @brief Where more text comes from, or -1 when all of it is in text already.
+    int descriptor;
+
+    /// @brief Owned buffer text points to while reading a descriptor.
+    char *buffer;
+    size_t capacity;
+
+    /// @brief Whether text is a mapping of a file, unmapped when the source is closed.
+    bool mapped;
+};
+
+bool open_source(Source *source, const char *path, FILE *output);
+void open_text(Source *source, const char *text, size_t size);
+void open_stream(Source *source, int descriptor);
+bool next_line(Source *source, Slice *line);
+void close_source(Source *source);
+
+Slice trim_slice(Slice slice);
+Slice next_word(Slice *rest);
+Slice split_slice(Slice *rest, char separator);
+bool slice_equals(Slice slice, const char *string);
+bool parse_integer(Slice slice, int64_t minimum, int64_t maximum, int64_t *value);
+bool is_whitespace(char character);
+
+#endif
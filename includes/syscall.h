@@ -0,0 +1,91 @@
+#ifndef SYSCALL_H
+#define SYSCALL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "cpu.h"
+#include "undo.h"
+
+#define CONSOLE_BUFFER_SIZE (64 * 1024)
+
+// Longest line read_int looks at, longer ones have the rest skipped
+#define CONSOLE_LINE_LENGTH 64
+
+/// @brief First address sbrk hands out, the same as MARS, unless the loader placed the heap after its data.
+#define HEAP_BASE 0x10040000
+
+typedef enum Syscall Syscall;
+typedef enum SyscallStatus SyscallStatus;
+typedef struct Console Console;
+
+/// @brief Services a program asks for with the number in $v0, numbered as on SPIM and MARS.
+enum Syscall
+{
+    /// @brief Prints $a0 as a signed decimal.
+    SYSCALL_PRINT_INT = 1,
+
+    /// @brief Prints the string that ends with a zero byte at the address in $a0.
+    SYSCALL_PRINT_STRING = 4,
+
+    /// @brief Reads a line and returns the decimal in it in $v0, 0 if there is none.
+    SYSCALL_READ_INT = 5,
+
+    /// @brief Reads up to $a1 - 1 bytes of a line into the address in $a0, ending them with a zero byte.
+    SYSCALL_READ_STRING = 8,
+
+    /// @brief Grows the heap by $a0 bytes, rounded up to a word, and returns where the new ones start in $v0.
+    SYSCALL_SBRK = 9,
+
+    SYSCALL_EXIT = 10,
+
+    /// @brief Prints the low byte of $a0.
+    SYSCALL_PRINT_CHAR = 11,
+
+    /// @brief Reads a byte and returns it in $v0, -1 at the end of the input.
+    SYSCALL_READ_CHAR = 12,
+
+    /// @brief Exits with the status in $a0.
+    SYSCALL_EXIT2 = 17,
+
+    // Only on MARS, which prints $a0 in hexadecimal as "0x" and 8 digits, in binary as 32 digits, or unsigned
+    SYSCALL_PRINT_HEX = 34,
+    SYSCALL_PRINT_BINARY = 35,
+    SYSCALL_PRINT_UNSIGNED = 36,
+};
+
+enum SyscallStatus
+{
+    SYSCALL_RETURNED,
+
+    /// @brief The program asked to exit, CPU.exited and CPU.exit_status are set.
+    SYSCALL_EXITED,
+
+    /// @brief The call is not supported, or it touched memory that could not be allocated.
+    SYSCALL_FAILED,
+};
+
+/// @brief What a program prints and reads through syscalls.
+///
+/// Output is buffered and written in bulk, when the buffer fills up, before the program reads, or on
+/// flush_console, so printing costs a copy instead of a write.
+struct Console
+{
+    FILE *output;
+
+    /// @brief Where reads come from, NULL when the program has no input and every read finds its end.
+    FILE *input;
+
+    char *buffer;
+    size_t used;
+};
+
+bool open_console(Console *console, FILE *output, FILE *input);
+SyscallStatus run_syscall(CPU *cpu, Console *console, UndoLog *undo);
+void print_syscall_fault(const CPU *cpu, FILE *output);
+void flush_console(Console *console);
+void close_console(Console *console);
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "instruction.h"
+
+#define TRACE_BUFFER_SIZE (1024 * 1024)
+#define TRACE_RECORDS 8192
+
+// Longest line a single traced instruction is formatted to
+#define TRACE_LINE_LENGTH 96
+
+// Machine word recorded for instructions that have no 32-bit encoding
+#define TRACE_NO_WORD 0xFFFFFFFF
+
+typedef enum TraceLevel TraceLevel;
+typedef struct TraceRecord TraceRecord;
+typedef struct Trace Trace;
+
+enum TraceLevel
+{
+    /// @brief No text is written.
+    TRACE_OFF,
+
+    /// @brief The fields of each executed machine word.
+    TRACE_WORDS,
+
+    /// @brief The address and assembly of each executed instruction.
+    TRACE_DISASSEMBLY,
+};
+
+/// @brief One executed instruction in a binary trace file, in host byte order.
+struct TraceRecord
+{
+    uint32_t program_counter;
+
+    /// @brief Machine word of the instruction, or TRACE_NO_WORD.
+    uint32_t word;
+};
+
+/// @brief Where executed instructions are written to, as text, as binary records or both.
+///
+/// Both outputs are buffered and written in bulk, when their buffer fills up or on flush_trace.
+struct Trace
+{
+    TraceLevel level;
+    FILE *output;
+    char *buffer;
+    size_t used;
+
+    /// @brief Binary trace file, or NULL.
+    FILE *binary;
+    TraceRecord *records;
+    size_t recorded;
+};
+
+bool open_trace(Trace *trace, TraceLevel level, FILE *output, const char *binary_path);
+void trace_instruction(Trace *trace, const Instruction *instruction, uint32_t program_counter);
+void flush_trace(Trace *trace);
+void close_trace(Trace *trace);
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef UNDO_H
+#define UNDO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cpu.h"
+
+#define UNDO_DEFAULT_CAPACITY (1u << 20)
+#define UNDO_CHECKPOINTS 8
+
+// Memory words are aligned, so the two low bits of a location tell it apart from a register
+#define UNDO_REGISTER(number) ((uint32_t)(number) << 2 | 1)
+#define UNDO_NOTHING 2
+#define UNDO_HI_LO 3
+#define UNDO_SYSCALL 6
+
+// Set in the value of a memory record written by the same instruction as the record before it
+#define UNDO_CONTINUED ((uint64_t)1 << 32)
+
+typedef struct UndoRecord UndoRecord;
+typedef struct Checkpoint Checkpoint;
+typedef struct UndoLog UndoLog;
+
+/// @brief What one executed instruction overwrote, and where it was.
+struct UndoRecord
+{
+    uint32_t program_counter;
+
+    /// @brief Address of the memory word, UNDO_REGISTER(number), UNDO_HI_LO, UNDO_SYSCALL or UNDO_NOTHING.
+    uint32_t location;
+
+    /// @brief Old value, which for UNDO_HI_LO holds HI in the upper half and LO in the lower one, and for
+    /// UNDO_SYSCALL the heap break and $v0. A memory word may also have UNDO_CONTINUED set.
+    uint64_t value;
+};
+
+/// @brief Copy of the whole CPU, which execution is replayed from once the records run out.
+struct Checkpoint
+{
+    uint32_t program_counter;
+    uint32_t gpr[REGISTER_COUNT];
+    uint32_t hi;
+    uint32_t lo;
+    uint32_t heap_break;
+    uint64_t instructions;
+    uint32_t page_count;
+    uint32_t *page_numbers;
+    uint8_t *pages;
+};
+
+/// @brief Bounded history of the instructions executed, so execution can go backwards.
+///
+/// Records live in a ring preallocated once, where the newest overwrite the oldest. Every interval
+/// instructions a checkpoint is taken as well, the last UNDO_CHECKPOINTS of them are kept, so going
+/// further back than the records reach replays at most interval instructions from one of them.
+struct UndoLog
+{
+    UndoRecord *records;
+
+    /// @brief Capacity of records minus one, which is a power of two.
+    uint32_t mask;
+
+    /// @brief Position of the next record, which only wraps around through mask.
+    uint64_t top;
+
+    /// @brief Records that can still be undone.
+    uint32_t available;
+
+    Checkpoint checkpoints[UNDO_CHECKPOINTS];
+    unsigned int oldest;
+    unsigned int checkpoint_count;
+
+    uint64_t interval;
+
+    /// @brief Value of CPU.instructions at which the next checkpoint is taken.
+    uint64_t next_checkpoint;
+};
+
+bool open_undo(UndoLog *undo, uint32_t capacity);
+void drop_undo(UndoLog *undo);
+bool undo_instruction(UndoLog *undo, CPU *cpu);
+void take_checkpoint(UndoLog *undo, CPU *cpu, uint32_t program_counter);
+bool restore_checkpoint(UndoLog *undo, CPU *cpu, uint64_t instructions);
+void forget_checkpoints(UndoLog *undo);
+void free_undo(UndoLog *undo);
+
+/// @brief Keeps the value about to be overwritten at location by the instruction at program_counter.
+static inline void record_undo(UndoLog *undo, uint32_t program_counter, uint32_t location, uint64_t value)
+{
+    UndoRecord *record = &undo->records[undo->top++ & undo->mask];
+    if (undo->available <= undo->mask)
+    {
+        undo->available++;
+    }
+
+    record->program_counter = program_counter;
+    record->location = location;
+    record->value = value;
+}
+
+/// @brief Keeps the word around the address a byte, half or word store is about to write.
+static inline void record_store(UndoLog *undo, Memory *memory, uint32_t address, uint32_t program_counter)
+{
+    uint32_t value;
+    if (!load_word(memory, address & ~3u, &value))
+    {
+        // The store fails as well, and drops the record
+        value = 0;
+    }
+
+    record_undo(undo, program_counter, address & ~3u, value);
+}
+
+/// @brief Keeps the word around address as well, for an instruction that writes more than one, such as a
+/// syscall that reads a string. The records go back together with the one the instruction made first.
+static inline void record_continued_store(UndoLog *undo, Memory *memory, uint32_t address)
+{
+    record_store(undo, memory, address, undo->records[(undo->top - 1) & undo->mask].program_counter);
+    undo->records[(undo->top - 1) & undo->mask].value |= UNDO_CONTINUED;
+}
+
+/// @brief Whether record belongs to the same instruction as the record before it.
+static inline bool continues_record(const UndoRecord *record)
+{
+    return (record->location & 3) == 0 && (record->value & UNDO_CONTINUED) != 0;
+}
+
+#endif
@@ -0,0 +1,112 @@
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+static size_t round_size(size_t size);
+
+/// @brief Allocates size bytes aligned for any type, or NULL when there is no memory left.
+void *arena_allocate(Arena *arena, size_t size)
+{
+    size = round_size(size);
+
+    ArenaChunk *chunk = arena->chunk;
+    if (chunk == NULL || chunk->size - chunk->used < size)
+    {
+        size_t chunk_size = chunk == NULL ? ARENA_CHUNK_SIZE : 2 * chunk->size;
+        while (chunk_size < size)
+        {
+            chunk_size *= 2;
+        }
+
+        chunk = malloc(sizeof(ArenaChunk) + chunk_size);
+        if (chunk == NULL)
+        {
+            return NULL;
+        }
+
+        chunk->previous = arena->chunk;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        arena->chunk = chunk;
+    }
+
+    void *allocation = (uint8_t *)chunk->data + chunk->used;
+    chunk->used += size;
+    arena->last = allocation;
+    return allocation;
+}
+
+/// @brief Resizes an allocation of size bytes to new_size, in place when it is the last one made.
+///
+/// Otherwise it is copied into a new allocation, and the old one is only given back with the rest.
+void *arena_grow(Arena *arena, void *allocation, size_t size, size_t new_size)
+{
+    ArenaChunk *chunk = arena->chunk;
+    if (allocation != NULL && allocation == arena->last)
+    {
+        size_t start = (uint8_t *)allocation - (uint8_t *)chunk->data;
+        if (chunk->size - start >= round_size(new_size))
+        {
+            chunk->used = start + round_size(new_size);
+            return allocation;
+        }
+    }
+
+    void *grown = arena_allocate(arena, new_size);
+    if (grown != NULL && allocation != NULL)
+    {
+        memcpy(grown, allocation, size < new_size ? size : new_size);
+    }
+
+    return grown;
+}
+
+/// @brief Copies the first length characters of string, with a terminating NUL.
+char *arena_copy(Arena *arena, const char *string, size_t length)
+{
+    char *copy = arena_allocate(arena, length + 1);
+    if (copy != NULL)
+    {
+        memcpy(copy, string, length);
+        copy[length] = '\0';
+    }
+
+    return copy;
+}
+
+/// @brief Gives back every allocation, keeping only the largest chunk for the ones that come next.
+void reset_arena(Arena *arena)
+{
+    ArenaChunk *chunk = arena->chunk;
+    if (chunk == NULL)
+    {
+        return;
+    }
+
+    ArenaChunk *previous = chunk->previous;
+    while (previous != NULL)
+    {
+        ArenaChunk *next = previous->previous;
+        free(previous);
+        previous = next;
+    }
+
+    chunk->previous = NULL;
+    chunk->used = 0;
+    arena->last = NULL;
+}
+
+void free_arena(Arena *arena)
+{
+    reset_arena(arena);
+    free(arena->chunk);
+    arena->chunk = NULL;
+}
+
+static size_t round_size(size_t size)
+{
+    return (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+}
@@ -0,0 +1,556 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "assembler.h"
+#include "instruction.h"
+#include "keyword.h"
+
+/*
+ * Sources are assembled in a single pass: each line is decoded as soon as it is read, instructions go
+ * straight into the program and data straight into memory. A label used before it is defined leaves
+ * its instruction or word at 0 and a fixup behind, and once the input ends every fixup is patched
+ * with the address its label ended up with, so the source is never read twice.
+ */
+
+static bool assemble_line(Assembler *assembler, Slice line);
+static bool assemble_directive(Assembler *assembler, Slice line);
+static bool emit_words(Assembler *assembler, Slice arguments);
+static bool emit_string(Assembler *assembler, Slice argument);
+static bool define_label(Assembler *assembler, const char *name, size_t length);
+static bool resolve_label(Assembler *assembler, Slice name, uint32_t address, bool data, int32_t *value);
+static uint32_t find_label(Assembler *assembler, const char *name, size_t length);
+static bool grow_labels(Assembler *assembler);
+static bool patch_fixups(Assembler *assembler);
+static bool parse_word(Slice argument, uint32_t *word);
+static bool flush_output(FILE *output, const uint8_t *buffer, size_t *used);
+
+/// @brief Assembles every line of input into program, and its .data into memory when it is not NULL.
+bool assemble_program(Program *program, Memory *memory, Source *input, FILE *output)
+{
+    Assembler assembler = {
+        .program = program,
+        .memory = memory,
+        .output = output,
+        .section = SECTION_TEXT,
+        .text_address = program->base,
+        .data_address = DATA_BASE,
+        .pending = LABEL_NONE,
+    };
+
+    Slice line;
+    bool assembled = true;
+
+    while (assembled && next_source_line(input, &line))
+    {
+        assembler.line_number = input->line_number;
+        assembled = assemble_line(&assembler, line);
+    }
+
+    return assembled && patch_fixups(&assembler);
+}
+
+/// @brief Assembles every line of input into a raw image of 32-bit words.
+///
+/// Words are collected in a buffer that is written out whenever it fills, instead of one write per
+/// instruction. The image starts at address 0, so it runs again when loaded as a ".bin" file, which
+/// has no room for a .data section.
+bool assemble_file(Source *input, FILE *output, bool little_endian)
+{
+    Program program = {0};
+    if (!assemble_program(&program, NULL, input, stdout))
+    {
+        free_program(&program);
+        return false;
+    }
+
+    uint8_t buffer[ASSEMBLER_BUFFER_SIZE];
+    size_t used = 0;
+
+    for (unsigned int i = 0; i < program.length; i++)
+    {
+        uint32_t program_counter = program.base + i * 4;
+
+        uint32_t word;
+        if (!encode_instruction(&program.instructions[i], program_counter, &word))
+        {
+            char assembly[64];
+            disassemble_instruction(&program.instructions[i], assembly, sizeof(assembly));
+            printf("ERRO: \"%s\", no endereço %u, não cabe em uma instrução de 32 bits\n", assembly, program_counter);
+            free_program(&program);
+            return false;
+        }
+
+        if (used == sizeof(buffer) && !flush_output(output, buffer, &used))
+        {
+            free_program(&program);
+            return false;
+        }
+
+        for (int b = 0; b < 4; b++)
+        {
+            int shift = little_endian ? 8 * b : 24 - 8 * b;
+            buffer[used++] = word >> shift;
+        }
+    }
+
+    free_program(&program);
+    return flush_output(output, buffer, &used) && fflush(output) == 0;
+}
+
+/// @brief Gets the next line that is part of the program, false once there are no more.
+bool next_source_line(Source *source, Slice *line)
+{
+    while (next_line(source, line))
+    {
+        // Blank lines and REPL commands do not take an address
+        if (line->length == 0 || slice_equals(*line, "HELP") || slice_equals(*line, "DEBUG"))
+        {
+            continue;
+        }
+
+        // Nothing after EXIT is part of the program
+        return !slice_equals(*line, "EXIT");
+    }
+
+    return false;
+}
+
+/// @brief Assembles "[label:]... [instruction|directive]".
+static bool assemble_line(Assembler *assembler, Slice line)
+{
+    while (true)
+    {
+        size_t length = 0;
+        while (length < line.length && line.start[length] != ':' && !is_whitespace(line.start[length]))
+        {
+            length++;
+        }
+
+        if (length == line.length || line.start[length] != ':' || !is_label(line.start, length))
+        {
+            break;
+        }
+
+        if (!define_label(assembler, line.start, length))
+        {
+            return false;
+        }
+        line = trim_slice((Slice){line.start + length + 1, line.length - length - 1});
+    }
+
+    if (line.length == 0)
+    {
+        return true;
+    }
+
+    if (line.start[0] == '.')
+    {
+        return assemble_directive(assembler, line);
+    }
+
+    if (assembler->section != SECTION_TEXT)
+    {
+        fprintf(assembler->output, "ERRO: Linha %u: instruções só podem ficar na seção .text\n", assembler->line_number);
+        return false;
+    }
+
+    Instruction instruction;
+    Slice symbol;
+    if (!decode_instruction(line, &instruction, &symbol, assembler->output))
+    {
+        fprintf(assembler->output, "ERRO: Linha %u não pôde ser decodificada\n", assembler->line_number);
+        return false;
+    }
+
+    if (symbol.start != NULL && !resolve_label(assembler, symbol, assembler->text_address, false, &instruction.immediate))
+    {
+        return false;
+    }
+
+    if (!store_instruction(assembler->program, assembler->text_address, instruction, assembler->output))
+    {
+        return false;
+    }
+
+    assembler->text_address += 4;
+    assembler->pending = LABEL_NONE;
+    return true;
+}
+
+/// @brief Assembles .text, .data, .word valores, .space bytes and .asciiz "texto".
+static bool assemble_directive(Assembler *assembler, Slice line)
+{
+    Slice arguments = line;
+    Slice directive = next_word(&arguments);
+    int length = directive.length;
+
+    bool text = slice_equals(directive, ".text");
+    bool data = slice_equals(directive, ".data");
+    if (text || data)
+    {
+        if (arguments.length != 0)
+        {
+            fprintf(assembler->output, "ERRO: Linha %u: %.*s não recebe argumentos\n", assembler->line_number, length,
+                    directive.start);
+            return false;
+        }
+
+        if (data && assembler->memory == NULL)
+        {
+            fprintf(assembler->output, "ERRO: Linha %u: a seção .data não cabe em um arquivo .bin\n", assembler->line_number);
+            return false;
+        }
+
+        assembler->section = text ? SECTION_TEXT : SECTION_DATA;
+        assembler->pending = LABEL_NONE;
+        return true;
+    }
+
+    bool word = slice_equals(directive, ".word");
+    bool space = slice_equals(directive, ".space");
+    bool string = slice_equals(directive, ".asciiz");
+    if (!word && !space && !string)
+    {
+        fprintf(assembler->output, "ERRO: Linha %u: \"%.*s\" não é uma diretiva válida\n", assembler->line_number, length,
+                directive.start);
+        return false;
+    }
+
+    if (assembler->section != SECTION_DATA)
+    {
+        fprintf(assembler->output, "ERRO: Linha %u: %.*s só pode ficar na seção .data\n", assembler->line_number, length,
+                directive.start);
+        return false;
+    }
+
+    if (word)
+    {
+        return emit_words(assembler, arguments);
+    }
+
+    if (string)
+    {
+        return emit_string(assembler, arguments);
+    }
+
+    // Memory reads as zero until it is written, so reserving space only moves the address
+    uint32_t size;
+    if (!parse_word(arguments, &size) || (int32_t)size < 0)
+    {
+        fprintf(assembler->output, "ERRO: Linha %u: tamanho inválido \"%.*s\"\n", assembler->line_number,
+                (int)arguments.length, arguments.start);
+        return false;
+    }
+
+    assembler->data_address += size;
+    assembler->pending = LABEL_NONE;
+    return true;
+}
+
+/// @brief Stores each of the comma separated numbers or labels in a word, aligned to 4 bytes.
+static bool emit_words(Assembler *assembler, Slice arguments)
+{
+    // Labels right before the words name the first of them, so they are aligned along
+    uint32_t aligned = (assembler->data_address + 3) & ~3u;
+    for (uint32_t label = assembler->pending; label != LABEL_NONE; label = assembler->labels[label].next_pending)
+    {
+        assembler->labels[label].address = aligned;
+    }
+    assembler->data_address = aligned;
+
+    unsigned int count = 0;
+    while (arguments.start != NULL && arguments.length > 0)
+    {
+        Slice argument = split_slice(&arguments, ',');
+
+        uint32_t value;
+        if (is_label(argument.start, argument.length))
+        {
+            int32_t address;
+            if (!resolve_label(assembler, argument, assembler->data_address, true, &address))
+            {
+                return false;
+            }
+            value = address;
+        }
+        else if (!parse_word(argument, &value))
+        {
+            fprintf(assembler->output, "ERRO: Linha %u: palavra inválida \"%.*s\"\n", assembler->line_number,
+                    (int)argument.length, argument.start);
+            return false;
+        }
+
+        if (!store_word(assembler->memory, assembler->data_address, value))
+        {
+            print_memory_fault(assembler->memory, assembler->output);
+            return false;
+        }
+
+        assembler->data_address += 4;
+        assembler->pending = LABEL_NONE;
+        count++;
+    }
+
+    if (count == 0)
+    {
+        fprintf(assembler->output, "ERRO: Linha %u: .word precisa de ao menos um valor\n", assembler->line_number);
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief Stores a quoted string and the byte 0 after it, where \n, \t, \0, \\ and \" are escapes.
+static bool emit_string(Assembler *assembler, Slice argument)
+{
+    size_t length = argument.length;
+    const char *text = argument.start;
+    if (length < 2 || text[0] != '"' || text[length - 1] != '"')
+    {
+        fprintf(assembler->output, "ERRO: Linha %u: .asciiz espera um texto entre aspas\n", assembler->line_number);
+        return false;
+    }
+
+    for (size_t i = 1; i <= length - 1; i++)
+    {
+        uint8_t byte = text[i];
+        if (i == length - 1)
+        {
+            byte = '\0';
+        }
+        else if (byte == '"')
+        {
+            fprintf(assembler->output, "ERRO: Linha %u: aspas dentro do texto precisam ser escritas como \\\"\n",
+                    assembler->line_number);
+            return false;
+        }
+        else if (byte == '\\')
+        {
+            switch (i + 1 < length - 1 ? text[++i] : '\0')
+            {
+            case 'n':
+                byte = '\n';
+                break;
+            case 't':
+                byte = '\t';
+                break;
+            case '0':
+                byte = '\0';
+                break;
+            case '\\':
+            case '"':
+                byte = text[i];
+                break;
+            default:
+                fprintf(assembler->output, "ERRO: Linha %u: sequência de escape inválida\n", assembler->line_number);
+                return false;
+            }
+        }
+
+        if (!store_byte(assembler->memory, assembler->data_address, byte))
+        {
+            print_memory_fault(assembler->memory, assembler->output);
+            return false;
+        }
+        assembler->data_address++;
+    }
+
+    assembler->pending = LABEL_NONE;
+    return true;
+}
+
+/// @brief Gives the label the current address of the section it is in.
+static bool define_label(Assembler *assembler, const char *name, size_t length)
+{
+    uint32_t index = find_label(assembler, name, length);
+    if (index == LABEL_NONE)
+    {
+        return false;
+    }
+
+    Label *label = &assembler->labels[index];
+    if (label->defined)
+    {
+        fprintf(assembler->output, "ERRO: Linha %u: o rótulo \"%s\" já foi definido\n", assembler->line_number, label->name);
+        return false;
+    }
+
+    label->defined = true;
+    label->address = assembler->section == SECTION_TEXT ? assembler->text_address : assembler->data_address;
+    label->next_pending = assembler->pending;
+    assembler->pending = index;
+    return true;
+}
+
+/// @brief Sets value to the address of the label, or to 0 and a fixup at address if it comes later.
+static bool resolve_label(Assembler *assembler, Slice name, uint32_t address, bool data, int32_t *value)
+{
+    uint32_t index = find_label(assembler, name.start, name.length);
+    if (index == LABEL_NONE)
+    {
+        return false;
+    }
+
+    if (assembler->labels[index].defined)
+    {
+        *value = assembler->labels[index].address;
+        return true;
+    }
+
+    if (assembler->fixup_count == assembler->fixup_capacity)
+    {
+        size_t capacity = assembler->fixup_capacity == 0 ? LABELS_INITIAL_CAPACITY : assembler->fixup_capacity * 2;
+        Fixup *fixups = arena_grow(&assembler->program->arena, assembler->fixups,
+                                   assembler->fixup_capacity * sizeof(*fixups), capacity * sizeof(*fixups));
+        if (fixups == NULL)
+        {
+            fprintf(assembler->output, "ERRO: Memória insuficiente para montar o programa\n");
+            return false;
+        }
+
+        assembler->fixups = fixups;
+        assembler->fixup_capacity = capacity;
+    }
+
+    assembler->fixups[assembler->fixup_count++] = (Fixup){
+        .address = address,
+        .label = index,
+        .line_number = assembler->line_number,
+        .data = data,
+    };
+
+    *value = 0;
+    return true;
+}
+
+/// @brief Index of the label with the given name, added undefined if it was never seen.
+///
+/// Returns LABEL_NONE when there is no memory left for it.
+static uint32_t find_label(Assembler *assembler, const char *name, size_t length)
+{
+    // Keeps the table at most half full, so probing stays short
+    if (2 * (assembler->label_count + 1) > assembler->slot_mask + 1 && !grow_labels(assembler))
+    {
+        fprintf(assembler->output, "ERRO: Memória insuficiente para montar o programa\n");
+        return LABEL_NONE;
+    }
+
+    uint32_t slot = hash_keyword(name, length) & assembler->slot_mask;
+    while (assembler->slots[slot] != 0)
+    {
+        const Label *label = &assembler->labels[assembler->slots[slot] - 1];
+        if (label->length == length && memcmp(label->name, name, length) == 0)
+        {
+            return assembler->slots[slot] - 1;
+        }
+
+        slot = (slot + 1) & assembler->slot_mask;
+    }
+
+    char *copy = arena_copy(&assembler->program->arena, name, length);
+    if (copy == NULL)
+    {
+        fprintf(assembler->output, "ERRO: Memória insuficiente para montar o programa\n");
+        return LABEL_NONE;
+    }
+
+    uint32_t index = assembler->label_count++;
+    assembler->labels[index] = (Label){.name = copy, .length = length, .next_pending = LABEL_NONE};
+    assembler->slots[slot] = index + 1;
+    return index;
+}
+
+/// @brief Doubles the labels and their table, placing every label again in the larger one.
+///
+/// Like everything else the assembler allocates, the smaller ones stay in the arena of the program
+/// until it is reset.
+static bool grow_labels(Assembler *assembler)
+{
+    uint32_t capacity = assembler->label_capacity == 0 ? LABELS_INITIAL_CAPACITY : assembler->label_capacity * 2;
+
+    Arena *arena = &assembler->program->arena;
+
+    Label *labels = arena_grow(arena, assembler->labels, assembler->label_capacity * sizeof(*labels),
+                               capacity * sizeof(*labels));
+    if (labels == NULL)
+    {
+        return false;
+    }
+    assembler->labels = labels;
+
+    uint32_t *slots = arena_allocate(arena, 2 * capacity * sizeof(*slots));
+    if (slots == NULL)
+    {
+        return false;
+    }
+
+    memset(slots, 0, 2 * capacity * sizeof(*slots));
+    assembler->slots = slots;
+    assembler->slot_mask = 2 * capacity - 1;
+    assembler->label_capacity = capacity;
+
+    for (uint32_t i = 0; i < assembler->label_count; i++)
+    {
+        uint32_t slot = hash_keyword(labels[i].name, labels[i].length) & assembler->slot_mask;
+        while (slots[slot] != 0)
+        {
+            slot = (slot + 1) & assembler->slot_mask;
+        }
+        slots[slot] = i + 1;
+    }
+
+    return true;
+}
+
+/// @brief Writes the address of its label into every fixup, now that all labels are known.
+static bool patch_fixups(Assembler *assembler)
+{
+    for (size_t i = 0; i < assembler->fixup_count; i++)
+    {
+        const Fixup *fixup = &assembler->fixups[i];
+        const Label *label = &assembler->labels[fixup->label];
+
+        if (!label->defined)
+        {
+            fprintf(assembler->output, "ERRO: Linha %u: o rótulo \"%s\" não foi definido\n", fixup->line_number, label->name);
+            return false;
+        }
+
+        if (fixup->data)
+        {
+            store_word(assembler->memory, fixup->address, label->address);
+        }
+        else
+        {
+            Program *program = assembler->program;
+            program->instructions[(fixup->address - program->base) / 4].immediate = label->address;
+        }
+    }
+
+    return true;
+}
+
+/// @brief Parses a decimal word, which may be written signed or unsigned.
+static bool parse_word(Slice argument, uint32_t *word)
+{
+    int64_t value;
+    if (!parse_integer(argument, INT32_MIN, UINT32_MAX, &value))
+    {
+        return false;
+    }
+
+    *word = value;
+    return true;
+}
+
+static bool flush_output(FILE *output, const uint8_t *buffer, size_t *used)
+{
+    if (fwrite(buffer, 1, *used, output) != *used)
+    {
+        printf("ERRO: Não foi possível escrever o código montado\n");
+        return false;
+    }
+
+    *used = 0;
+    return true;
+}
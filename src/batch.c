@@ -0,0 +1,383 @@
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "loader.h"
+#include "snapshot.h"
+
+static bool run_checkpoints(CPU *cpu, Program *program, const Options *options, bool *paused);
+static void print_statistics(const CPU *cpu, double seconds);
+static bool list_directory(const char *directory, BatchJob **jobs, unsigned int *count);
+static void *run_worker(void *argument);
+static bool take_job(WorkQueue *queue, bool steal, unsigned int *job);
+static void run_job(const Batch *batch, BatchJob *job, Program *program);
+static int compare_jobs(const void *first, const void *second);
+
+/// @brief Loads and runs a single program, then prints its registers to options->output.
+int run_file(CPU *cpu, Program *program, const char *path, const Options *options)
+{
+    if (!load_file(program, cpu, path, options->little_endian, options->output))
+    {
+        return 1;
+    }
+
+    if (options->delay_slots != DELAY_SLOTS_AUTO)
+    {
+        program->delay_slots = options->delay_slots == DELAY_SLOTS_ON;
+    }
+
+    for (unsigned int i = 0; i < options->restore_count; i++)
+    {
+        if (!restore_snapshot(cpu, options->restore_paths[i], options->output))
+        {
+            return 1;
+        }
+    }
+
+    // A program restored after it exited has nothing left to run
+    bool paused = false;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool checkpointed = cpu->exited || run_checkpoints(cpu, program, options, &paused);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (!checkpointed || (options->snapshot_path != NULL && !write_snapshot(cpu, options->snapshot_path, false, options->output)))
+    {
+        return 1;
+    }
+
+    print_registers(cpu, options->output);
+
+    if (options->statistics)
+    {
+        print_statistics(cpu, (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+    }
+
+    // A program that exits fails with any status other than 0, which is not passed on as it is since a
+    // process status only keeps its low byte, so 256 would read as success. Otherwise stopping before its
+    // end means an instruction could not be executed, unless it was asked to pause there
+    if (cpu->exited)
+    {
+        return cpu->exit_status != 0 ? 1 : 0;
+    }
+    return !paused && (cpu->program_counter - program->base) / 4 < program->length ? 1 : 0;
+}
+
+/*
+ * Every file of the directory runs on its own CPU, in a pool of threads (one per core unless
+ * threads says otherwise). Jobs are split evenly between the workers up front; a worker that runs
+ * out steals from the others, so a few slow programs do not leave the remaining cores idle. Each
+ * job writes into its own memory stream, and the streams are printed in the order of the file
+ * names once every job is done.
+ */
+int run_directory(const char *directory, const Options *options, TraceLevel trace_level, unsigned int threads)
+{
+    BatchJob *jobs;
+    unsigned int count;
+    if (!list_directory(directory, &jobs, &count))
+    {
+        return 1;
+    }
+
+    if (threads == 0)
+    {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores > 0 ? cores : 1;
+    }
+    if (threads > count)
+    {
+        threads = count > 0 ? count : 1;
+    }
+
+    Batch batch = {
+        .jobs = jobs,
+        .queues = malloc(threads * sizeof(WorkQueue)),
+        .worker_count = threads,
+        .options = options,
+        .trace_level = trace_level,
+    };
+    Worker *workers = malloc(threads * sizeof(Worker));
+    pthread_t *handles = malloc(threads * sizeof(pthread_t));
+
+    if (batch.queues == NULL || workers == NULL || handles == NULL)
+    {
+        printf("ERRO: Memória insuficiente para executar o lote\n");
+        threads = 0;
+    }
+
+    for (unsigned int i = 0; i < threads; i++)
+    {
+        pthread_mutex_init(&batch.queues[i].lock, NULL);
+        batch.queues[i].top = (unsigned long)count * i / threads;
+        batch.queues[i].bottom = (unsigned long)count * (i + 1) / threads;
+        workers[i] = (Worker){&batch, i};
+    }
+
+    // The calling thread is the first worker
+    unsigned int started = 1;
+    while (started < threads && pthread_create(&handles[started], NULL, run_worker, &workers[started]) == 0)
+    {
+        started++;
+    }
+
+    if (threads > 0)
+    {
+        run_worker(&workers[0]);
+    }
+
+    for (unsigned int i = 1; i < started; i++)
+    {
+        pthread_join(handles[i], NULL);
+    }
+
+    unsigned int failed = 0;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        printf("==> %s <==\n", jobs[i].path);
+        fwrite(jobs[i].output, 1, jobs[i].output_length, stdout);
+        failed += jobs[i].status != 0;
+
+        free(jobs[i].path);
+        free(jobs[i].output);
+    }
+
+    printf("%u programas executados, %u com erro\n", count, failed);
+
+    for (unsigned int i = 0; i < threads; i++)
+    {
+        pthread_mutex_destroy(&batch.queues[i].lock);
+    }
+
+    free(jobs);
+    free(batch.queues);
+    free(workers);
+    free(handles);
+    return failed > 0 || threads == 0 ? 1 : 0;
+}
+
+/// @brief Runs the program, pausing to write a checkpoint every options->checkpoint_interval instructions.
+static bool run_checkpoints(CPU *cpu, Program *program, const Options *options, bool *paused)
+{
+    if (options->checkpoint_interval == 0)
+    {
+        *paused = run_program(cpu, program, options);
+        return true;
+    }
+
+    Options step = *options;
+    size_t length = strlen(options->checkpoint_prefix) + 16;
+    char *path = malloc(length);
+    if (path == NULL)
+    {
+        fprintf(options->output, "ERRO: Memória insuficiente para os checkpoints\n");
+        return false;
+    }
+
+    for (unsigned int checkpoint = 0; true; checkpoint++)
+    {
+        uint64_t limit = cpu->instructions + options->checkpoint_interval;
+        step.instruction_limit = options->instruction_limit != 0 && options->instruction_limit < limit
+                                     ? options->instruction_limit
+                                     : limit;
+
+        *paused = run_program(cpu, program, &step);
+
+        // Only the limit of the options ends the run, the interval just marks a checkpoint
+        if (!*paused || step.instruction_limit == options->instruction_limit)
+        {
+            free(path);
+            return true;
+        }
+
+        snprintf(path, length, "%s.%u", options->checkpoint_prefix, checkpoint);
+        if (!write_snapshot(cpu, path, checkpoint > 0, options->output))
+        {
+            free(path);
+            return false;
+        }
+    }
+}
+
+/// @brief Prints "key=value" pairs to stderr, so they are easy to parse and never mixed with the program output.
+static void print_statistics(const CPU *cpu, double seconds)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    double instructions = cpu->instructions;
+    fprintf(stderr, "ESTATISTICAS instrucoes=%llu segundos=%.6f mips=%.2f ns_por_instrucao=%.3f rss_kib=%ld\n",
+            (unsigned long long)cpu->instructions, seconds, seconds > 0 ? instructions / seconds / 1e6 : 0,
+            instructions > 0 ? seconds * 1e9 / instructions : 0, usage.ru_maxrss);
+}
+
+/// @brief Collects every regular file of the directory, sorted by name.
+static bool list_directory(const char *directory, BatchJob **jobs, unsigned int *count)
+{
+    DIR *stream = opendir(directory);
+    if (stream == NULL)
+    {
+        printf("ERRO: Não foi possível abrir o diretório \"%s\"\n", directory);
+        return false;
+    }
+
+    unsigned int capacity = 64;
+    *jobs = malloc(capacity * sizeof(BatchJob));
+    *count = 0;
+
+    struct dirent *entry;
+    while (*jobs != NULL && (entry = readdir(stream)) != NULL)
+    {
+        // Hidden files and the "." and ".." entries are not programs
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        char *path = malloc(strlen(directory) + strlen(entry->d_name) + 2);
+        if (path == NULL)
+        {
+            break;
+        }
+        sprintf(path, "%s/%s", directory, entry->d_name);
+
+        struct stat status;
+        if (stat(path, &status) != 0 || !S_ISREG(status.st_mode))
+        {
+            free(path);
+            continue;
+        }
+
+        if (*count == capacity)
+        {
+            BatchJob *grown = realloc(*jobs, 2 * capacity * sizeof(BatchJob));
+            if (grown == NULL)
+            {
+                free(path);
+                break;
+            }
+            *jobs = grown;
+            capacity *= 2;
+        }
+
+        (*jobs)[(*count)++] = (BatchJob){.path = path};
+    }
+
+    closedir(stream);
+
+    if (*jobs == NULL || entry != NULL)
+    {
+        printf("ERRO: Memória insuficiente para listar o diretório \"%s\"\n", directory);
+        for (unsigned int i = 0; *jobs != NULL && i < *count; i++)
+        {
+            free((*jobs)[i].path);
+        }
+        free(*jobs);
+        return false;
+    }
+
+    qsort(*jobs, *count, sizeof(BatchJob), compare_jobs);
+    return true;
+}
+
+static void *run_worker(void *argument)
+{
+    Worker *worker = argument;
+    Batch *batch = worker->batch;
+
+    // Every job of the worker loads into the same program, which keeps the memory of the last one
+    Program program = {0};
+
+    while (true)
+    {
+        unsigned int job;
+        bool found = take_job(&batch->queues[worker->index], false, &job);
+
+        // Looks for work at the other workers, starting from the next one
+        for (unsigned int i = 1; !found && i < batch->worker_count; i++)
+        {
+            found = take_job(&batch->queues[(worker->index + i) % batch->worker_count], true, &job);
+        }
+
+        // Jobs are never added, so once every queue is empty there is nothing left to do
+        if (!found)
+        {
+            free_program(&program);
+            return NULL;
+        }
+
+        run_job(batch, &batch->jobs[job], &program);
+    }
+}
+
+static bool take_job(WorkQueue *queue, bool steal, unsigned int *job)
+{
+    pthread_mutex_lock(&queue->lock);
+
+    bool found = queue->top < queue->bottom;
+    if (found)
+    {
+        *job = steal ? queue->top++ : --queue->bottom;
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+/// @brief Runs a program on a fresh CPU, with nothing shared with the other jobs but read-only options.
+///
+/// The program is left reset for the next job.
+static void run_job(const Batch *batch, BatchJob *job, Program *program)
+{
+    FILE *output = open_memstream(&job->output, &job->output_length);
+    if (output == NULL)
+    {
+        job->status = 1;
+        return;
+    }
+
+    CPU cpu = {0};
+    Options options = *batch->options;
+    options.output = output;
+    cpu.memory.little_endian = options.little_endian;
+
+    Trace trace;
+    if (batch->trace_level != TRACE_OFF && open_trace(&trace, batch->trace_level, output, NULL))
+    {
+        options.trace = &trace;
+    }
+
+    // What the program prints goes along with its registers, and it has no input to read
+    Console console;
+    if (open_console(&console, output, NULL))
+    {
+        options.console = &console;
+    }
+
+    job->status = run_file(&cpu, program, job->path, &options);
+
+    if (options.console != NULL)
+    {
+        close_console(options.console);
+    }
+
+    if (options.trace != NULL)
+    {
+        close_trace(options.trace);
+    }
+
+    reset_program(program);
+    free_memory(&cpu.memory);
+    fclose(output);
+}
+
+static int compare_jobs(const void *first, const void *second)
+{
+    return strcmp(((const BatchJob *)first)->path, ((const BatchJob *)second)->path);
+}
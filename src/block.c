@@ -0,0 +1,300 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "block.h"
+
+typedef struct Fusion Fusion;
+
+/// @brief A pair of consecutive instructions that is executed by a single handler.
+struct Fusion
+{
+    uint8_t first;
+    uint8_t second;
+    Superinstruction superinstruction;
+};
+
+static const Fusion FUSIONS[] = {
+    // Loop counters followed by the back edge
+    {OPCODE_ADDI, OPCODE_BEQ, SUPER_ADDI_BEQ},
+    {OPCODE_ADDI, OPCODE_BNE, SUPER_ADDI_BNE},
+    {OPCODE_ADDI, OPCODE_BLEZ, SUPER_ADDI_BLEZ},
+    {OPCODE_ADDI, OPCODE_BGTZ, SUPER_ADDI_BGTZ},
+
+    // Comparisons computed as a difference and then branched on
+    {OPCODE_SUB, OPCODE_BEQ, SUPER_SUB_BEQ},
+    {OPCODE_SUB, OPCODE_BNE, SUPER_SUB_BNE},
+    {OPCODE_SUB, OPCODE_BLEZ, SUPER_SUB_BLEZ},
+    {OPCODE_SUB, OPCODE_BGTZ, SUPER_SUB_BGTZ},
+
+    {OPCODE_ADD, OPCODE_ADD, SUPER_ADD_ADD},
+    {OPCODE_ADDI, OPCODE_ADDI, SUPER_ADDI_ADDI},
+};
+
+static Superinstruction record_kind(uint8_t opcode);
+static bool grow_cache(BlockCache *cache, unsigned int length);
+
+Block *translate_block(BlockCache *cache, const Instruction *instructions, unsigned int length, unsigned int base,
+                       unsigned int program_counter, const void *const *handlers)
+{
+    unsigned int first = (program_counter - base) / 4;
+
+    // Empty addresses stop execution, so no block starts at them
+    if (first >= length || instructions[first].opcode == OPCODE_EMPTY)
+    {
+        return NULL;
+    }
+
+    if (!grow_cache(cache, length))
+    {
+        return NULL;
+    }
+
+    // Nor at a branch that cannot take effect
+    unsigned int block_length = measure_block(instructions, length, first, cache->delay_slots);
+    if (block_length == 0)
+    {
+        return NULL;
+    }
+
+    // Only a branch or jump ends a block before its last instruction
+    bool delayed = cache->delay_slots && block_length > 1 && ends_block(instructions[first + block_length - 2].opcode);
+    bool branches = delayed || ends_block(instructions[first + block_length - 1].opcode);
+
+    unsigned int operations = branches && !delayed ? block_length : block_length + 1;
+    Block *block = arena_allocate(&cache->arena, sizeof(Block) + operations * sizeof(BlockOperation));
+    if (block == NULL)
+    {
+        return NULL;
+    }
+
+    block->start = base + first * 4;
+    block->length = block_length;
+    block->delayed = delayed;
+    block->successors[0] = NULL;
+    block->successors[1] = NULL;
+    block->executions = 0;
+    block->native = NULL;
+
+    for (unsigned int i = 0; i < block_length; i++)
+    {
+        block->operations[i].kind = cache->recording ? record_kind(instructions[first + i].opcode)
+                                                     : instructions[first + i].opcode;
+        block->operations[i].instruction = instructions[first + i];
+    }
+
+    // MIPS32 leaves a branch in a delay slot unpredictable, here it does nothing
+    if (delayed)
+    {
+        block->operations[block_length - 2].kind = BLOCK_DELAYED_BRANCH;
+        if (ends_block(instructions[first + block_length - 1].opcode))
+        {
+            block->operations[block_length - 1].kind = OPCODE_NOP;
+        }
+    }
+
+    if (!branches || delayed)
+    {
+        block->operations[block_length].kind = delayed ? BLOCK_BRANCH_END : BLOCK_END;
+        block->operations[block_length].instruction = (Instruction){.opcode = OPCODE_EMPTY};
+    }
+
+    // Fuses pairs left to right, an instruction is never part of two superinstructions, recording needs
+    // each of them on its own, and a branch before its delay slot has a handler of its own
+    unsigned int fusible = delayed ? block_length - 2 : block_length;
+    for (unsigned int i = 0; !cache->recording && i + 1 < fusible; i++)
+    {
+        for (size_t f = 0; f < sizeof(FUSIONS) / sizeof(FUSIONS[0]); f++)
+        {
+            if (block->operations[i].instruction.opcode == FUSIONS[f].first &&
+                block->operations[i + 1].instruction.opcode == FUSIONS[f].second)
+            {
+                block->operations[i].kind = FUSIONS[f].superinstruction;
+                i++;
+                break;
+            }
+        }
+    }
+
+    // Threaded dispatch jumps straight to the handler of every operation
+    if (handlers != NULL)
+    {
+        for (unsigned int i = 0; i < operations; i++)
+        {
+            block->operations[i].handler = handlers[block->operations[i].kind];
+        }
+    }
+
+    cache->blocks[first] = block;
+    return block;
+}
+
+void flush_blocks(BlockCache *cache)
+{
+    if (cache->blocks != NULL)
+    {
+        memset(cache->blocks, 0, cache->capacity * sizeof(*cache->blocks));
+    }
+
+    reset_arena(&cache->arena);
+    jit_reset(&cache->jit);
+}
+
+void free_blocks(BlockCache *cache)
+{
+    flush_blocks(cache);
+    free_arena(&cache->arena);
+    jit_free(&cache->jit);
+    free(cache->blocks);
+    cache->blocks = NULL;
+    cache->capacity = 0;
+}
+
+/// @brief Amount of instructions in the block that starts at index first, with the delay slot of its
+/// branch or jump if delay_slots is set.
+///
+/// A branch whose delay slot is empty cannot take effect, so the block stops right before it.
+unsigned int measure_block(const Instruction *instructions, unsigned int length, unsigned int first, bool delay_slots)
+{
+    unsigned int block_length = 0;
+    while (first + block_length < length && block_length < BLOCK_MAX_LENGTH)
+    {
+        uint8_t opcode = instructions[first + block_length].opcode;
+        if (opcode == OPCODE_EMPTY)
+        {
+            break;
+        }
+
+        block_length++;
+        if (ends_block(opcode))
+        {
+            // The delay slot goes with its branch, even past BLOCK_MAX_LENGTH
+            if (delay_slots && first + block_length < length && instructions[first + block_length].opcode != OPCODE_EMPTY)
+            {
+                block_length++;
+            }
+            else if (delay_slots)
+            {
+                block_length--;
+            }
+            break;
+        }
+    }
+
+    return block_length;
+}
+
+bool ends_block(uint8_t opcode)
+{
+    switch (opcode)
+    {
+    case OPCODE_J:
+    case OPCODE_JAL:
+    case OPCODE_JR:
+    case OPCODE_BEQ:
+    case OPCODE_BNE:
+    case OPCODE_BLEZ:
+    case OPCODE_BGTZ:
+    case OPCODE_BLTZ:
+    case OPCODE_BGEZ:
+    case OPCODE_BLTZAL:
+    case OPCODE_BGEZAL:
+    case OPCODE_JALR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// @brief Handler that records what an instruction overwrites, depending on where it writes its result.
+static Superinstruction record_kind(uint8_t opcode)
+{
+    switch (opcode)
+    {
+    case OPCODE_ADD:
+    case OPCODE_ADDU:
+    case OPCODE_SUB:
+    case OPCODE_SUBU:
+    case OPCODE_MUL:
+    case OPCODE_AND:
+    case OPCODE_OR:
+    case OPCODE_XOR:
+    case OPCODE_NOR:
+    case OPCODE_SLT:
+    case OPCODE_SLTU:
+    case OPCODE_MOVZ:
+    case OPCODE_MOVN:
+    case OPCODE_SLL:
+    case OPCODE_SRL:
+    case OPCODE_SRA:
+    case OPCODE_SLLV:
+    case OPCODE_SRLV:
+    case OPCODE_SRAV:
+    case OPCODE_CLZ:
+    case OPCODE_CLO:
+    case OPCODE_MFHI:
+    case OPCODE_MFLO:
+    case OPCODE_JALR:
+        return BLOCK_RECORD_RD;
+    case OPCODE_ADDI:
+    case OPCODE_ADDIU:
+    case OPCODE_SLTI:
+    case OPCODE_SLTIU:
+    case OPCODE_ANDI:
+    case OPCODE_ORI:
+    case OPCODE_XORI:
+    case OPCODE_LUI:
+    case OPCODE_LB:
+    case OPCODE_LBU:
+    case OPCODE_LH:
+    case OPCODE_LHU:
+    case OPCODE_LW:
+    case OPCODE_LWL:
+    case OPCODE_LWR:
+        return BLOCK_RECORD_RT;
+    case OPCODE_JAL:
+    case OPCODE_BLTZAL:
+    case OPCODE_BGEZAL:
+        return BLOCK_RECORD_RA;
+    case OPCODE_SB:
+    case OPCODE_SH:
+    case OPCODE_SW:
+    case OPCODE_SWL:
+    case OPCODE_SWR:
+        return BLOCK_RECORD_STORE;
+    case OPCODE_MULT:
+    case OPCODE_MULTU:
+    case OPCODE_DIV:
+    case OPCODE_DIVU:
+    case OPCODE_MADD:
+    case OPCODE_MADDU:
+    case OPCODE_MSUB:
+    case OPCODE_MSUBU:
+    case OPCODE_MTHI:
+    case OPCODE_MTLO:
+        return BLOCK_RECORD_HI_LO;
+    case OPCODE_SYSCALL:
+        return BLOCK_RECORD_SYSCALL;
+    default:
+        return BLOCK_RECORD_NOTHING;
+    }
+}
+
+static bool grow_cache(BlockCache *cache, unsigned int length)
+{
+    if (length <= cache->capacity)
+    {
+        return true;
+    }
+
+    Block **blocks = realloc(cache->blocks, length * sizeof(*blocks));
+    if (blocks == NULL)
+    {
+        return false;
+    }
+
+    memset(blocks + cache->capacity, 0, (length - cache->capacity) * sizeof(*blocks));
+    cache->blocks = blocks;
+    cache->capacity = length;
+    return true;
+}
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "cpu.h"
+
+const char *const REGISTER_NAMES[REGISTER_COUNT] = {
+#define MNEMONIC(name, format)
+#define REGISTER(name, number) [number] = "$" #name,
+#include "keywords.def"
+#undef MNEMONIC
+#undef REGISTER
+};
+
+/// @brief Registers shown in each row of print_registers.
+static const unsigned char REGISTER_ROWS[4][8] = {
+    {16, 17, 18, 19, 20, 21, 22, 23},
+    {4, 5, 6, 7, 2, 3, 26, 27},
+    {8, 9, 10, 11, 12, 13, 14, 15},
+    {24, 25, 0, 28, 29, 30, 31, 1},
+};
+
+void print_registers(const CPU *cpu, FILE *output)
+{
+    fprintf(output, "+-------------------------------------------------------------------------------------------------------------------------------------------------------+\n");
+
+    for (int row = 0; row < 4; row++)
+    {
+        if (row > 0)
+        {
+            fprintf(output, "|------------------+------------------+------------------+------------------+------------------+------------------+------------------+------------------|\n");
+        }
+
+        for (int column = 0; column < 8; column++)
+        {
+            unsigned char index = REGISTER_ROWS[row][column];
+            const char *name = REGISTER_NAMES[index];
+
+            // Every cell is 16 characters wide, longer names leave less room for the value
+            fprintf(output, "| %s: %*d ", name, (int)(14 - strlen(name)), (int32_t)cpu->gpr[index]);
+        }
+        fprintf(output, "|\n");
+    }
+
+    fprintf(output, "+-------------------------------------------------------------------------------------------------------------------------------------------------------+\n");
+}
+
+/// @brief Records in coprocessor 0 that the instruction at program_counter raised the exception.
+///
+/// Only called once an instruction fails, so whatever executes normally never reaches it.
+void raise_exception(CPU *cpu, uint8_t code, uint32_t program_counter, bool delay_slot, uint32_t bad_address)
+{
+    cpu->cop0.epc = delay_slot ? program_counter - 4 : program_counter;
+    cpu->cop0.cause = (uint32_t)code << CAUSE_CODE_SHIFT | (delay_slot ? CAUSE_BRANCH_DELAY : 0);
+
+    if (code == EXCEPTION_ADDRESS_LOAD || code == EXCEPTION_ADDRESS_STORE)
+    {
+        cpu->cop0.bad_address = bad_address;
+    }
+}
+
+/// @brief Reports the last exception, from the registers of coprocessor 0.
+void print_exception(const CPU *cpu, FILE *output)
+{
+    uint8_t code = (cpu->cop0.cause >> CAUSE_CODE_SHIFT) & 0x1F;
+    bool delay_slot = (cpu->cop0.cause & CAUSE_BRANCH_DELAY) != 0;
+
+    switch (code)
+    {
+    case EXCEPTION_ADDRESS_LOAD:
+        fprintf(output, "ERRO: Exceção de endereço desalinhado ao ler ou buscar instrução em %u",
+                cpu->cop0.bad_address);
+        break;
+    case EXCEPTION_ADDRESS_STORE:
+        fprintf(output, "ERRO: Exceção de endereço desalinhado ao escrever em %u", cpu->cop0.bad_address);
+        break;
+    case EXCEPTION_RESERVED:
+        fprintf(output, "ERRO: Exceção de instrução reservada");
+        break;
+    case EXCEPTION_OVERFLOW:
+        fprintf(output, "ERRO: Exceção de overflow aritmético");
+        break;
+    default:
+        fprintf(output, "ERRO: Exceção %u", code);
+        break;
+    }
+
+    fprintf(output, " (EPC = %u%s, Cause = 0x%08x)\n", cpu->cop0.epc, delay_slot ? ", no delay slot" : "",
+            cpu->cop0.cause);
+}
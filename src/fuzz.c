@@ -0,0 +1,844 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fuzz.h"
+#include "syscall.h"
+
+typedef enum Shape Shape;
+typedef struct Pattern Pattern;
+
+/// @brief Which fields of an instruction are generated, and what for.
+enum Shape
+{
+    /// @brief NOP and SYSCALL, which have no fields.
+    SHAPE_NONE,
+
+    /// @brief rd from rs and rt.
+    SHAPE_R,
+
+    /// @brief rd from rt shifted by a constant amount.
+    SHAPE_SHIFT,
+
+    /// @brief rd from rt shifted by rs.
+    SHAPE_SHIFT_VARIABLE,
+
+    /// @brief HI and LO from rs and rt.
+    SHAPE_PAIR,
+
+    /// @brief rd from HI or LO.
+    SHAPE_DESTINATION,
+
+    /// @brief HI or LO from rs.
+    SHAPE_SOURCE,
+
+    /// @brief rd from rs alone.
+    SHAPE_UNARY,
+
+    /// @brief rt from rs and a sign extended immediate.
+    SHAPE_I,
+
+    /// @brief rt from rs and a zero extended immediate.
+    SHAPE_LOGICAL,
+
+    /// @brief rt from an immediate alone.
+    SHAPE_UPPER,
+
+    /// @brief Compares rs and rt to go to an address of the program.
+    SHAPE_BRANCH,
+
+    /// @brief Compares rs to zero to go to an address of the program.
+    SHAPE_BRANCH_ZERO,
+
+    /// @brief Goes to an address of the program.
+    SHAPE_JUMP,
+
+    /// @brief Goes to the address in rs, mostly $ra.
+    SHAPE_JUMP_REGISTER,
+
+    /// @brief Goes to the address in rs, linking in rd.
+    SHAPE_LINK,
+
+    /// @brief rt from the data around $gp or $sp.
+    SHAPE_LOAD,
+
+    /// @brief rt to the data around $gp or $sp.
+    SHAPE_STORE,
+
+    /// @brief A word no instruction has, as the loader keeps it.
+    SHAPE_RESERVED,
+};
+
+struct Pattern
+{
+    /// @brief One of Shape.
+    uint8_t shape;
+
+    /// @brief Bytes loads and stores are aligned to, all but a few of the times.
+    uint8_t alignment;
+};
+
+static const Pattern PATTERNS[OPCODE_COUNT] = {
+    [OPCODE_ADD] = {SHAPE_R},
+    [OPCODE_ADDU] = {SHAPE_R},
+    [OPCODE_ADDI] = {SHAPE_I},
+    [OPCODE_SUB] = {SHAPE_R},
+    [OPCODE_SUBU] = {SHAPE_R},
+    [OPCODE_J] = {SHAPE_JUMP},
+    [OPCODE_MULT] = {SHAPE_PAIR},
+    [OPCODE_AND] = {SHAPE_R},
+    [OPCODE_OR] = {SHAPE_R},
+    [OPCODE_ANDI] = {SHAPE_LOGICAL},
+    [OPCODE_ORI] = {SHAPE_LOGICAL},
+    [OPCODE_BEQ] = {SHAPE_BRANCH},
+    [OPCODE_BNE] = {SHAPE_BRANCH},
+    [OPCODE_BLEZ] = {SHAPE_BRANCH_ZERO},
+    [OPCODE_BGTZ] = {SHAPE_BRANCH_ZERO},
+    [OPCODE_JAL] = {SHAPE_JUMP},
+    [OPCODE_JR] = {SHAPE_JUMP_REGISTER},
+    [OPCODE_NOP] = {SHAPE_NONE},
+    [OPCODE_LB] = {SHAPE_LOAD, 1},
+    [OPCODE_LBU] = {SHAPE_LOAD, 1},
+    [OPCODE_LH] = {SHAPE_LOAD, 2},
+    [OPCODE_LHU] = {SHAPE_LOAD, 2},
+    [OPCODE_LW] = {SHAPE_LOAD, 4},
+    [OPCODE_SB] = {SHAPE_STORE, 1},
+    [OPCODE_SH] = {SHAPE_STORE, 2},
+    [OPCODE_SW] = {SHAPE_STORE, 4},
+    [OPCODE_MUL] = {SHAPE_R},
+    [OPCODE_MULTU] = {SHAPE_PAIR},
+    [OPCODE_DIV] = {SHAPE_PAIR},
+    [OPCODE_DIVU] = {SHAPE_PAIR},
+    [OPCODE_MADD] = {SHAPE_PAIR},
+    [OPCODE_MADDU] = {SHAPE_PAIR},
+    [OPCODE_MSUB] = {SHAPE_PAIR},
+    [OPCODE_MSUBU] = {SHAPE_PAIR},
+    [OPCODE_MFHI] = {SHAPE_DESTINATION},
+    [OPCODE_MFLO] = {SHAPE_DESTINATION},
+    [OPCODE_MTHI] = {SHAPE_SOURCE},
+    [OPCODE_MTLO] = {SHAPE_SOURCE},
+    [OPCODE_XOR] = {SHAPE_R},
+    [OPCODE_NOR] = {SHAPE_R},
+    [OPCODE_SLT] = {SHAPE_R},
+    [OPCODE_SLTU] = {SHAPE_R},
+    [OPCODE_MOVZ] = {SHAPE_R},
+    [OPCODE_MOVN] = {SHAPE_R},
+    [OPCODE_SLL] = {SHAPE_SHIFT},
+    [OPCODE_SRL] = {SHAPE_SHIFT},
+    [OPCODE_SRA] = {SHAPE_SHIFT},
+    [OPCODE_SLLV] = {SHAPE_SHIFT_VARIABLE},
+    [OPCODE_SRLV] = {SHAPE_SHIFT_VARIABLE},
+    [OPCODE_SRAV] = {SHAPE_SHIFT_VARIABLE},
+    [OPCODE_CLZ] = {SHAPE_UNARY},
+    [OPCODE_CLO] = {SHAPE_UNARY},
+    [OPCODE_ADDIU] = {SHAPE_I},
+    [OPCODE_SLTI] = {SHAPE_I},
+    [OPCODE_SLTIU] = {SHAPE_I},
+    [OPCODE_XORI] = {SHAPE_LOGICAL},
+    [OPCODE_LUI] = {SHAPE_UPPER},
+    [OPCODE_BLTZ] = {SHAPE_BRANCH_ZERO},
+    [OPCODE_BGEZ] = {SHAPE_BRANCH_ZERO},
+    [OPCODE_BLTZAL] = {SHAPE_BRANCH_ZERO},
+    [OPCODE_BGEZAL] = {SHAPE_BRANCH_ZERO},
+    [OPCODE_JALR] = {SHAPE_LINK},
+
+    // Unaligned loads and stores take any address
+    [OPCODE_LWL] = {SHAPE_LOAD, 1},
+    [OPCODE_LWR] = {SHAPE_LOAD, 1},
+    [OPCODE_SWL] = {SHAPE_STORE, 1},
+    [OPCODE_SWR] = {SHAPE_STORE, 1},
+
+    [OPCODE_SYSCALL] = {SHAPE_NONE},
+    [OPCODE_RESERVED] = {SHAPE_RESERVED},
+};
+
+/// @brief Syscalls $v0 starts with in some of the programs, so the ones that run usually do something.
+static const uint32_t SYSCALLS[] = {
+    SYSCALL_PRINT_INT,  SYSCALL_PRINT_STRING, SYSCALL_READ_INT,  SYSCALL_READ_STRING,
+    SYSCALL_SBRK,       SYSCALL_EXIT,         SYSCALL_PRINT_CHAR, SYSCALL_READ_CHAR,
+    SYSCALL_EXIT2,      SYSCALL_PRINT_HEX,    SYSCALL_PRINT_BINARY, SYSCALL_PRINT_UNSIGNED,
+};
+
+static const char *const ENGINE_NAMES[FUZZ_ENGINES] = {
+    [FUZZ_UNFUSED] = "interpretador sem fusão",
+    [FUZZ_INTERPRETER] = "interpretador",
+    [FUZZ_JIT] = "JIT",
+};
+
+static void *run_fuzz_worker(void *argument);
+static void generate_case(FuzzCase *fuzz_case, uint64_t seed);
+static Instruction generate_instruction(uint64_t *state, unsigned int index, unsigned int length, bool memory);
+static uint32_t generate_value(uint64_t *state);
+static uint8_t generate_destination(uint64_t *state);
+static uint64_t next_random(uint64_t *state);
+static bool run_case(FuzzWorker *worker, const FuzzCase *fuzz_case, Divergence *divergence, uint64_t *executed);
+static bool load_case(FuzzWorker *worker, const FuzzCase *fuzz_case, FuzzEngine engine);
+static void capture_state(CPU *cpu, bool paused, FuzzState *state);
+static uint64_t hash_written_pages(Memory *memory);
+static bool same_state(const FuzzState *first, const FuzzState *second);
+static void minimize_case(FuzzWorker *worker, FuzzCase *fuzz_case, Divergence *divergence);
+static void print_divergence(const FuzzCase *fuzz_case, unsigned int original_length, const Divergence *divergence);
+static void print_difference(const char *name, uint64_t expected, uint64_t found);
+
+/*
+ * Each program is generated from its own seed, the base seed plus its number, so a divergence can be
+ * reproduced on its own with --fuzz 1 and its seed, whatever the amount of threads. Programs are made
+ * of valid instructions only: registers $gp and $sp are never written and point at random data that
+ * every load and store goes to, and branches and jumps go to addresses of the program or right after it.
+ *
+ * The engines run a program in lockstep, a block at a time, by pausing at the instruction after the
+ * one the reference has reached, and their state is compared after each block. Memory is compared
+ * through the pages each block wrote, as the rest matched after the previous block, so a block costs
+ * the pages it wrote instead of all of them. A program that diverges is minimized by turning its
+ * instructions into NOPs and clearing its registers one at a time, as long as it still diverges,
+ * before it is reported.
+ *
+ * Workers split the programs round robin, one per core unless threads says otherwise, and each keeps a
+ * CPU and a program for every engine, so a program costs little more than executing it three times.
+ */
+int run_fuzz(uint64_t count, uint64_t seed, unsigned int threads)
+{
+    if (threads == 0)
+    {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores > 0 ? cores : 1;
+    }
+    if (threads > count)
+    {
+        threads = count;
+    }
+
+    Fuzzer fuzzer = {.seed = seed, .count = count, .worker_count = threads};
+    FuzzWorker *workers = calloc(threads, sizeof(FuzzWorker));
+    pthread_t *handles = malloc(threads * sizeof(pthread_t));
+
+    if (workers == NULL || handles == NULL)
+    {
+        printf("ERRO: Memória insuficiente para o fuzzing\n");
+        free(workers);
+        free(handles);
+        return 1;
+    }
+
+    printf("Semente inicial %llu, %llu programas em %u threads\n", (unsigned long long)seed,
+           (unsigned long long)count, threads);
+    fflush(stdout);
+
+    pthread_mutex_init(&fuzzer.lock, NULL);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (unsigned int i = 0; i < threads; i++)
+    {
+        workers[i].fuzzer = &fuzzer;
+        workers[i].index = i;
+    }
+
+    // The calling thread is the first worker
+    unsigned int started = 1;
+    while (started < threads && pthread_create(&handles[started], NULL, run_fuzz_worker, &workers[started]) == 0)
+    {
+        started++;
+    }
+
+    run_fuzz_worker(&workers[0]);
+
+    for (unsigned int i = 1; i < started; i++)
+    {
+        pthread_join(handles[i], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    // Workers that never started leave their programs out
+    printf("%llu programas executados (%llu instruções) em %.2f segundos, %.0f programas por segundo, %s\n",
+           (unsigned long long)fuzzer.executed, (unsigned long long)fuzzer.instructions, seconds,
+           seconds > 0 ? fuzzer.executed / seconds : 0, fuzzer.diverged ? "com divergência" : "nenhuma divergência");
+
+    pthread_mutex_destroy(&fuzzer.lock);
+    free(workers);
+    free(handles);
+    return fuzzer.diverged || fuzzer.executed < count ? 1 : 0;
+}
+
+static void *run_fuzz_worker(void *argument)
+{
+    FuzzWorker *worker = argument;
+    Fuzzer *fuzzer = worker->fuzzer;
+
+    worker->output = fopen("/dev/null", "w");
+    if (worker->output == NULL)
+    {
+        return NULL;
+    }
+
+    uint64_t executed = 0;
+    uint64_t instructions = 0;
+    FuzzCase fuzz_case;
+    Divergence divergence;
+
+    for (uint64_t number = worker->index; number < fuzzer->count; number += fuzzer->worker_count)
+    {
+        pthread_mutex_lock(&fuzzer->lock);
+        bool stop = fuzzer->diverged;
+        pthread_mutex_unlock(&fuzzer->lock);
+
+        if (stop)
+        {
+            break;
+        }
+
+        generate_case(&fuzz_case, fuzzer->seed + number);
+
+        uint64_t case_instructions;
+        bool diverged = run_case(worker, &fuzz_case, &divergence, &case_instructions);
+        executed++;
+        instructions += case_instructions;
+
+        if (!diverged)
+        {
+            continue;
+        }
+
+        // Only the first divergence is reported, the other workers stop at their next program
+        pthread_mutex_lock(&fuzzer->lock);
+        bool first = !fuzzer->diverged;
+        fuzzer->diverged = true;
+        pthread_mutex_unlock(&fuzzer->lock);
+
+        if (first)
+        {
+            unsigned int original_length = fuzz_case.length;
+            minimize_case(worker, &fuzz_case, &divergence);
+            print_divergence(&fuzz_case, original_length, &divergence);
+        }
+        break;
+    }
+
+    pthread_mutex_lock(&fuzzer->lock);
+    fuzzer->executed += executed;
+    fuzzer->instructions += instructions;
+    pthread_mutex_unlock(&fuzzer->lock);
+
+    for (unsigned int engine = 0; engine < FUZZ_ENGINES; engine++)
+    {
+        free_program(&worker->programs[engine]);
+        free_memory(&worker->cpus[engine].memory);
+    }
+    fclose(worker->output);
+    return NULL;
+}
+
+static void generate_case(FuzzCase *fuzz_case, uint64_t seed)
+{
+    uint64_t state = seed;
+    *fuzz_case = (FuzzCase){.seed = seed};
+
+    fuzz_case->delay_slots = next_random(&state) & 1;
+
+    // Half of the programs leave memory and syscalls alone, which the JIT does not compile, so every
+    // block of them is compiled
+    bool memory = next_random(&state) & 1;
+
+    fuzz_case->length = FUZZ_MIN_LENGTH + next_random(&state) % (FUZZ_MAX_LENGTH - FUZZ_MIN_LENGTH + 1);
+    for (unsigned int i = 0; i < fuzz_case->length; i++)
+    {
+        fuzz_case->instructions[i] = generate_instruction(&state, i, fuzz_case->length, memory);
+    }
+
+    for (unsigned int i = 1; i < REGISTER_COUNT; i++)
+    {
+        fuzz_case->gpr[i] = generate_value(&state);
+    }
+    fuzz_case->gpr[REGISTER_GP] = FUZZ_GLOBAL_POINTER;
+    fuzz_case->gpr[REGISTER_SP] = FUZZ_STACK_POINTER;
+    if (memory && next_random(&state) % 2 == 0)
+    {
+        fuzz_case->gpr[REGISTER_V0] = SYSCALLS[next_random(&state) % (sizeof(SYSCALLS) / sizeof(SYSCALLS[0]))];
+    }
+
+    fuzz_case->hi = generate_value(&state);
+    fuzz_case->lo = generate_value(&state);
+
+    for (unsigned int i = 0; i < FUZZ_DATA_SIZE; i += 8)
+    {
+        uint64_t global_bytes = next_random(&state);
+        uint64_t stack_bytes = next_random(&state);
+        memcpy(&fuzz_case->global_data[i], &global_bytes, 8);
+        memcpy(&fuzz_case->stack_data[i], &stack_bytes, 8);
+    }
+}
+
+/// @brief A random instruction for the given index, which only touches memory and makes syscalls if memory is set.
+///
+/// It goes through encode_instruction and decode_word, so it is exactly what a loaded program would hold.
+static Instruction generate_instruction(uint64_t *state, unsigned int index, unsigned int length, bool memory)
+{
+    uint8_t opcode;
+    Pattern pattern;
+    do
+    {
+        opcode = 1 + next_random(state) % (OPCODE_COUNT - 1);
+        pattern = PATTERNS[opcode];
+    } while (!memory && (pattern.shape == SHAPE_LOAD || pattern.shape == SHAPE_STORE || opcode == OPCODE_SYSCALL));
+
+    uint64_t random = next_random(state);
+    uint8_t first = random % REGISTER_COUNT;
+    uint8_t second = (random >> 8) % REGISTER_COUNT;
+    int32_t immediate = (int16_t)(random >> 16);
+    uint32_t target = 4 * ((random >> 32) % (length + 1));
+
+    // Registers jumped to are mostly $ra, which JAL and the linking branches set to an address of the program
+    uint8_t jumped = (random >> 48) % 2 == 0 ? REGISTER_RA : first;
+
+    // Offsets stay in the data around $gp or $sp, and are mostly aligned to what they access
+    uint8_t base = (random >> 49) % 2 == 0 ? REGISTER_GP : REGISTER_SP;
+    int32_t offset = (int32_t)((random >> 50) % (2 * FUZZ_OFFSET_RANGE)) - FUZZ_OFFSET_RANGE;
+    if ((random >> 58) % 8 != 0)
+    {
+        offset &= -(int32_t)pattern.alignment;
+    }
+
+    Instruction instruction = {.opcode = opcode};
+    switch (pattern.shape)
+    {
+    case SHAPE_R:
+    case SHAPE_SHIFT_VARIABLE:
+        instruction.rd = generate_destination(state);
+        instruction.rs = first;
+        instruction.rt = second;
+        break;
+    case SHAPE_SHIFT:
+        instruction.rd = generate_destination(state);
+        instruction.rt = second;
+        instruction.immediate = immediate & 0x1F;
+        break;
+    case SHAPE_PAIR:
+        instruction.rs = first;
+        instruction.rt = second;
+        break;
+    case SHAPE_BRANCH:
+        instruction.rs = first;
+        instruction.rt = second;
+        instruction.immediate = target;
+        break;
+    case SHAPE_DESTINATION:
+        instruction.rd = generate_destination(state);
+        break;
+    case SHAPE_SOURCE:
+        instruction.rs = first;
+        break;
+    case SHAPE_UNARY:
+        instruction.rd = generate_destination(state);
+        instruction.rs = first;
+        break;
+    case SHAPE_I:
+        instruction.rt = generate_destination(state);
+        instruction.rs = first;
+        instruction.immediate = immediate;
+        break;
+    case SHAPE_LOGICAL:
+        instruction.rt = generate_destination(state);
+        instruction.rs = first;
+        instruction.immediate = (uint16_t)immediate;
+        break;
+    case SHAPE_UPPER:
+        instruction.rt = generate_destination(state);
+        instruction.immediate = (uint16_t)immediate;
+        break;
+    case SHAPE_BRANCH_ZERO:
+        instruction.rs = first;
+        instruction.immediate = target;
+        break;
+    case SHAPE_JUMP:
+        instruction.immediate = target;
+        break;
+    case SHAPE_JUMP_REGISTER:
+        instruction.rs = jumped;
+        break;
+    case SHAPE_LINK:
+        // MIPS32 leaves linking into the register jumped to unpredictable
+        instruction.rs = jumped;
+        do
+        {
+            instruction.rd = generate_destination(state);
+        } while (instruction.rd == instruction.rs);
+        break;
+    case SHAPE_LOAD:
+        instruction.rt = generate_destination(state);
+        instruction.rs = base;
+        instruction.immediate = offset;
+        break;
+    case SHAPE_STORE:
+        instruction.rt = second;
+        instruction.rs = base;
+        instruction.immediate = offset;
+        break;
+    case SHAPE_RESERVED:
+        // Coprocessor 1 has no instructions here
+        instruction.immediate = (int32_t)(0x11u << 26 | (uint32_t)(random >> 32) >> 6);
+        break;
+    }
+
+    uint32_t word;
+    Instruction decoded;
+    if (!encode_instruction(&instruction, 4 * index, &word))
+    {
+        return (Instruction){.opcode = OPCODE_NOP};
+    }
+
+    if (!decode_word(word, 4 * index, &decoded))
+    {
+        return (Instruction){.opcode = OPCODE_RESERVED, .immediate = (int32_t)word};
+    }
+    return decoded;
+}
+
+/// @brief A register value, biased towards the ones arithmetic and comparisons treat specially.
+static uint32_t generate_value(uint64_t *state)
+{
+    uint64_t random = next_random(state);
+    uint32_t value = random >> 32;
+
+    switch (random % 8)
+    {
+    case 0:
+        return 0;
+    case 1:
+        return (int32_t)(value % 17) - 8;
+    case 2:
+    {
+        static const uint32_t EDGES[] = {0x7FFFFFFF, 0x80000000, 0xFFFFFFFF, 0x80000001, 0x7FFFFFFE, 0xFFFF, 0x8000};
+        return EDGES[value % (sizeof(EDGES) / sizeof(EDGES[0]))];
+    }
+    case 3:
+        return 1u << (value % 32);
+    case 4:
+        return FUZZ_GLOBAL_POINTER + (int32_t)(value % (2 * FUZZ_OFFSET_RANGE)) - FUZZ_OFFSET_RANGE;
+    default:
+        return value;
+    }
+}
+
+/// @brief Any register but $gp and $sp, which keep pointing at the data.
+static uint8_t generate_destination(uint64_t *state)
+{
+    uint8_t number = next_random(state) % (REGISTER_COUNT - 2);
+    return number >= REGISTER_GP ? number + 2 : number;
+}
+
+/// @brief SplitMix64, which is fast and good enough to generate programs from.
+static uint64_t next_random(uint64_t *state)
+{
+    uint64_t value = (*state += 0x9E3779B97F4A7C15);
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+    return value ^ (value >> 31);
+}
+
+/// @brief Runs the program on every engine, returning whether one of them diverged from the reference.
+static bool run_case(FuzzWorker *worker, const FuzzCase *fuzz_case, Divergence *divergence, uint64_t *executed)
+{
+    bool loaded = true;
+    for (unsigned int engine = 0; engine < FUZZ_ENGINES; engine++)
+    {
+        loaded = load_case(worker, fuzz_case, engine) && loaded;
+    }
+
+    // Enough records that the checkpoint taken at the start is the only one
+    if (!loaded || !open_undo(&worker->undo, 2 * FUZZ_INSTRUCTION_LIMIT))
+    {
+        *executed = 0;
+        return false;
+    }
+
+    Options options[FUZZ_ENGINES] = {
+        [FUZZ_UNFUSED] = {.output = worker->output, .undo = &worker->undo},
+        [FUZZ_INTERPRETER] = {.output = worker->output},
+        [FUZZ_JIT] = {.output = worker->output, .jit_threshold = 1},
+    };
+
+    const CPU *reference = &worker->cpus[FUZZ_UNFUSED];
+    bool diverged = false;
+    bool running = true;
+
+    while (running && !diverged)
+    {
+        FuzzState states[FUZZ_ENGINES];
+        uint64_t limit = reference->instructions + 1;
+
+        for (unsigned int engine = 0; engine < FUZZ_ENGINES; engine++)
+        {
+            options[engine].instruction_limit = limit;
+            bool paused = run_program(&worker->cpus[engine], &worker->programs[engine], &options[engine]);
+            capture_state(&worker->cpus[engine], paused, &states[engine]);
+        }
+
+        for (unsigned int engine = 1; engine < FUZZ_ENGINES && !diverged; engine++)
+        {
+            if (!same_state(&states[FUZZ_UNFUSED], &states[engine]))
+            {
+                *divergence = (Divergence){engine, limit - 1, states[FUZZ_UNFUSED], states[engine]};
+                diverged = true;
+            }
+        }
+
+        running = states[FUZZ_UNFUSED].paused && reference->instructions < FUZZ_INSTRUCTION_LIMIT;
+    }
+
+    *executed = reference->instructions;
+    free_undo(&worker->undo);
+    return diverged;
+}
+
+/// @brief Puts the program and the state it starts from into the CPU and program of the engine.
+static bool load_case(FuzzWorker *worker, const FuzzCase *fuzz_case, FuzzEngine engine)
+{
+    CPU *cpu = &worker->cpus[engine];
+    Program *program = &worker->programs[engine];
+
+    free_memory(&cpu->memory);
+    *cpu = (CPU){.hi = fuzz_case->hi, .lo = fuzz_case->lo};
+    memcpy(cpu->gpr, fuzz_case->gpr, sizeof(cpu->gpr));
+
+    if (!write_memory(&cpu->memory, FUZZ_GLOBAL_POINTER - FUZZ_DATA_SIZE / 2, fuzz_case->global_data, FUZZ_DATA_SIZE) ||
+        !write_memory(&cpu->memory, FUZZ_STACK_POINTER - FUZZ_DATA_SIZE / 2, fuzz_case->stack_data, FUZZ_DATA_SIZE))
+    {
+        return false;
+    }
+
+    reset_program(program);
+    program->delay_slots = fuzz_case->delay_slots;
+    for (unsigned int i = 0; i < fuzz_case->length; i++)
+    {
+        if (!store_instruction(program, 4 * i, fuzz_case->instructions[i], worker->output))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void capture_state(CPU *cpu, bool paused, FuzzState *state)
+{
+    *state = (FuzzState){
+        .program_counter = cpu->program_counter,
+        .hi = cpu->hi,
+        .lo = cpu->lo,
+        .instructions = cpu->instructions,
+        .heap_break = cpu->heap_break,
+        .exited = cpu->exited,
+        .exit_status = cpu->exit_status,
+        .paused = paused,
+        .fault = cpu->memory.fault,
+        .fault_address = cpu->memory.fault_address,
+        .cop0 = cpu->cop0,
+        .memory_hash = hash_written_pages(&cpu->memory),
+    };
+    memcpy(state->gpr, cpu->gpr, sizeof(state->gpr));
+}
+
+/// @brief FNV-1a over the number and the contents of every page written since the last call, a word at a time.
+///
+/// The pages are left clean, so each block only costs the pages it wrote.
+static uint64_t hash_written_pages(Memory *memory)
+{
+    uint64_t hash = 0xCBF29CE484222325;
+
+    // The first write after the tag is cleared marks its page and sets the tag again, so without one
+    // nothing was written
+    if (memory->written_tag == 0)
+    {
+        return hash;
+    }
+
+    for (uint32_t table = 0; table < TABLE_SIZE; table++)
+    {
+        PageTable *pages = memory->directory[table];
+        if (pages == NULL)
+        {
+            continue;
+        }
+
+        for (uint32_t group = 0; group < TABLE_SIZE / 32; group++)
+        {
+            for (uint32_t dirty = pages->dirty[group]; dirty != 0; dirty &= dirty - 1)
+            {
+                uint32_t index = group * 32 + __builtin_ctz(dirty);
+                hash = (hash ^ (table << TABLE_BITS | index)) * 0x100000001B3;
+
+                for (unsigned int offset = 0; offset < PAGE_SIZE; offset += 8)
+                {
+                    uint64_t word;
+                    memcpy(&word, pages->pages[index] + offset, 8);
+                    hash = (hash ^ word) * 0x100000001B3;
+                }
+            }
+            pages->dirty[group] = 0;
+        }
+    }
+
+    memory->written_tag = 0;
+    return hash;
+}
+
+static bool same_state(const FuzzState *first, const FuzzState *second)
+{
+    return first->program_counter == second->program_counter && first->hi == second->hi &&
+           first->lo == second->lo && first->instructions == second->instructions &&
+           first->heap_break == second->heap_break && first->exited == second->exited &&
+           first->exit_status == second->exit_status && first->paused == second->paused &&
+           first->fault == second->fault && first->fault_address == second->fault_address &&
+           first->cop0.bad_address == second->cop0.bad_address && first->cop0.cause == second->cop0.cause &&
+           first->cop0.epc == second->cop0.epc &&
+           first->memory_hash == second->memory_hash && memcmp(first->gpr, second->gpr, sizeof(first->gpr)) == 0;
+}
+
+/// @brief Turns instructions into NOPs and registers, HI and LO into zeros while the program still diverges.
+///
+/// A NOP keeps the addresses of every other instruction, so branches still go where they went.
+static void minimize_case(FuzzWorker *worker, FuzzCase *fuzz_case, Divergence *divergence)
+{
+    Divergence candidate;
+    uint64_t executed;
+    bool reduced = true;
+
+    while (reduced)
+    {
+        reduced = false;
+
+        for (unsigned int i = 0; i < fuzz_case->length; i++)
+        {
+            Instruction original = fuzz_case->instructions[i];
+            if (original.opcode == OPCODE_NOP)
+            {
+                continue;
+            }
+
+            fuzz_case->instructions[i] = (Instruction){.opcode = OPCODE_NOP};
+            if (run_case(worker, fuzz_case, &candidate, &executed))
+            {
+                *divergence = candidate;
+                reduced = true;
+            }
+            else
+            {
+                fuzz_case->instructions[i] = original;
+            }
+        }
+
+        // NOPs at the end only run off it, which the program may do as well without them
+        while (fuzz_case->length > 1 && fuzz_case->instructions[fuzz_case->length - 1].opcode == OPCODE_NOP)
+        {
+            fuzz_case->length--;
+            if (!run_case(worker, fuzz_case, &candidate, &executed))
+            {
+                fuzz_case->length++;
+                break;
+            }
+            *divergence = candidate;
+        }
+
+        for (unsigned int i = 1; i < REGISTER_COUNT; i++)
+        {
+            uint32_t original = fuzz_case->gpr[i];
+            if (original == 0 || i == REGISTER_GP || i == REGISTER_SP)
+            {
+                continue;
+            }
+
+            fuzz_case->gpr[i] = 0;
+            if (run_case(worker, fuzz_case, &candidate, &executed))
+            {
+                *divergence = candidate;
+                reduced = true;
+            }
+            else
+            {
+                fuzz_case->gpr[i] = original;
+            }
+        }
+
+        uint32_t *pair[] = {&fuzz_case->hi, &fuzz_case->lo};
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            uint32_t original = *pair[i];
+            if (original == 0)
+            {
+                continue;
+            }
+
+            *pair[i] = 0;
+            if (run_case(worker, fuzz_case, &candidate, &executed))
+            {
+                *divergence = candidate;
+                reduced = true;
+            }
+            else
+            {
+                *pair[i] = original;
+            }
+        }
+    }
+}
+
+static void print_divergence(const FuzzCase *fuzz_case, unsigned int original_length, const Divergence *divergence)
+{
+    printf("DIVERGÊNCIA na semente %llu: %s difere do %s no bloco que começa depois de %llu instruções\n",
+           (unsigned long long)fuzz_case->seed, ENGINE_NAMES[divergence->engine], ENGINE_NAMES[FUZZ_UNFUSED],
+           (unsigned long long)divergence->instructions);
+
+    const FuzzState *expected = &divergence->expected;
+    const FuzzState *found = &divergence->found;
+    print_difference("PC", expected->program_counter, found->program_counter);
+    for (unsigned int i = 0; i < REGISTER_COUNT; i++)
+    {
+        print_difference(REGISTER_NAMES[i], expected->gpr[i], found->gpr[i]);
+    }
+    print_difference("HI", expected->hi, found->hi);
+    print_difference("LO", expected->lo, found->lo);
+    print_difference("instruções", expected->instructions, found->instructions);
+    print_difference("fim do heap", expected->heap_break, found->heap_break);
+    print_difference("saiu", expected->exited, found->exited);
+    print_difference("status de saída", expected->exit_status, found->exit_status);
+    print_difference("pausou", expected->paused, found->paused);
+    print_difference("falha de memória", expected->fault, found->fault);
+    print_difference("endereço da falha", expected->fault_address, found->fault_address);
+    print_difference("BadVAddr", expected->cop0.bad_address, found->cop0.bad_address);
+    print_difference("Cause", expected->cop0.cause, found->cop0.cause);
+    print_difference("EPC", expected->cop0.epc, found->cop0.epc);
+    print_difference("hash da memória", expected->memory_hash, found->memory_hash);
+
+    printf("Registradores iniciais (HI = 0x%08x, LO = 0x%08x, os dados de $gp e $sp vêm da semente):\n", fuzz_case->hi,
+           fuzz_case->lo);
+    for (unsigned int i = 1; i < REGISTER_COUNT; i++)
+    {
+        if (fuzz_case->gpr[i] != 0)
+        {
+            printf("  %s = 0x%08x\n", REGISTER_NAMES[i], fuzz_case->gpr[i]);
+        }
+    }
+
+    printf("Programa reduzido de %u para %u instruções, %s delay slots:\n", original_length, fuzz_case->length,
+           fuzz_case->delay_slots ? "com" : "sem");
+    for (unsigned int i = 0; i < fuzz_case->length; i++)
+    {
+        char text[64];
+        disassemble_instruction(&fuzz_case->instructions[i], text, sizeof(text));
+        printf("  %08x  %s\n", 4 * i, text);
+    }
+}
+
+static void print_difference(const char *name, uint64_t expected, uint64_t found)
+{
+    if (expected != found)
+    {
+        printf("  %s: 0x%llx esperado, 0x%llx encontrado\n", name, (unsigned long long)expected,
+               (unsigned long long)found);
+    }
+}
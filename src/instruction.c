@@ -0,0 +1,733 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "instruction.h"
+#include "keyword.h"
+
+// Machine opcodes whose instructions are told apart by another field
+#define MACHINE_SPECIAL 0x00
+#define MACHINE_REGIMM 0x01
+#define MACHINE_SPECIAL2 0x1C
+
+typedef enum Format Format;
+typedef struct Mnemonic Mnemonic;
+typedef struct Encoding Encoding;
+
+enum Format
+{
+    /// @brief "rd, rs, rt"
+    FORMAT_R,
+
+    /// @brief "rt, rs, immediate"
+    FORMAT_I,
+
+    /// @brief "rs, rt, address"
+    FORMAT_BRANCH,
+
+    /// @brief "address"
+    FORMAT_JUMP,
+
+    /// @brief "rs"
+    FORMAT_REGISTER,
+
+    /// @brief No arguments
+    FORMAT_NONE,
+
+    /// @brief "rt, offset(rs)"
+    FORMAT_MEMORY,
+
+    /// @brief "rd, rt, amount"
+    FORMAT_SHIFT,
+
+    /// @brief "rd, rt, rs", shifting by the low 5 bits of rs
+    FORMAT_SHIFT_VARIABLE,
+
+    /// @brief "rs, rt", with the result in HI and LO
+    FORMAT_PAIR,
+
+    /// @brief "rd"
+    FORMAT_DESTINATION,
+
+    /// @brief "rd, rs"
+    FORMAT_UNARY,
+
+    /// @brief "rd, rs" or just "rs", where rd is $ra
+    FORMAT_LINK,
+
+    /// @brief "rt, immediate"
+    FORMAT_UPPER,
+
+    /// @brief "rs, address", comparing rs against zero
+    FORMAT_BRANCH_ZERO,
+};
+
+struct Mnemonic
+{
+    const char *tag;
+    Opcode opcode;
+    Format format;
+};
+
+/// @brief Where an instruction is told apart from the others in its machine word.
+struct Encoding
+{
+    /// @brief Bits 31 to 26 of the word.
+    uint8_t opcode;
+
+    /// @brief Bits 5 to 0 of SPECIAL and SPECIAL2 instructions, or the rt field of REGIMM ones.
+    uint8_t function;
+};
+
+/// @brief Every instruction of includes/keywords.def, indexed by its opcode.
+static const Mnemonic MNEMONICS[OPCODE_COUNT] = {
+#define MNEMONIC(name, format) [OPCODE_##name] = {#name, OPCODE_##name, format},
+#define REGISTER(name, number)
+#include "keywords.def"
+#undef MNEMONIC
+#undef REGISTER
+};
+
+/// @brief Machine encoding of every instruction, NOP being the all zero word of "SLL $zero, $zero, 0".
+static const Encoding ENCODINGS[OPCODE_COUNT] = {
+    [OPCODE_SLL] = {MACHINE_SPECIAL, 0x00},
+    [OPCODE_SRL] = {MACHINE_SPECIAL, 0x02},
+    [OPCODE_SRA] = {MACHINE_SPECIAL, 0x03},
+    [OPCODE_SLLV] = {MACHINE_SPECIAL, 0x04},
+    [OPCODE_SRLV] = {MACHINE_SPECIAL, 0x06},
+    [OPCODE_SRAV] = {MACHINE_SPECIAL, 0x07},
+    [OPCODE_JR] = {MACHINE_SPECIAL, 0x08},
+    [OPCODE_JALR] = {MACHINE_SPECIAL, 0x09},
+    [OPCODE_MOVZ] = {MACHINE_SPECIAL, 0x0A},
+    [OPCODE_MOVN] = {MACHINE_SPECIAL, 0x0B},
+    [OPCODE_SYSCALL] = {MACHINE_SPECIAL, 0x0C},
+    [OPCODE_MFHI] = {MACHINE_SPECIAL, 0x10},
+    [OPCODE_MTHI] = {MACHINE_SPECIAL, 0x11},
+    [OPCODE_MFLO] = {MACHINE_SPECIAL, 0x12},
+    [OPCODE_MTLO] = {MACHINE_SPECIAL, 0x13},
+    [OPCODE_MULT] = {MACHINE_SPECIAL, 0x18},
+    [OPCODE_MULTU] = {MACHINE_SPECIAL, 0x19},
+    [OPCODE_DIV] = {MACHINE_SPECIAL, 0x1A},
+    [OPCODE_DIVU] = {MACHINE_SPECIAL, 0x1B},
+    [OPCODE_ADD] = {MACHINE_SPECIAL, 0x20},
+    [OPCODE_ADDU] = {MACHINE_SPECIAL, 0x21},
+    [OPCODE_SUB] = {MACHINE_SPECIAL, 0x22},
+    [OPCODE_SUBU] = {MACHINE_SPECIAL, 0x23},
+    [OPCODE_AND] = {MACHINE_SPECIAL, 0x24},
+    [OPCODE_OR] = {MACHINE_SPECIAL, 0x25},
+    [OPCODE_XOR] = {MACHINE_SPECIAL, 0x26},
+    [OPCODE_NOR] = {MACHINE_SPECIAL, 0x27},
+    [OPCODE_SLT] = {MACHINE_SPECIAL, 0x2A},
+    [OPCODE_SLTU] = {MACHINE_SPECIAL, 0x2B},
+    [OPCODE_BLTZ] = {MACHINE_REGIMM, 0x00},
+    [OPCODE_BGEZ] = {MACHINE_REGIMM, 0x01},
+    [OPCODE_BLTZAL] = {MACHINE_REGIMM, 0x10},
+    [OPCODE_BGEZAL] = {MACHINE_REGIMM, 0x11},
+    [OPCODE_J] = {0x02, 0},
+    [OPCODE_JAL] = {0x03, 0},
+    [OPCODE_BEQ] = {0x04, 0},
+    [OPCODE_BNE] = {0x05, 0},
+    [OPCODE_BLEZ] = {0x06, 0},
+    [OPCODE_BGTZ] = {0x07, 0},
+    [OPCODE_ADDI] = {0x08, 0},
+    [OPCODE_ADDIU] = {0x09, 0},
+    [OPCODE_SLTI] = {0x0A, 0},
+    [OPCODE_SLTIU] = {0x0B, 0},
+    [OPCODE_ANDI] = {0x0C, 0},
+    [OPCODE_ORI] = {0x0D, 0},
+    [OPCODE_XORI] = {0x0E, 0},
+    [OPCODE_LUI] = {0x0F, 0},
+    [OPCODE_MADD] = {MACHINE_SPECIAL2, 0x00},
+    [OPCODE_MADDU] = {MACHINE_SPECIAL2, 0x01},
+    [OPCODE_MUL] = {MACHINE_SPECIAL2, 0x02},
+    [OPCODE_MSUB] = {MACHINE_SPECIAL2, 0x04},
+    [OPCODE_MSUBU] = {MACHINE_SPECIAL2, 0x05},
+    [OPCODE_CLZ] = {MACHINE_SPECIAL2, 0x20},
+    [OPCODE_CLO] = {MACHINE_SPECIAL2, 0x21},
+    [OPCODE_LB] = {0x20, 0},
+    [OPCODE_LH] = {0x21, 0},
+    [OPCODE_LWL] = {0x22, 0},
+    [OPCODE_LW] = {0x23, 0},
+    [OPCODE_LBU] = {0x24, 0},
+    [OPCODE_LHU] = {0x25, 0},
+    [OPCODE_LWR] = {0x26, 0},
+    [OPCODE_SB] = {0x28, 0},
+    [OPCODE_SH] = {0x29, 0},
+    [OPCODE_SWL] = {0x2A, 0},
+    [OPCODE_SW] = {0x2B, 0},
+    [OPCODE_SWR] = {0x2E, 0},
+};
+
+static const Mnemonic *find_mnemonic(uint8_t opcode);
+static const Mnemonic *find_encoding(uint8_t opcode, uint8_t function);
+static bool is_logical(uint8_t opcode);
+static int count_arguments(Format format);
+static bool decode_registers(const Slice *arguments, int length, uint8_t **registers, FILE *output);
+static bool decode_address(Slice argument, Instruction *instruction, Slice *symbol, FILE *output);
+static bool decode_value(Slice argument, int32_t *number, Slice *symbol, const char *error, FILE *output);
+static uint32_t encode_r(const Encoding *encoding, uint8_t rs, uint8_t rt, uint8_t rd, uint8_t amount);
+static uint32_t encode_i(uint8_t opcode, uint8_t rs, uint8_t rt, uint16_t immediate);
+static bool encode_branch(uint8_t opcode, uint8_t rs, uint8_t rt, int32_t target, uint32_t program_counter, uint32_t *word);
+static bool encode_jump(uint8_t opcode, const Instruction *instruction, uint32_t program_counter, uint32_t *word);
+
+/// @brief Decodes a line of assembly, without any label or comment around it.
+///
+/// The line is only read, never written to. When symbol is not NULL, the immediate, address or offset
+/// may also be a label, which is returned in symbol for the caller to resolve and leaves the immediate
+/// as 0. Otherwise symbol is left with a NULL start.
+bool decode_instruction(Slice line, Instruction *instruction, Slice *symbol, FILE *output)
+{
+    if (symbol != NULL)
+    {
+        *symbol = (Slice){NULL, 0};
+    }
+
+    // Gets the instruction tag
+    Slice rest = line;
+    Slice tag = next_word(&rest);
+    if (tag.length == 0)
+    {
+        fprintf(output, "ERRO: Nenhuma tag fornecida\n");
+        return false;
+    }
+
+    // Gets the instruction arguments, rest is left with a NULL start after the last one
+    int args_length = 0;
+    Slice args[INSTRUCTION_ARGS] = {0};
+    while (rest.start != NULL && rest.length > 0)
+    {
+        if (args_length >= INSTRUCTION_ARGS)
+        {
+            fprintf(output, "ERRO: Foram providos mais argumentos do que os %d permitidos\n", INSTRUCTION_ARGS);
+            return false;
+        }
+
+        args[args_length] = split_slice(&rest, ',');
+        args_length++;
+    }
+
+    const Keyword *keyword = find_keyword(tag.start, tag.length);
+    if (keyword == NULL || keyword->kind != KEYWORD_MNEMONIC)
+    {
+        fprintf(output, "ERRO: \"%.*s\" não é uma tag válida\n", (int)tag.length, tag.start);
+        return false;
+    }
+
+    const Mnemonic *mnemonic = &MNEMONICS[keyword->value];
+
+    // JALR may leave rd out
+    int expected = count_arguments(mnemonic->format);
+    if (args_length != expected && !(mnemonic->format == FORMAT_LINK && args_length == 1))
+    {
+        fprintf(output, "ERRO: Quantidade inesperada de argumetos, eram esperados %d e foram recebidos %d\n", expected, args_length);
+        return false;
+    }
+
+    *instruction = (Instruction){.opcode = mnemonic->opcode};
+
+    switch (mnemonic->format)
+    {
+    case FORMAT_R:
+        return decode_registers(args, 3, (uint8_t *[]){&instruction->rd, &instruction->rs, &instruction->rt}, output);
+    case FORMAT_I:
+        return decode_registers(args, 2, (uint8_t *[]){&instruction->rt, &instruction->rs}, output) &&
+               decode_value(args[2], &instruction->immediate, symbol, "número imediato inválido", output);
+    case FORMAT_BRANCH:
+        return decode_registers(args, 2, (uint8_t *[]){&instruction->rs, &instruction->rt}, output) &&
+               decode_value(args[2], &instruction->immediate, symbol, "número imediato inválido", output);
+    case FORMAT_JUMP:
+        return decode_value(args[0], &instruction->immediate, symbol, "endereço inválido", output);
+    case FORMAT_REGISTER:
+        return decode_registers(args, 1, (uint8_t *[]){&instruction->rs}, output);
+    case FORMAT_NONE:
+        return true;
+    case FORMAT_MEMORY:
+        return decode_registers(args, 1, (uint8_t *[]){&instruction->rt}, output) && decode_address(args[1], instruction, symbol, output);
+    case FORMAT_SHIFT:
+        if (!decode_registers(args, 2, (uint8_t *[]){&instruction->rd, &instruction->rt}, output) ||
+            !decode_value(args[2], &instruction->immediate, NULL, "deslocamento inválido", output))
+        {
+            return false;
+        }
+        if (instruction->immediate < 0 || instruction->immediate > 31)
+        {
+            fprintf(output, "ERRO: Instrução inválida, o deslocamento deve estar entre 0 e 31\n");
+            return false;
+        }
+        return true;
+    case FORMAT_SHIFT_VARIABLE:
+        return decode_registers(args, 3, (uint8_t *[]){&instruction->rd, &instruction->rt, &instruction->rs}, output);
+    case FORMAT_PAIR:
+        return decode_registers(args, 2, (uint8_t *[]){&instruction->rs, &instruction->rt}, output);
+    case FORMAT_DESTINATION:
+        return decode_registers(args, 1, (uint8_t *[]){&instruction->rd}, output);
+    case FORMAT_UNARY:
+        return decode_registers(args, 2, (uint8_t *[]){&instruction->rd, &instruction->rs}, output);
+    case FORMAT_LINK:
+        if (args_length == 1)
+        {
+            instruction->rd = REGISTER_RA;
+            return decode_registers(args, 1, (uint8_t *[]){&instruction->rs}, output);
+        }
+        return decode_registers(args, 2, (uint8_t *[]){&instruction->rd, &instruction->rs}, output);
+    case FORMAT_UPPER:
+        return decode_registers(args, 1, (uint8_t *[]){&instruction->rt}, output) &&
+               decode_value(args[1], &instruction->immediate, symbol, "número imediato inválido", output);
+    case FORMAT_BRANCH_ZERO:
+        return decode_registers(args, 1, (uint8_t *[]){&instruction->rs}, output) &&
+               decode_value(args[1], &instruction->immediate, symbol, "número imediato inválido", output);
+    }
+
+    return false;
+}
+
+/// @brief Decodes a machine word, failing for encodings no instruction has or that set fields it leaves unused.
+bool decode_word(uint32_t word, uint32_t program_counter, Instruction *instruction)
+{
+    uint8_t opcode = word >> 26;
+    uint8_t rs = (word >> 21) & 0x1F;
+    uint8_t rt = (word >> 16) & 0x1F;
+    uint8_t rd = (word >> 11) & 0x1F;
+    uint8_t amount = (word >> 6) & 0x1F;
+    uint8_t funct = word & 0x3F;
+    int32_t immediate = (int16_t)(word & 0xFFFF);
+
+    // Branch offsets count words from the instruction after the branch
+    int32_t branch_target = program_counter + 4 + immediate * 4;
+    int32_t jump_target = ((program_counter + 4) & 0xF0000000) | ((word & 0x03FFFFFF) << 2);
+
+    *instruction = (Instruction){.opcode = OPCODE_EMPTY};
+
+    if (word == 0)
+    {
+        instruction->opcode = OPCODE_NOP;
+        return true;
+    }
+
+    uint8_t function = opcode == MACHINE_SPECIAL || opcode == MACHINE_SPECIAL2 ? funct : opcode == MACHINE_REGIMM ? rt : 0;
+    const Mnemonic *mnemonic = find_encoding(opcode, function);
+    if (mnemonic == NULL)
+    {
+        return false;
+    }
+
+    Instruction decoded = {.opcode = mnemonic->opcode};
+    bool valid = true;
+
+    switch (mnemonic->format)
+    {
+    case FORMAT_R:
+        decoded.rd = rd;
+        decoded.rs = rs;
+        decoded.rt = rt;
+        valid = amount == 0;
+        break;
+    case FORMAT_SHIFT:
+        decoded.rd = rd;
+        decoded.rt = rt;
+        decoded.immediate = amount;
+        valid = rs == 0;
+        break;
+    case FORMAT_SHIFT_VARIABLE:
+        decoded.rd = rd;
+        decoded.rt = rt;
+        decoded.rs = rs;
+        valid = amount == 0;
+        break;
+    case FORMAT_PAIR:
+        decoded.rs = rs;
+        decoded.rt = rt;
+        valid = rd == 0 && amount == 0;
+        break;
+    case FORMAT_DESTINATION:
+        decoded.rd = rd;
+        valid = rs == 0 && rt == 0 && amount == 0;
+        break;
+    case FORMAT_REGISTER:
+        decoded.rs = rs;
+        valid = rt == 0 && rd == 0;
+        break;
+    case FORMAT_UNARY:
+        // MIPS32 repeats rd in rt
+        decoded.rd = rd;
+        decoded.rs = rs;
+        valid = rt == rd && amount == 0;
+        break;
+    case FORMAT_LINK:
+        decoded.rd = rd;
+        decoded.rs = rs;
+        valid = rt == 0;
+        break;
+    case FORMAT_I:
+        decoded.rt = rt;
+        decoded.rs = rs;
+        // Logical immediates are zero extended
+        decoded.immediate = is_logical(decoded.opcode) ? (int32_t)(word & 0xFFFF) : immediate;
+        break;
+    case FORMAT_UPPER:
+        decoded.rt = rt;
+        decoded.immediate = word & 0xFFFF;
+        valid = rs == 0;
+        break;
+    case FORMAT_BRANCH:
+        decoded.rs = rs;
+        decoded.rt = rt;
+        decoded.immediate = branch_target;
+        // BLEZ and BGTZ compare rs against rt, which is always $zero in the machine form
+        valid = rt == REGISTER_ZERO || decoded.opcode == OPCODE_BEQ || decoded.opcode == OPCODE_BNE;
+        break;
+    case FORMAT_BRANCH_ZERO:
+        decoded.rs = rs;
+        decoded.immediate = branch_target;
+        break;
+    case FORMAT_JUMP:
+        decoded.immediate = jump_target;
+        break;
+    case FORMAT_MEMORY:
+        decoded.rs = rs;
+        decoded.rt = rt;
+        decoded.immediate = immediate;
+        break;
+    case FORMAT_NONE:
+        // The code field of SYSCALL is only meant for the kernel that handles it, and is ignored
+        break;
+    }
+
+    if (!valid)
+    {
+        return false;
+    }
+
+    *instruction = decoded;
+    return true;
+}
+
+/// @brief Packs an instruction into its 32-bit machine word, failing when it has no such encoding.
+///
+/// Text instructions accept any 32-bit immediate and address, so they do not always fit: ADDI, ADDIU,
+/// SLTI and SLTIU need a signed 16-bit immediate, ANDI, ORI, XORI and LUI an unsigned one, branches
+/// a target within 128 KiB and jumps one inside the same 256 MiB region. BLEZ and BGTZ can only
+/// compare against $zero, and loads and stores need a signed 16-bit offset.
+bool encode_instruction(const Instruction *instruction, uint32_t program_counter, uint32_t *word)
+{
+    if (instruction->opcode == OPCODE_RESERVED)
+    {
+        *word = instruction->immediate;
+        return true;
+    }
+
+    const Mnemonic *mnemonic = find_mnemonic(instruction->opcode);
+    if (mnemonic == NULL)
+    {
+        return false;
+    }
+
+    const Encoding *encoding = &ENCODINGS[instruction->opcode];
+    uint8_t rs = instruction->rs;
+    uint8_t rt = instruction->rt;
+    uint8_t rd = instruction->rd;
+    int32_t immediate = instruction->immediate;
+
+    switch (mnemonic->format)
+    {
+    case FORMAT_R:
+        *word = encode_r(encoding, rs, rt, rd, 0);
+        return true;
+    case FORMAT_SHIFT:
+        *word = encode_r(encoding, REGISTER_ZERO, rt, rd, immediate & 0x1F);
+        return immediate >= 0 && immediate <= 31;
+    case FORMAT_SHIFT_VARIABLE:
+        *word = encode_r(encoding, rs, rt, rd, 0);
+        return true;
+    case FORMAT_PAIR:
+        *word = encode_r(encoding, rs, rt, REGISTER_ZERO, 0);
+        return true;
+    case FORMAT_DESTINATION:
+        *word = encode_r(encoding, REGISTER_ZERO, REGISTER_ZERO, rd, 0);
+        return true;
+    case FORMAT_REGISTER:
+        *word = encode_r(encoding, rs, REGISTER_ZERO, REGISTER_ZERO, 0);
+        return true;
+    case FORMAT_UNARY:
+        *word = encode_r(encoding, rs, rd, rd, 0);
+        return true;
+    case FORMAT_LINK:
+        *word = encode_r(encoding, rs, REGISTER_ZERO, rd, 0);
+        return true;
+    case FORMAT_NONE:
+        *word = encode_r(encoding, REGISTER_ZERO, REGISTER_ZERO, REGISTER_ZERO, 0);
+        return true;
+    case FORMAT_I:
+        if (is_logical(instruction->opcode) ? immediate < 0 || immediate > UINT16_MAX
+                                            : immediate < INT16_MIN || immediate > INT16_MAX)
+        {
+            return false;
+        }
+        *word = encode_i(encoding->opcode, rs, rt, immediate);
+        return true;
+    case FORMAT_UPPER:
+        if (immediate < 0 || immediate > UINT16_MAX)
+        {
+            return false;
+        }
+        *word = encode_i(encoding->opcode, REGISTER_ZERO, rt, immediate);
+        return true;
+    case FORMAT_BRANCH:
+        if ((instruction->opcode == OPCODE_BLEZ || instruction->opcode == OPCODE_BGTZ) && rt != REGISTER_ZERO)
+        {
+            return false;
+        }
+        return encode_branch(encoding->opcode, rs, rt, immediate, program_counter, word);
+    case FORMAT_BRANCH_ZERO:
+        return encode_branch(encoding->opcode, rs, encoding->function, immediate, program_counter, word);
+    case FORMAT_JUMP:
+        return encode_jump(encoding->opcode, instruction, program_counter, word);
+    case FORMAT_MEMORY:
+        if (immediate < INT16_MIN || immediate > INT16_MAX)
+        {
+            return false;
+        }
+        *word = encode_i(encoding->opcode, rs, rt, immediate);
+        return true;
+    }
+
+    return false;
+}
+
+/// @brief Tag the opcode is written with, or NULL for OPCODE_EMPTY.
+const char *opcode_name(uint8_t opcode)
+{
+    if (opcode == OPCODE_RESERVED)
+    {
+        return "RESERVED";
+    }
+
+    const Mnemonic *mnemonic = find_mnemonic(opcode);
+    return mnemonic != NULL ? mnemonic->tag : NULL;
+}
+
+/// @brief Writes the instruction back as assembly that decode_instruction accepts.
+///
+/// A reserved instruction has none, and is written as the word it was loaded from.
+int disassemble_instruction(const Instruction *instruction, char *buffer, size_t size)
+{
+    if (instruction->opcode == OPCODE_RESERVED)
+    {
+        return snprintf(buffer, size, ".word 0x%08x", (uint32_t)instruction->immediate);
+    }
+
+    const Mnemonic *mnemonic = find_mnemonic(instruction->opcode);
+    if (mnemonic == NULL)
+    {
+        return snprintf(buffer, size, "???");
+    }
+
+    const char *rd = REGISTER_NAMES[instruction->rd];
+    const char *rs = REGISTER_NAMES[instruction->rs];
+    const char *rt = REGISTER_NAMES[instruction->rt];
+    int32_t immediate = instruction->immediate;
+
+    switch (mnemonic->format)
+    {
+    case FORMAT_R:
+        return snprintf(buffer, size, "%s %s, %s, %s", mnemonic->tag, rd, rs, rt);
+    case FORMAT_I:
+        return snprintf(buffer, size, "%s %s, %s, %d", mnemonic->tag, rt, rs, immediate);
+    case FORMAT_BRANCH:
+        return snprintf(buffer, size, "%s %s, %s, %d", mnemonic->tag, rs, rt, immediate);
+    case FORMAT_JUMP:
+        return snprintf(buffer, size, "%s %d", mnemonic->tag, immediate);
+    case FORMAT_REGISTER:
+        return snprintf(buffer, size, "%s %s", mnemonic->tag, rs);
+    case FORMAT_MEMORY:
+        return snprintf(buffer, size, "%s %s, %d(%s)", mnemonic->tag, rt, immediate, rs);
+    case FORMAT_SHIFT:
+        return snprintf(buffer, size, "%s %s, %s, %d", mnemonic->tag, rd, rt, immediate);
+    case FORMAT_SHIFT_VARIABLE:
+        return snprintf(buffer, size, "%s %s, %s, %s", mnemonic->tag, rd, rt, rs);
+    case FORMAT_PAIR:
+        return snprintf(buffer, size, "%s %s, %s", mnemonic->tag, rs, rt);
+    case FORMAT_DESTINATION:
+        return snprintf(buffer, size, "%s %s", mnemonic->tag, rd);
+    case FORMAT_UNARY:
+    case FORMAT_LINK:
+        return snprintf(buffer, size, "%s %s, %s", mnemonic->tag, rd, rs);
+    case FORMAT_UPPER:
+        return snprintf(buffer, size, "%s %s, %d", mnemonic->tag, rt, immediate);
+    case FORMAT_BRANCH_ZERO:
+        return snprintf(buffer, size, "%s %s, %d", mnemonic->tag, rs, immediate);
+    case FORMAT_NONE:
+    default:
+        return snprintf(buffer, size, "%s", mnemonic->tag);
+    }
+}
+
+static uint32_t encode_r(const Encoding *encoding, uint8_t rs, uint8_t rt, uint8_t rd, uint8_t amount)
+{
+    return (uint32_t)encoding->opcode << 26 | (uint32_t)rs << 21 | (uint32_t)rt << 16 | (uint32_t)rd << 11 |
+           (uint32_t)amount << 6 | encoding->function;
+}
+
+static uint32_t encode_i(uint8_t opcode, uint8_t rs, uint8_t rt, uint16_t immediate)
+{
+    return (uint32_t)opcode << 26 | (uint32_t)rs << 21 | (uint32_t)rt << 16 | immediate;
+}
+
+static bool encode_branch(uint8_t opcode, uint8_t rs, uint8_t rt, int32_t target, uint32_t program_counter, uint32_t *word)
+{
+    int64_t offset = (int64_t)(uint32_t)target - ((int64_t)program_counter + 4);
+
+    if (offset % 4 != 0 || offset / 4 < INT16_MIN || offset / 4 > INT16_MAX)
+    {
+        return false;
+    }
+
+    *word = encode_i(opcode, rs, rt, (uint16_t)(offset / 4));
+    return true;
+}
+
+static bool encode_jump(uint8_t opcode, const Instruction *instruction, uint32_t program_counter, uint32_t *word)
+{
+    uint32_t target = instruction->immediate;
+
+    if ((target & 3) != 0 || (target & 0xF0000000) != ((program_counter + 4) & 0xF0000000))
+    {
+        return false;
+    }
+
+    *word = (uint32_t)opcode << 26 | ((target >> 2) & 0x03FFFFFF);
+    return true;
+}
+
+static const Mnemonic *find_mnemonic(uint8_t opcode)
+{
+    return opcode < OPCODE_COUNT && MNEMONICS[opcode].tag != NULL ? &MNEMONICS[opcode] : NULL;
+}
+
+/// @brief Instruction with the given machine opcode and function, which is 0 for opcodes that have none.
+static const Mnemonic *find_encoding(uint8_t opcode, uint8_t function)
+{
+    for (unsigned int i = OPCODE_EMPTY + 1; i < OPCODE_COUNT; i++)
+    {
+        if (i != OPCODE_NOP && ENCODINGS[i].opcode == opcode && ENCODINGS[i].function == function)
+        {
+            return &MNEMONICS[i];
+        }
+    }
+
+    return NULL;
+}
+
+/// @brief Whether the immediate of the instruction is zero extended instead of sign extended.
+static bool is_logical(uint8_t opcode)
+{
+    return opcode == OPCODE_ANDI || opcode == OPCODE_ORI || opcode == OPCODE_XORI;
+}
+
+static int count_arguments(Format format)
+{
+    switch (format)
+    {
+    case FORMAT_NONE:
+        return 0;
+    case FORMAT_JUMP:
+    case FORMAT_REGISTER:
+    case FORMAT_DESTINATION:
+        return 1;
+    case FORMAT_MEMORY:
+    case FORMAT_PAIR:
+    case FORMAT_UNARY:
+    case FORMAT_LINK:
+    case FORMAT_UPPER:
+    case FORMAT_BRANCH_ZERO:
+        return 2;
+    default:
+        return 3;
+    }
+}
+
+static bool decode_registers(const Slice *arguments, int length, uint8_t **registers, FILE *output)
+{
+    for (int i = 0; i < length; i++)
+    {
+        const Keyword *keyword = find_keyword(arguments[i].start, arguments[i].length);
+        if (keyword == NULL || keyword->kind != KEYWORD_REGISTER)
+        {
+            fprintf(output, "ERRO: Instrução inválida, registrador não encontrado\n");
+            return false;
+        }
+        *registers[i] = keyword->value;
+    }
+
+    return true;
+}
+
+/// @brief Decodes "offset(rs)", where a missing offset is 0.
+static bool decode_address(Slice argument, Instruction *instruction, Slice *symbol, FILE *output)
+{
+    const char *base = memchr(argument.start, '(', argument.length);
+    if (base == NULL || argument.start[argument.length - 1] != ')')
+    {
+        fprintf(output, "ERRO: Instrução inválida, endereço de memória inválido\n");
+        return false;
+    }
+
+    const char *end = argument.start + argument.length - 1;
+    Slice offset = trim_slice((Slice){argument.start, base - argument.start});
+    Slice base_register = trim_slice((Slice){base + 1, end - (base + 1)});
+    if (!decode_registers(&base_register, 1, (uint8_t *[]){&instruction->rs}, output))
+    {
+        return false;
+    }
+
+    if (offset.length == 0)
+    {
+        instruction->immediate = 0;
+        return true;
+    }
+
+    return decode_value(offset, &instruction->immediate, symbol, "deslocamento inválido", output);
+}
+
+/// @brief Decodes a number, or a label when symbol is not NULL.
+static bool decode_value(Slice argument, int32_t *number, Slice *symbol, const char *error, FILE *output)
+{
+    if (symbol != NULL && is_label(argument.start, argument.length))
+    {
+        *symbol = argument;
+        *number = 0;
+        return true;
+    }
+
+    int64_t value;
+    if (!parse_integer(argument, INT32_MIN, INT32_MAX, &value))
+    {
+        fprintf(output, "ERRO: Instrução inválida, %s\n", error);
+        return false;
+    }
+
+    *number = value;
+    return true;
+}
+
+/// @brief Whether the word can name a label: a letter, "_" or "." followed by letters, digits, "_" or ".".
+bool is_label(const char *word, size_t length)
+{
+    if (length == 0 || (word[0] >= '0' && word[0] <= '9'))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+        char character = word[i];
+        if (!((character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z') ||
+              (character >= '0' && character <= '9') || character == '_' || character == '.'))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
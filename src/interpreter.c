@@ -0,0 +1,1399 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "interpreter.h"
+
+// Threaded dispatch relies on the labels as values extension, other compilers fall back to a switch
+#if !defined(__GNUC__) && !defined(DISPATCH_SWITCH)
+#define DISPATCH_SWITCH
+#endif
+
+static inline void addu(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = cpu->gpr[instruction->rs] + cpu->gpr[instruction->rt];
+}
+
+static inline void subu(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = cpu->gpr[instruction->rs] - cpu->gpr[instruction->rt];
+}
+
+static inline void mul(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = cpu->gpr[instruction->rs] * cpu->gpr[instruction->rt];
+}
+
+static inline void set_hi_lo(CPU *cpu, uint64_t value)
+{
+    cpu->hi = value >> 32;
+    cpu->lo = value;
+}
+
+static inline uint64_t get_hi_lo(const CPU *cpu)
+{
+    return (uint64_t)cpu->hi << 32 | cpu->lo;
+}
+
+static inline void mult(CPU *cpu, const Instruction *instruction)
+{
+    set_hi_lo(cpu, (int64_t)(int32_t)cpu->gpr[instruction->rs] * (int32_t)cpu->gpr[instruction->rt]);
+}
+
+static inline void multu(CPU *cpu, const Instruction *instruction)
+{
+    set_hi_lo(cpu, (uint64_t)cpu->gpr[instruction->rs] * cpu->gpr[instruction->rt]);
+}
+
+static inline void madd(CPU *cpu, const Instruction *instruction)
+{
+    set_hi_lo(cpu, get_hi_lo(cpu) + (int64_t)(int32_t)cpu->gpr[instruction->rs] * (int32_t)cpu->gpr[instruction->rt]);
+}
+
+static inline void maddu(CPU *cpu, const Instruction *instruction)
+{
+    set_hi_lo(cpu, get_hi_lo(cpu) + (uint64_t)cpu->gpr[instruction->rs] * cpu->gpr[instruction->rt]);
+}
+
+static inline void msub(CPU *cpu, const Instruction *instruction)
+{
+    set_hi_lo(cpu, get_hi_lo(cpu) - (int64_t)(int32_t)cpu->gpr[instruction->rs] * (int32_t)cpu->gpr[instruction->rt]);
+}
+
+static inline void msubu(CPU *cpu, const Instruction *instruction)
+{
+    set_hi_lo(cpu, get_hi_lo(cpu) - (uint64_t)cpu->gpr[instruction->rs] * cpu->gpr[instruction->rt]);
+}
+
+// The result of a division by zero is unpredictable on MIPS, here HI and LO are just left as they were
+static inline void _div(CPU *cpu, const Instruction *instruction)
+{
+    int32_t dividend = cpu->gpr[instruction->rs];
+    int32_t divisor = cpu->gpr[instruction->rt];
+
+    if (divisor == 0)
+    {
+        return;
+    }
+
+    // The only quotient that does not fit wraps around, as it does in hardware
+    if (dividend == INT32_MIN && divisor == -1)
+    {
+        cpu->lo = (uint32_t)INT32_MIN;
+        cpu->hi = 0;
+        return;
+    }
+
+    cpu->lo = dividend / divisor;
+    cpu->hi = dividend % divisor;
+}
+
+static inline void divu(CPU *cpu, const Instruction *instruction)
+{
+    uint32_t divisor = cpu->gpr[instruction->rt];
+
+    if (divisor != 0)
+    {
+        cpu->lo = cpu->gpr[instruction->rs] / divisor;
+        cpu->hi = cpu->gpr[instruction->rs] % divisor;
+    }
+}
+
+static inline void mfhi(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = cpu->hi;
+}
+
+static inline void mflo(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = cpu->lo;
+}
+
+static inline void mthi(CPU *cpu, const Instruction *instruction)
+{
+    cpu->hi = cpu->gpr[instruction->rs];
+}
+
+static inline void mtlo(CPU *cpu, const Instruction *instruction)
+{
+    cpu->lo = cpu->gpr[instruction->rs];
+}
+
+static inline void _and(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = cpu->gpr[instruction->rs] & cpu->gpr[instruction->rt];
+}
+
+static inline void _or(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = cpu->gpr[instruction->rs] | cpu->gpr[instruction->rt];
+}
+
+static inline void _xor(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = cpu->gpr[instruction->rs] ^ cpu->gpr[instruction->rt];
+}
+
+static inline void nor(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = ~(cpu->gpr[instruction->rs] | cpu->gpr[instruction->rt]);
+}
+
+static inline void slt(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = (int32_t)cpu->gpr[instruction->rs] < (int32_t)cpu->gpr[instruction->rt];
+}
+
+static inline void sltu(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = cpu->gpr[instruction->rs] < cpu->gpr[instruction->rt];
+}
+
+static inline void movz(CPU *cpu, const Instruction *instruction)
+{
+    if (cpu->gpr[instruction->rt] == 0)
+    {
+        cpu->gpr[instruction->rd] = cpu->gpr[instruction->rs];
+    }
+}
+
+static inline void movn(CPU *cpu, const Instruction *instruction)
+{
+    if (cpu->gpr[instruction->rt] != 0)
+    {
+        cpu->gpr[instruction->rd] = cpu->gpr[instruction->rs];
+    }
+}
+
+static inline void sll(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = cpu->gpr[instruction->rt] << instruction->immediate;
+}
+
+static inline void srl(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = cpu->gpr[instruction->rt] >> instruction->immediate;
+}
+
+static inline void sra(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = (int32_t)cpu->gpr[instruction->rt] >> instruction->immediate;
+}
+
+static inline void sllv(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = cpu->gpr[instruction->rt] << (cpu->gpr[instruction->rs] & 0x1F);
+}
+
+static inline void srlv(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = cpu->gpr[instruction->rt] >> (cpu->gpr[instruction->rs] & 0x1F);
+}
+
+static inline void srav(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rd] = (int32_t)cpu->gpr[instruction->rt] >> (cpu->gpr[instruction->rs] & 0x1F);
+}
+
+static inline void clz(CPU *cpu, const Instruction *instruction)
+{
+    uint32_t value = cpu->gpr[instruction->rs];
+    cpu->gpr[instruction->rd] = value != 0 ? __builtin_clz(value) : 32;
+}
+
+static inline void clo(CPU *cpu, const Instruction *instruction)
+{
+    uint32_t value = ~cpu->gpr[instruction->rs];
+    cpu->gpr[instruction->rd] = value != 0 ? __builtin_clz(value) : 32;
+}
+
+static inline void addiu(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rt] = cpu->gpr[instruction->rs] + instruction->immediate;
+}
+
+static inline void slti(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rt] = (int32_t)cpu->gpr[instruction->rs] < instruction->immediate;
+}
+
+static inline void sltiu(CPU *cpu, const Instruction *instruction)
+{
+    // The immediate is sign extended, then compared as unsigned
+    cpu->gpr[instruction->rt] = cpu->gpr[instruction->rs] < (uint32_t)instruction->immediate;
+}
+
+static inline void xori(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rt] = cpu->gpr[instruction->rs] ^ instruction->immediate;
+}
+
+static inline void lui(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rt] = (uint32_t)instruction->immediate << 16;
+}
+
+static inline void andi(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rt] = cpu->gpr[instruction->rs] & instruction->immediate;
+}
+
+static inline void ori(CPU *cpu, const Instruction *instruction)
+{
+    cpu->gpr[instruction->rt] = cpu->gpr[instruction->rs] | instruction->immediate;
+}
+
+static inline bool beq(CPU *cpu, const Instruction *instruction)
+{
+    return cpu->gpr[instruction->rs] == cpu->gpr[instruction->rt];
+}
+
+static inline bool bne(CPU *cpu, const Instruction *instruction)
+{
+    return cpu->gpr[instruction->rs] != cpu->gpr[instruction->rt];
+}
+
+static inline bool blez(CPU *cpu, const Instruction *instruction)
+{
+    return (int32_t)cpu->gpr[instruction->rs] <= (int32_t)cpu->gpr[instruction->rt];
+}
+
+static inline bool bgtz(CPU *cpu, const Instruction *instruction)
+{
+    return (int32_t)cpu->gpr[instruction->rs] > (int32_t)cpu->gpr[instruction->rt];
+}
+
+static inline bool bltz(CPU *cpu, const Instruction *instruction)
+{
+    return (int32_t)cpu->gpr[instruction->rs] < 0;
+}
+
+static inline bool bgez(CPU *cpu, const Instruction *instruction)
+{
+    return (int32_t)cpu->gpr[instruction->rs] >= 0;
+}
+
+// The condition is taken before linking, in case rs is $ra
+static inline bool bltzal(CPU *cpu, const Instruction *instruction, unsigned int return_address)
+{
+    bool taken = bltz(cpu, instruction);
+    cpu->gpr[REGISTER_RA] = return_address;
+    return taken;
+}
+
+static inline bool bgezal(CPU *cpu, const Instruction *instruction, unsigned int return_address)
+{
+    bool taken = bgez(cpu, instruction);
+    cpu->gpr[REGISTER_RA] = return_address;
+    return taken;
+}
+
+static inline bool lb(CPU *cpu, const Instruction *instruction)
+{
+    uint8_t value;
+    if (!load_byte(&cpu->memory, cpu->gpr[instruction->rs] + instruction->immediate, &value))
+    {
+        return false;
+    }
+
+    cpu->gpr[instruction->rt] = (int8_t)value;
+    return true;
+}
+
+static inline bool lbu(CPU *cpu, const Instruction *instruction)
+{
+    uint8_t value;
+    if (!load_byte(&cpu->memory, cpu->gpr[instruction->rs] + instruction->immediate, &value))
+    {
+        return false;
+    }
+
+    cpu->gpr[instruction->rt] = value;
+    return true;
+}
+
+static inline bool lh(CPU *cpu, const Instruction *instruction)
+{
+    uint16_t value;
+    if (!load_half(&cpu->memory, cpu->gpr[instruction->rs] + instruction->immediate, &value))
+    {
+        return false;
+    }
+
+    cpu->gpr[instruction->rt] = (int16_t)value;
+    return true;
+}
+
+static inline bool lhu(CPU *cpu, const Instruction *instruction)
+{
+    uint16_t value;
+    if (!load_half(&cpu->memory, cpu->gpr[instruction->rs] + instruction->immediate, &value))
+    {
+        return false;
+    }
+
+    cpu->gpr[instruction->rt] = value;
+    return true;
+}
+
+static inline bool lw(CPU *cpu, const Instruction *instruction)
+{
+    return load_word(&cpu->memory, cpu->gpr[instruction->rs] + instruction->immediate, &cpu->gpr[instruction->rt]);
+}
+
+static inline bool sb(CPU *cpu, const Instruction *instruction)
+{
+    return store_byte(&cpu->memory, cpu->gpr[instruction->rs] + instruction->immediate, cpu->gpr[instruction->rt]);
+}
+
+static inline bool sh(CPU *cpu, const Instruction *instruction)
+{
+    return store_half(&cpu->memory, cpu->gpr[instruction->rs] + instruction->immediate, cpu->gpr[instruction->rt]);
+}
+
+static inline bool sw(CPU *cpu, const Instruction *instruction)
+{
+    return store_word(&cpu->memory, cpu->gpr[instruction->rs] + instruction->immediate, cpu->gpr[instruction->rt]);
+}
+
+/// @brief Bytes from the address to the end of its word, counted the way the word is stored in memory.
+///
+/// LWL and SWL move these to or from the most significant end of the register, LWR and SWR move the
+/// rest of the word to or from the least significant end.
+static inline unsigned int unaligned_offset(const Memory *memory, uint32_t address)
+{
+    return memory->little_endian ? 3 - (address & 3) : address & 3;
+}
+
+static inline bool lwl(CPU *cpu, const Instruction *instruction)
+{
+    uint32_t address = cpu->gpr[instruction->rs] + instruction->immediate;
+    uint32_t word;
+    if (!load_word(&cpu->memory, address & ~3u, &word))
+    {
+        return false;
+    }
+
+    unsigned int shift = 8 * unaligned_offset(&cpu->memory, address);
+    uint32_t *value = &cpu->gpr[instruction->rt];
+    *value = word << shift | (*value & ((1u << shift) - 1));
+    return true;
+}
+
+static inline bool lwr(CPU *cpu, const Instruction *instruction)
+{
+    uint32_t address = cpu->gpr[instruction->rs] + instruction->immediate;
+    uint32_t word;
+    if (!load_word(&cpu->memory, address & ~3u, &word))
+    {
+        return false;
+    }
+
+    unsigned int shift = 8 * (3 - unaligned_offset(&cpu->memory, address));
+    uint32_t *value = &cpu->gpr[instruction->rt];
+    *value = word >> shift | (*value & ~(UINT32_MAX >> shift));
+    return true;
+}
+
+static inline bool swl(CPU *cpu, const Instruction *instruction)
+{
+    uint32_t address = cpu->gpr[instruction->rs] + instruction->immediate;
+    uint32_t word;
+    if (!load_word(&cpu->memory, address & ~3u, &word))
+    {
+        return false;
+    }
+
+    unsigned int shift = 8 * unaligned_offset(&cpu->memory, address);
+    word = cpu->gpr[instruction->rt] >> shift | (word & ~(UINT32_MAX >> shift));
+    return store_word(&cpu->memory, address & ~3u, word);
+}
+
+static inline bool swr(CPU *cpu, const Instruction *instruction)
+{
+    uint32_t address = cpu->gpr[instruction->rs] + instruction->immediate;
+    uint32_t word;
+    if (!load_word(&cpu->memory, address & ~3u, &word))
+    {
+        return false;
+    }
+
+    unsigned int shift = 8 * (3 - unaligned_offset(&cpu->memory, address));
+    word = cpu->gpr[instruction->rt] << shift | (word & ((1u << shift) - 1));
+    return store_word(&cpu->memory, address & ~3u, word);
+}
+
+static inline void jal(CPU *cpu, unsigned int return_address)
+{
+    cpu->gpr[REGISTER_RA] = return_address;
+}
+
+/// @brief Links rd and returns the target, read first in case rd is rs.
+static inline unsigned int jalr(CPU *cpu, const Instruction *instruction, unsigned int return_address)
+{
+    unsigned int target = cpu->gpr[instruction->rs];
+    cpu->gpr[instruction->rd] = return_address;
+    return target;
+}
+
+/// @brief Carries out any branch or jump followed by a delay slot, returning where it goes once the slot
+/// executes, which is following, the address after the slot, when it is not taken. Kept out of
+/// run_program, where its switch would crowd the registers of every other handler.
+__attribute__((noinline)) static unsigned int delayed_branch(CPU *cpu, const Instruction *instruction,
+                                                             unsigned int following, bool *taken)
+{
+    switch (instruction->opcode)
+    {
+    case OPCODE_BEQ:
+        *taken = beq(cpu, instruction);
+        break;
+    case OPCODE_BNE:
+        *taken = bne(cpu, instruction);
+        break;
+    case OPCODE_BLEZ:
+        *taken = blez(cpu, instruction);
+        break;
+    case OPCODE_BGTZ:
+        *taken = bgtz(cpu, instruction);
+        break;
+    case OPCODE_BLTZ:
+        *taken = bltz(cpu, instruction);
+        break;
+    case OPCODE_BGEZ:
+        *taken = bgez(cpu, instruction);
+        break;
+    case OPCODE_BLTZAL:
+        *taken = bltzal(cpu, instruction, following);
+        break;
+    case OPCODE_BGEZAL:
+        *taken = bgezal(cpu, instruction, following);
+        break;
+    case OPCODE_JAL:
+        jal(cpu, following);
+        *taken = true;
+        break;
+    case OPCODE_JR:
+        *taken = true;
+        return cpu->gpr[instruction->rs];
+    case OPCODE_JALR:
+        *taken = true;
+        return jalr(cpu, instruction, following);
+    default:
+        *taken = true;
+        break;
+    }
+
+    return *taken ? (unsigned int)instruction->immediate : following;
+}
+
+/// @brief Reports why the instruction at program_counter could not execute, raising the exception it
+/// takes if it is one. Kept out of run_program, which only gets here once execution stops.
+__attribute__((noinline, cold)) static void report_fault(CPU *cpu, const Instruction *instruction,
+                                                          unsigned int program_counter, bool delay_slot, FILE *output)
+{
+    switch (instruction->opcode)
+    {
+    case OPCODE_SYSCALL:
+        print_syscall_fault(cpu, output);
+        return;
+    case OPCODE_ADD:
+    case OPCODE_ADDI:
+    case OPCODE_SUB:
+        raise_exception(cpu, EXCEPTION_OVERFLOW, program_counter, delay_slot, 0);
+        break;
+    case OPCODE_RESERVED:
+        raise_exception(cpu, EXCEPTION_RESERVED, program_counter, delay_slot, 0);
+        break;
+    default:
+        // Loads and stores, which only raise an exception for an address they cannot access as a whole,
+        // and otherwise failed to allocate memory
+        if (cpu->memory.fault != MEMORY_MISALIGNED)
+        {
+            print_memory_fault(&cpu->memory, output);
+            return;
+        }
+
+        uint8_t opcode = instruction->opcode;
+        bool store = opcode == OPCODE_SB || opcode == OPCODE_SH || opcode == OPCODE_SW;
+        raise_exception(cpu, store ? EXCEPTION_ADDRESS_STORE : EXCEPTION_ADDRESS_LOAD, program_counter, delay_slot,
+                        cpu->memory.fault_address);
+        break;
+    }
+
+    print_exception(cpu, output);
+}
+
+/*
+ * Programs run one translated block at a time. Inside a block, the same handler bodies are compiled
+ * either as a switch inside a loop, or as direct threaded code (-DDISPATCH_SWITCH selects the
+ * former): every operation of the block stores the address of its handler, so each handler jumps
+ * straight into the next one through its own indirect branch. Leaving a block follows the successor
+ * linked to it the first time, and only looks the next block up in the cache when there is none.
+ *
+ * With an undo log, blocks are translated again so every operation goes through a BLOCK_RECORD
+ * handler, which saves what the instruction is about to overwrite and then executes it. The other
+ * handlers never check for an undo log, so execution without one costs the same as before.
+ *
+ * A pipeline model is handed every block once the next one is entered, which tells where the
+ * block went, so timing costs a single check per block entry when it is off.
+ *
+ * With delay slots, a block that ends in a branch or jump also holds the instruction after it. The
+ * branch goes through BLOCK_DELAYED_BRANCH instead of its own handler, which leaves the target in
+ * CPU.program_counter and carries on into the slot, followed by a BLOCK_BRANCH_END that leaves for
+ * real. Nothing checks for a pending branch after every instruction, and without delay slots the
+ * branch handlers are the same as ever.
+ *
+ * A syscall is carried out inside its handler, and one that exits leaves the block right after it,
+ * the same way a failed access leaves it right before the instruction.
+ *
+ * ADD, ADDI, SUB, misaligned loads and stores and reserved instructions raise exceptions. ADD, ADDI
+ * and SUB test for overflow inline, which compiles to a jo straight to the cold trap label, so the
+ * handlers only gain a branch that is never taken. Everything else happens in report_fault once
+ * execution has stopped.
+ */
+#ifdef DISPATCH_SWITCH
+#define HANDLER(kind) case kind:
+#define EXECUTE(opcode) \
+    kind = (opcode);    \
+    goto execute
+#define DISPATCH() continue
+#else
+#define HANDLER(kind) handle_##kind:
+#define EXECUTE(opcode) goto *handlers[(opcode)]
+#define DISPATCH() goto *operation->handler
+#endif
+
+#define RECORD_REGISTER(number) record_undo(undo, ADDRESS(operation), UNDO_REGISTER(number), cpu->gpr[(number)])
+
+#define TRACE(operation)                                                         \
+    if (trace != NULL)                                                           \
+    {                                                                            \
+        trace_instruction(trace, &(operation)->instruction, ADDRESS(operation)); \
+    }                                                                            \
+    cpu->gpr[REGISTER_ZERO] = 0
+
+#define NEXT(count)              \
+    operation += (count);        \
+    DISPATCH()
+
+#define ADDRESS(operation) (block->start + 4 * (unsigned int)((operation) - block->operations))
+
+#define LEAVE(target, taken)                         \
+    program_counter = (target);                      \
+    successor = &block->successors[(taken)];         \
+    goto chain
+
+#define BRANCH(condition, operation)                            \
+    if (condition)                                              \
+    {                                                           \
+        if (profile != NULL)                                    \
+        {                                                       \
+            profile->taken[(ADDRESS(operation) - base) >> 2]++; \
+        }                                                       \
+        LEAVE((operation)->instruction.immediate, 1);           \
+    }                                                           \
+    LEAVE(ADDRESS(operation) + 4, 0)
+
+// A branch that links, and is a call when taken
+#define CALL(condition, operation)                                                         \
+    if (condition)                                                                         \
+    {                                                                                      \
+        if (profile != NULL)                                                               \
+        {                                                                                  \
+            profile->taken[(ADDRESS(operation) - base) >> 2]++;                            \
+            profile_call(profile, ADDRESS(operation), (operation)->instruction.immediate); \
+        }                                                                                  \
+        LEAVE((operation)->instruction.immediate, 1);                                      \
+    }                                                                                      \
+    LEAVE(ADDRESS(operation) + 4, 0)
+
+// A load or store that returns whether it could access memory, and otherwise stops execution at itself
+// through trap
+#define ACCESS(access, operation)                \
+    if (!access(cpu, &(operation)->instruction)) \
+    {                                            \
+        goto trap;                               \
+    }                                            \
+    TRACE(operation);                            \
+    NEXT(1)
+
+// Writes the signed result to destination, or jumps to trap without writing it when it overflows
+#define OVERFLOW_CHECKED(overflows, left, right, destination, trap)                     \
+    {                                                                                   \
+        int32_t result;                                                                 \
+        if (__builtin_expect(overflows((int32_t)(left), (int32_t)(right), &result), 0)) \
+        {                                                                               \
+            goto trap;                                                                  \
+        }                                                                               \
+        (destination) = result;                                                         \
+    }
+
+#define ADD(instruction, trap)                                                                              \
+    OVERFLOW_CHECKED(__builtin_add_overflow, cpu->gpr[(instruction)->rs], cpu->gpr[(instruction)->rt],      \
+                      cpu->gpr[(instruction)->rd], trap)
+
+#define ADDI(instruction, trap)                                                                             \
+    OVERFLOW_CHECKED(__builtin_add_overflow, cpu->gpr[(instruction)->rs], (instruction)->immediate,         \
+                      cpu->gpr[(instruction)->rt], trap)
+
+#define SUB(instruction, trap)                                                                              \
+    OVERFLOW_CHECKED(__builtin_sub_overflow, cpu->gpr[(instruction)->rs], cpu->gpr[(instruction)->rt],      \
+                      cpu->gpr[(instruction)->rd], trap)
+
+// The second instruction of the pair overflows from trap_second, which moves on to it
+#define FUSED(first, second)                           \
+    first(&operation[0].instruction, trap);            \
+    TRACE(&operation[0]);                              \
+    second(&operation[1].instruction, trap_second);    \
+    TRACE(&operation[1]);                              \
+    NEXT(2)
+
+#define FUSED_BRANCH(first, branch)                                     \
+    first(&operation[0].instruction, trap);                             \
+    TRACE(&operation[0]);                                               \
+    TRACE(&operation[1]);                                               \
+    BRANCH(branch(cpu, &operation[1].instruction), &operation[1])
+
+/// @brief Runs until the program ends or stops, returning whether it paused at options->instruction_limit.
+bool run_program(CPU *cpu, Program *program, const Options *options)
+{
+    BlockCache *cache = &program->blocks;
+    Trace *trace = options->trace;
+    Profile *profile = options->profile;
+    UndoLog *undo = options->undo;
+    Pipeline *pipeline = options->pipeline;
+
+    if (profile != NULL && !reserve_profile(profile, program->length, cpu->program_counter))
+    {
+        profile = NULL;
+    }
+
+    // Compiled blocks cannot report the instructions they execute, nor record what they overwrite
+    bool compile = trace == NULL && profile == NULL && undo == NULL && pipeline == NULL && options->jit_threshold > 0;
+    bool watched = profile != NULL || pipeline != NULL;
+    uint8_t *link = NULL;
+    const Instruction *instructions = program->instructions;
+    unsigned int length = program->length;
+    unsigned int base = program->base;
+    unsigned int program_counter = cpu->program_counter;
+    unsigned int index;
+    uint64_t limit = options->instruction_limit != 0 ? options->instruction_limit : UINT64_MAX;
+    bool paused = false;
+
+    // Execution leaves blocks through lookup once CPU.instructions reaches the limit or the next checkpoint
+    uint64_t boundary = undo != NULL && undo->next_checkpoint < limit ? undo->next_checkpoint : limit;
+
+    Block *block;
+    Block **successor = NULL;
+    const BlockOperation *operation;
+
+#ifdef DISPATCH_SWITCH
+    const void *const *handlers = NULL;
+#else
+    static const void *const LABELS[HANDLER_COUNT] = {
+        [OPCODE_EMPTY] = &&handle_BLOCK_END,
+        [OPCODE_ADD] = &&handle_OPCODE_ADD,
+        [OPCODE_ADDU] = &&handle_OPCODE_ADDU,
+        [OPCODE_ADDI] = &&handle_OPCODE_ADDI,
+        [OPCODE_SUB] = &&handle_OPCODE_SUB,
+        [OPCODE_SUBU] = &&handle_OPCODE_SUBU,
+        [OPCODE_J] = &&handle_OPCODE_J,
+        [OPCODE_MULT] = &&handle_OPCODE_MULT,
+        [OPCODE_AND] = &&handle_OPCODE_AND,
+        [OPCODE_OR] = &&handle_OPCODE_OR,
+        [OPCODE_ANDI] = &&handle_OPCODE_ANDI,
+        [OPCODE_ORI] = &&handle_OPCODE_ORI,
+        [OPCODE_BEQ] = &&handle_OPCODE_BEQ,
+        [OPCODE_BNE] = &&handle_OPCODE_BNE,
+        [OPCODE_BLEZ] = &&handle_OPCODE_BLEZ,
+        [OPCODE_BGTZ] = &&handle_OPCODE_BGTZ,
+        [OPCODE_JAL] = &&handle_OPCODE_JAL,
+        [OPCODE_JR] = &&handle_OPCODE_JR,
+        [OPCODE_NOP] = &&handle_OPCODE_NOP,
+        [OPCODE_LB] = &&handle_OPCODE_LB,
+        [OPCODE_LBU] = &&handle_OPCODE_LBU,
+        [OPCODE_LH] = &&handle_OPCODE_LH,
+        [OPCODE_LHU] = &&handle_OPCODE_LHU,
+        [OPCODE_LW] = &&handle_OPCODE_LW,
+        [OPCODE_SB] = &&handle_OPCODE_SB,
+        [OPCODE_SH] = &&handle_OPCODE_SH,
+        [OPCODE_SW] = &&handle_OPCODE_SW,
+        [OPCODE_MUL] = &&handle_OPCODE_MUL,
+        [OPCODE_MULTU] = &&handle_OPCODE_MULTU,
+        [OPCODE_DIV] = &&handle_OPCODE_DIV,
+        [OPCODE_DIVU] = &&handle_OPCODE_DIVU,
+        [OPCODE_MADD] = &&handle_OPCODE_MADD,
+        [OPCODE_MADDU] = &&handle_OPCODE_MADDU,
+        [OPCODE_MSUB] = &&handle_OPCODE_MSUB,
+        [OPCODE_MSUBU] = &&handle_OPCODE_MSUBU,
+        [OPCODE_MFHI] = &&handle_OPCODE_MFHI,
+        [OPCODE_MFLO] = &&handle_OPCODE_MFLO,
+        [OPCODE_MTHI] = &&handle_OPCODE_MTHI,
+        [OPCODE_MTLO] = &&handle_OPCODE_MTLO,
+        [OPCODE_XOR] = &&handle_OPCODE_XOR,
+        [OPCODE_NOR] = &&handle_OPCODE_NOR,
+        [OPCODE_SLT] = &&handle_OPCODE_SLT,
+        [OPCODE_SLTU] = &&handle_OPCODE_SLTU,
+        [OPCODE_MOVZ] = &&handle_OPCODE_MOVZ,
+        [OPCODE_MOVN] = &&handle_OPCODE_MOVN,
+        [OPCODE_SLL] = &&handle_OPCODE_SLL,
+        [OPCODE_SRL] = &&handle_OPCODE_SRL,
+        [OPCODE_SRA] = &&handle_OPCODE_SRA,
+        [OPCODE_SLLV] = &&handle_OPCODE_SLLV,
+        [OPCODE_SRLV] = &&handle_OPCODE_SRLV,
+        [OPCODE_SRAV] = &&handle_OPCODE_SRAV,
+        [OPCODE_CLZ] = &&handle_OPCODE_CLZ,
+        [OPCODE_CLO] = &&handle_OPCODE_CLO,
+        [OPCODE_ADDIU] = &&handle_OPCODE_ADDIU,
+        [OPCODE_SLTI] = &&handle_OPCODE_SLTI,
+        [OPCODE_SLTIU] = &&handle_OPCODE_SLTIU,
+        [OPCODE_XORI] = &&handle_OPCODE_XORI,
+        [OPCODE_LUI] = &&handle_OPCODE_LUI,
+        [OPCODE_BLTZ] = &&handle_OPCODE_BLTZ,
+        [OPCODE_BGEZ] = &&handle_OPCODE_BGEZ,
+        [OPCODE_BLTZAL] = &&handle_OPCODE_BLTZAL,
+        [OPCODE_BGEZAL] = &&handle_OPCODE_BGEZAL,
+        [OPCODE_JALR] = &&handle_OPCODE_JALR,
+        [OPCODE_LWL] = &&handle_OPCODE_LWL,
+        [OPCODE_LWR] = &&handle_OPCODE_LWR,
+        [OPCODE_SWL] = &&handle_OPCODE_SWL,
+        [OPCODE_SWR] = &&handle_OPCODE_SWR,
+        [BLOCK_END] = &&handle_BLOCK_END,
+        [BLOCK_BRANCH_END] = &&handle_BLOCK_BRANCH_END,
+        [BLOCK_DELAYED_BRANCH] = &&handle_BLOCK_DELAYED_BRANCH,
+        [SUPER_ADDI_BEQ] = &&handle_SUPER_ADDI_BEQ,
+        [SUPER_ADDI_BNE] = &&handle_SUPER_ADDI_BNE,
+        [SUPER_ADDI_BLEZ] = &&handle_SUPER_ADDI_BLEZ,
+        [SUPER_ADDI_BGTZ] = &&handle_SUPER_ADDI_BGTZ,
+        [SUPER_SUB_BEQ] = &&handle_SUPER_SUB_BEQ,
+        [SUPER_SUB_BNE] = &&handle_SUPER_SUB_BNE,
+        [SUPER_SUB_BLEZ] = &&handle_SUPER_SUB_BLEZ,
+        [SUPER_SUB_BGTZ] = &&handle_SUPER_SUB_BGTZ,
+        [SUPER_ADD_ADD] = &&handle_SUPER_ADD_ADD,
+        [SUPER_ADDI_ADDI] = &&handle_SUPER_ADDI_ADDI,
+        [BLOCK_RECORD_RD] = &&handle_BLOCK_RECORD_RD,
+        [BLOCK_RECORD_RT] = &&handle_BLOCK_RECORD_RT,
+        [BLOCK_RECORD_RA] = &&handle_BLOCK_RECORD_RA,
+        [BLOCK_RECORD_STORE] = &&handle_BLOCK_RECORD_STORE,
+        [BLOCK_RECORD_HI_LO] = &&handle_BLOCK_RECORD_HI_LO,
+        [BLOCK_RECORD_NOTHING] = &&handle_BLOCK_RECORD_NOTHING,
+        [OPCODE_SYSCALL] = &&handle_OPCODE_SYSCALL,
+        [BLOCK_RECORD_SYSCALL] = &&handle_BLOCK_RECORD_SYSCALL,
+        [OPCODE_RESERVED] = &&handle_OPCODE_RESERVED,
+    };
+    const void *const *handlers = LABELS;
+#endif
+
+    // Compiled blocks only check the limit themselves when they were compiled for a bounded run
+    bool bounded = boundary != UINT64_MAX;
+    if (cache->jit.bounded != bounded)
+    {
+        flush_blocks(cache);
+        cache->jit.bounded = bounded;
+    }
+
+    // Blocks translated for the other mode do not, or needlessly, record what they execute
+    if (cache->recording != (undo != NULL))
+    {
+        flush_blocks(cache);
+        cache->recording = undo != NULL;
+    }
+
+    if (cache->delay_slots != program->delay_slots)
+    {
+        flush_blocks(cache);
+        cache->delay_slots = program->delay_slots;
+    }
+
+lookup:
+    if (cpu->instructions >= boundary)
+    {
+        if (cpu->instructions >= limit)
+        {
+            paused = true;
+            goto exit;
+        }
+
+        take_checkpoint(undo, cpu, program_counter);
+        boundary = undo->next_checkpoint < limit ? undo->next_checkpoint : limit;
+    }
+
+    // Addresses before the base wrap around and are out of the program as well
+    index = (program_counter - base) >> 2;
+    if (index >= length || (program_counter & 3) != 0)
+    {
+        goto outside;
+    }
+
+    if (index < cache->capacity && cache->blocks[index] != NULL)
+    {
+        block = cache->blocks[index];
+    }
+    else
+    {
+        block = translate_block(cache, instructions, length, base, program_counter, handlers);
+        if (block == NULL)
+        {
+            // Nothing is stored at this address yet
+            goto exit;
+        }
+    }
+
+    if (successor != NULL)
+    {
+        *successor = block;
+    }
+
+    // The compiled block that led here jumps straight into this one from now on, through its check of
+    // the limit if there is one
+    if (link != NULL && block->native != NULL)
+    {
+        jit_link(&cache->jit, link, block->native);
+    }
+    link = NULL;
+
+enter:
+    if (block->native != NULL)
+    {
+        goto native;
+    }
+
+    if (compile && ++block->executions == options->jit_threshold && jit_compile(&cache->jit, block))
+    {
+        goto native;
+    }
+
+    // Compiled blocks count their own instructions
+    cpu->instructions += block->length;
+
+    // Both only look at the block, and share a check so it is the only one when neither is on
+    if (watched)
+    {
+        if (profile != NULL)
+        {
+            profile_block(profile, (block->start - base) >> 2, block->length);
+        }
+
+        if (pipeline != NULL)
+        {
+            enter_pipeline(pipeline, block);
+        }
+    }
+
+    operation = block->operations;
+#ifdef DISPATCH_SWITCH
+    while (true)
+    {
+        uintptr_t kind = operation->kind;
+    execute:
+        switch (kind)
+        {
+#else
+    DISPATCH();
+#endif
+        HANDLER(OPCODE_ADD)
+            ADD(&operation->instruction, trap);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_ADDU)
+            addu(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_ADDI)
+            ADDI(&operation->instruction, trap);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_SUB)
+            SUB(&operation->instruction, trap);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_SUBU)
+            subu(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_MUL)
+            mul(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_AND)
+            _and(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_OR)
+            _or(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_ANDI)
+            andi(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_ORI)
+            ori(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_NOP)
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_LB)
+            ACCESS(lb, operation);
+        HANDLER(OPCODE_LBU)
+            ACCESS(lbu, operation);
+        HANDLER(OPCODE_LH)
+            ACCESS(lh, operation);
+        HANDLER(OPCODE_LHU)
+            ACCESS(lhu, operation);
+        HANDLER(OPCODE_LW)
+            ACCESS(lw, operation);
+        HANDLER(OPCODE_SB)
+            ACCESS(sb, operation);
+        HANDLER(OPCODE_SH)
+            ACCESS(sh, operation);
+        HANDLER(OPCODE_SW)
+            ACCESS(sw, operation);
+        HANDLER(OPCODE_BEQ)
+            TRACE(operation);
+            BRANCH(beq(cpu, &operation->instruction), operation);
+        HANDLER(OPCODE_BNE)
+            TRACE(operation);
+            BRANCH(bne(cpu, &operation->instruction), operation);
+        HANDLER(OPCODE_BLEZ)
+            TRACE(operation);
+            BRANCH(blez(cpu, &operation->instruction), operation);
+        HANDLER(OPCODE_BGTZ)
+            TRACE(operation);
+            BRANCH(bgtz(cpu, &operation->instruction), operation);
+        HANDLER(OPCODE_J)
+            TRACE(operation);
+            LEAVE(operation->instruction.immediate, 1);
+        HANDLER(OPCODE_JAL)
+            jal(cpu, ADDRESS(operation) + 4);
+            TRACE(operation);
+            if (profile != NULL)
+            {
+                profile_call(profile, ADDRESS(operation), operation->instruction.immediate);
+            }
+            LEAVE(operation->instruction.immediate, 1);
+        HANDLER(OPCODE_JR)
+            TRACE(operation);
+            // The target changes from one run to the next, so it is never linked
+            program_counter = cpu->gpr[operation->instruction.rs];
+            successor = NULL;
+            if (profile != NULL)
+            {
+                profile_return(profile, program_counter);
+            }
+            goto lookup;
+        HANDLER(BLOCK_END)
+            LEAVE(block->start + 4 * block->length, 0);
+        HANDLER(BLOCK_RECORD_RD)
+            RECORD_REGISTER(operation->instruction.rd);
+            EXECUTE(operation->instruction.opcode);
+        HANDLER(BLOCK_RECORD_RT)
+            RECORD_REGISTER(operation->instruction.rt);
+            EXECUTE(operation->instruction.opcode);
+        HANDLER(BLOCK_RECORD_RA)
+            RECORD_REGISTER(REGISTER_RA);
+            EXECUTE(operation->instruction.opcode);
+        HANDLER(BLOCK_RECORD_STORE)
+            record_store(undo, &cpu->memory, cpu->gpr[operation->instruction.rs] + operation->instruction.immediate,
+                         ADDRESS(operation));
+            EXECUTE(operation->instruction.opcode);
+        HANDLER(BLOCK_RECORD_HI_LO)
+            record_undo(undo, ADDRESS(operation), UNDO_HI_LO, get_hi_lo(cpu));
+            EXECUTE(operation->instruction.opcode);
+        HANDLER(BLOCK_RECORD_NOTHING)
+            record_undo(undo, ADDRESS(operation), UNDO_NOTHING, 0);
+            EXECUTE(operation->instruction.opcode);
+        HANDLER(SUPER_ADDI_BEQ)
+            FUSED_BRANCH(ADDI, beq);
+        HANDLER(SUPER_ADDI_BNE)
+            FUSED_BRANCH(ADDI, bne);
+        HANDLER(SUPER_ADDI_BLEZ)
+            FUSED_BRANCH(ADDI, blez);
+        HANDLER(SUPER_ADDI_BGTZ)
+            FUSED_BRANCH(ADDI, bgtz);
+        HANDLER(SUPER_SUB_BEQ)
+            FUSED_BRANCH(SUB, beq);
+        HANDLER(SUPER_SUB_BNE)
+            FUSED_BRANCH(SUB, bne);
+        HANDLER(SUPER_SUB_BLEZ)
+            FUSED_BRANCH(SUB, blez);
+        HANDLER(SUPER_SUB_BGTZ)
+            FUSED_BRANCH(SUB, bgtz);
+        HANDLER(SUPER_ADD_ADD)
+            FUSED(ADD, ADD);
+        HANDLER(SUPER_ADDI_ADDI)
+            FUSED(ADDI, ADDI);
+        HANDLER(OPCODE_MULT)
+            mult(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_MULTU)
+            multu(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_DIV)
+            _div(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_DIVU)
+            divu(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_MADD)
+            madd(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_MADDU)
+            maddu(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_MSUB)
+            msub(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_MSUBU)
+            msubu(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_MFHI)
+            mfhi(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_MFLO)
+            mflo(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_MTHI)
+            mthi(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_MTLO)
+            mtlo(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_XOR)
+            _xor(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_NOR)
+            nor(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_SLT)
+            slt(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_SLTU)
+            sltu(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_MOVZ)
+            movz(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_MOVN)
+            movn(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_SLL)
+            sll(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_SRL)
+            srl(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_SRA)
+            sra(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_SLLV)
+            sllv(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_SRLV)
+            srlv(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_SRAV)
+            srav(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_CLZ)
+            clz(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_CLO)
+            clo(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_ADDIU)
+            addiu(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_SLTI)
+            slti(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_SLTIU)
+            sltiu(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_XORI)
+            xori(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_LUI)
+            lui(cpu, &operation->instruction);
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(OPCODE_LWL)
+            ACCESS(lwl, operation);
+        HANDLER(OPCODE_LWR)
+            ACCESS(lwr, operation);
+        HANDLER(OPCODE_SWL)
+            ACCESS(swl, operation);
+        HANDLER(OPCODE_SWR)
+            ACCESS(swr, operation);
+        HANDLER(OPCODE_BLTZ)
+            TRACE(operation);
+            BRANCH(bltz(cpu, &operation->instruction), operation);
+        HANDLER(OPCODE_BGEZ)
+            TRACE(operation);
+            BRANCH(bgez(cpu, &operation->instruction), operation);
+        HANDLER(OPCODE_BLTZAL)
+            TRACE(operation);
+            CALL(bltzal(cpu, &operation->instruction, ADDRESS(operation) + 4), operation);
+        HANDLER(OPCODE_BGEZAL)
+            TRACE(operation);
+            CALL(bgezal(cpu, &operation->instruction, ADDRESS(operation) + 4), operation);
+        HANDLER(OPCODE_JALR)
+            program_counter = jalr(cpu, &operation->instruction, ADDRESS(operation) + 4);
+            TRACE(operation);
+            successor = NULL;
+            if (profile != NULL)
+            {
+                profile_call(profile, ADDRESS(operation), program_counter);
+            }
+            goto lookup;
+        HANDLER(BLOCK_DELAYED_BRANCH)
+        {
+            // Links the address after the slot, and keeps the target out of a local so none has to survive
+            // the handler of the slot
+            bool taken;
+            cpu->program_counter = delayed_branch(cpu, &operation->instruction, block->start + 4 * block->length, &taken);
+            TRACE(operation);
+            if (profile != NULL)
+            {
+                profile_delayed(profile, operation->instruction.opcode, (ADDRESS(operation) - base) >> 2, ADDRESS(operation),
+                                cpu->program_counter, taken);
+            }
+            NEXT(1);
+        }
+        HANDLER(BLOCK_BRANCH_END)
+            // JR and JALR two operations back are never linked
+            program_counter = cpu->program_counter;
+            if (operation[-2].instruction.opcode == OPCODE_JR || operation[-2].instruction.opcode == OPCODE_JALR)
+            {
+                successor = NULL;
+                goto lookup;
+            }
+            LEAVE(program_counter, program_counter != block->start + 4 * block->length);
+        HANDLER(OPCODE_SYSCALL)
+            switch (run_syscall(cpu, options->console, undo))
+            {
+            case SYSCALL_RETURNED:
+                break;
+            case SYSCALL_EXITED:
+                TRACE(operation);
+                operation++;
+                goto halt;
+            case SYSCALL_FAILED:
+                goto trap;
+            }
+            TRACE(operation);
+            NEXT(1);
+        HANDLER(BLOCK_RECORD_SYSCALL)
+            record_undo(undo, ADDRESS(operation), UNDO_SYSCALL,
+                        (uint64_t)cpu->heap_break << 32 | cpu->gpr[REGISTER_V0]);
+            EXECUTE(operation->instruction.opcode);
+        HANDLER(OPCODE_RESERVED)
+            goto trap;
+#ifdef DISPATCH_SWITCH
+        default:
+            goto exit;
+        }
+    }
+#endif
+
+chain:
+    if (*successor != NULL && cpu->instructions < boundary)
+    {
+        block = *successor;
+        goto enter;
+    }
+    goto lookup;
+
+// The program exited right before operation, and the rest of the block never executes
+halt:
+    cpu->instructions -= block->length - (operation - block->operations);
+    program_counter = ADDRESS(operation);
+    if (pipeline != NULL)
+    {
+        time_block(pipeline, block, operation - block->operations, program_counter);
+        pipeline->pending = NULL;
+    }
+    goto exit;
+
+native:
+{
+    JitExit exit = block->native(cpu, limit);
+    program_counter = exit.program_counter;
+    successor = NULL;
+
+    // Compiled blocks only trap on overflow, outside of delay slots, and have counted what retired
+    if (exit.link == JIT_TRAP)
+    {
+        raise_exception(cpu, EXCEPTION_OVERFLOW, program_counter, false, 0);
+        print_exception(cpu, options->output);
+        goto exit;
+    }
+
+    link = exit.link;
+    goto lookup;
+}
+
+// Fetching from an address that is not a word raises an exception, any other one out of the program
+// just stops it
+outside:
+    if ((program_counter & 3) != 0)
+    {
+        if (trace != NULL)
+        {
+            flush_trace(trace);
+        }
+        raise_exception(cpu, EXCEPTION_ADDRESS_LOAD, program_counter, false, program_counter);
+        print_exception(cpu, options->output);
+    }
+    goto exit;
+
+// The second instruction of a fused pair overflowed
+trap_second: __attribute__((cold));
+    operation++;
+
+// The instruction at operation failed, and neither it nor the rest of the block retires
+trap: __attribute__((cold));
+    cpu->instructions -= block->length - (operation - block->operations);
+    program_counter = ADDRESS(operation);
+    if (undo != NULL)
+    {
+        drop_undo(undo);
+    }
+
+    // Only the instructions before the one that faulted went through the pipeline
+    if (pipeline != NULL)
+    {
+        time_block(pipeline, block, operation - block->operations, program_counter);
+        pipeline->pending = NULL;
+    }
+
+    // Instructions traced before the fault come first
+    if (trace != NULL)
+    {
+        flush_trace(trace);
+    }
+    report_fault(cpu, &operation->instruction, program_counter,
+                 block->delayed && operation == &block->operations[block->length - 1], options->output);
+
+exit:
+    if (pipeline != NULL)
+    {
+        leave_pipeline(pipeline, program_counter);
+    }
+
+    cpu->program_counter = program_counter;
+    cpu->gpr[REGISTER_ZERO] = 0;
+
+    if (trace != NULL)
+    {
+        flush_trace(trace);
+    }
+
+    if (options->console != NULL)
+    {
+        flush_console(options->console);
+    }
+
+    return paused;
+}
+
+/// @brief Takes the CPU forwards or backwards to right before the given instruction executes.
+///
+/// Going backwards undoes the records, and once they run out replays from the newest checkpoint before
+/// the instruction. Going forwards runs up to the first block boundary after it and undoes the rest.
+/// Returns whether it got there, otherwise the CPU stays as close as the history or the program allow.
+bool seek_instruction(CPU *cpu, Program *program, const Options *options, uint64_t instructions)
+{
+    UndoLog *undo = options->undo;
+
+    while (cpu->instructions > instructions)
+    {
+        if (undo_instruction(undo, cpu))
+        {
+            continue;
+        }
+
+        // Short of the target, the oldest checkpoint is as far back as the history goes
+        if (!restore_checkpoint(undo, cpu, instructions) &&
+            (undo->checkpoint_count == 0 || undo->checkpoints[undo->oldest].instructions >= cpu->instructions ||
+             !restore_checkpoint(undo, cpu, undo->checkpoints[undo->oldest].instructions)))
+        {
+            return false;
+        }
+    }
+
+    if (cpu->instructions < instructions)
+    {
+        // Replaying is silent and has no input, and instructions run past the target are taken back
+        Options replay = *options;
+        replay.trace = NULL;
+        replay.profile = NULL;
+        replay.pipeline = NULL;
+        replay.console = NULL;
+        replay.instruction_limit = instructions;
+        run_program(cpu, program, &replay);
+
+        while (cpu->instructions > instructions && undo_instruction(undo, cpu))
+        {
+        }
+    }
+
+    return cpu->instructions == instructions;
+}
+
+/// @brief Runs backwards until right before the last time the instruction at address executed.
+///
+/// Each time the records run out, the stretch between the previous checkpoint and the earliest record
+/// is replayed to record it again. Returns whether address was reached before the history ran out.
+bool reverse_to(CPU *cpu, Program *program, const Options *options, unsigned int address)
+{
+    UndoLog *undo = options->undo;
+
+    while (true)
+    {
+        while (undo_instruction(undo, cpu))
+        {
+            if (cpu->program_counter == address)
+            {
+                return true;
+            }
+        }
+
+        uint64_t earliest = cpu->instructions;
+        if (earliest == 0 || !restore_checkpoint(undo, cpu, earliest - 1) ||
+            !seek_instruction(cpu, program, options, earliest))
+        {
+            return false;
+        }
+    }
+}
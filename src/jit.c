@@ -0,0 +1,879 @@
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "block.h"
+#include "jit.h"
+
+#if defined(__x86_64__)
+
+// Longest code a single instruction compiles to, so a block is only started when it fits
+#define MAX_INSTRUCTION_SIZE 32
+#define EXIT_SIZE 13
+#define COUNTER_SIZE 11
+#define LIMIT_SIZE 13
+#define LIMIT_STUB_SIZE 8
+#define TRAP_SIZE 7
+#define TRAP_EXIT_SIZE 30
+
+// Compiled blocks start at a multiple of this, so how fast a loop runs does not depend on where it lands
+#define BLOCK_ALIGNMENT 16
+
+#define REGISTER_OFFSET(index) ((int32_t)(offsetof(CPU, gpr) + 4 * (index)))
+#define HI_OFFSET ((int32_t)offsetof(CPU, hi))
+#define LO_OFFSET ((int32_t)offsetof(CPU, lo))
+
+// Host registers, as numbered in the reg field of ModRM
+#define HOST_EAX 0
+#define HOST_ECX 1
+#define HOST_EDX 2
+#define HOST_ESI 6
+
+typedef struct Emitter Emitter;
+
+struct Emitter
+{
+    uint8_t *code;
+    size_t used;
+
+    /// @brief Index in the block of the instruction being emitted.
+    unsigned int index;
+
+    /// @brief Offsets of the displacements of the jumps taken on overflow, and the index of the instruction
+    /// that takes each, filled in once the trap exit is emitted.
+    size_t traps[BLOCK_MAX_LENGTH + 1];
+    uint8_t trap_indices[BLOCK_MAX_LENGTH + 1];
+    unsigned int trap_count;
+
+    /// @brief Offset of the displacement of the jump taken at the limit, 0 if the block is unbounded.
+    size_t limit_jump;
+
+    /// @brief Register the host flags were set from by the instruction just emitted, REGISTER_ZERO if none.
+    uint8_t flags_register;
+
+    /// @brief The flags also compare flags_register against zero as a signed number, with OF clear.
+    bool flags_signed;
+};
+
+static bool is_supported(uint8_t opcode);
+static bool can_overflow(uint8_t opcode);
+static void emit_instruction(Emitter *emitter, const Instruction *instruction, unsigned int next,
+                             const Instruction *delay_slot);
+static void emit_branch(Emitter *emitter, const Instruction *instruction, uint8_t not_taken_jump, bool flags_set,
+                        unsigned int next, const Instruction *delay_slot);
+static void emit_zero_branch(Emitter *emitter, const Instruction *instruction, uint8_t not_taken_jump, bool link,
+                             bool flags_set, unsigned int next, const Instruction *delay_slot);
+static void emit_jump(Emitter *emitter, uint8_t not_taken_jump, const Instruction *delay_slot);
+static void emit_delay_slot(Emitter *emitter, const Instruction *delay_slot);
+static void emit_compare(Emitter *emitter, uint8_t condition);
+static void emit_limit(Emitter *emitter);
+static void emit_limit_stub(Emitter *emitter, uint32_t program_counter);
+static void emit_counter(Emitter *emitter, unsigned int length);
+static void emit_exit(Emitter *emitter, uint32_t program_counter);
+static void emit_trap(Emitter *emitter);
+static void emit_trap_exit(Emitter *emitter, unsigned int length, uint32_t start);
+static bool reuses_flags(const Instruction *instruction, uint8_t flags_register, bool flags_signed);
+static bool make_writable(uint8_t *start, size_t length);
+static void make_executable(uint8_t *start, size_t length);
+static void emit_byte(Emitter *emitter, uint8_t byte);
+static void emit_int(Emitter *emitter, int32_t value);
+static void emit_register(Emitter *emitter, uint8_t opcode, uint8_t index);
+static void emit_operand(Emitter *emitter, uint8_t opcode, uint8_t host, int32_t offset);
+
+/*
+ * Compiled blocks are called with the CPU in rdi and keep every guest register in memory, so each
+ * instruction becomes a load, one host ALU instruction with a memory operand and a store. Only rax,
+ * rcx, rdx and r8 are used, none of which the caller expects to be kept, so nothing has to be saved.
+ * Every way out of the block is an exit stub that returns the next address in eax and the stub's own
+ * address in rdx; once the block at that address is compiled too, the stub's first instruction is
+ * replaced by a jump straight into it.
+ *
+ * Compiled blocks jump straight into each other, so when execution is bounded each one is preceded by
+ * a check of CPU.instructions against the limit, kept in rsi, that returns to the interpreter without
+ * running the block once it is reached. Links jump to that check, while the interpreter, which has just
+ * checked the limit itself, calls the block past it. Unbounded blocks have no such check.
+ *
+ * A delay slot is compiled between its branch and the exits, with r8 keeping whether the branch is
+ * taken, or where a register jump goes, while it runs.
+ *
+ * ADD, ADDI and SUB are followed by a jo on the flags of the host instruction that computed them,
+ * to a two instruction entry that only sets cl to the index of the instruction in the block. Every
+ * entry leads to a single trap exit after the rest of the block, which takes back the instructions
+ * that did not retire and returns JIT_TRAP, so the block runs straight through when nothing overflows.
+ *
+ * A branch that compares the register the instruction before it just wrote against zero reuses the
+ * flags that instruction left, instead of loading the register again to compare it.
+ *
+ * The buffer is never writable and executable at once: it is mapped writable, and the pages a block is
+ * written to only become executable once it is done. Linking makes the page of the exit writable
+ * again just while the jump is patched in, which happens between blocks, so no code ever runs from
+ * a page that is being written.
+ */
+bool jit_compile(JitBuffer *buffer, Block *block)
+{
+    unsigned int traps = 0;
+    for (unsigned int i = 0; i < block->length; i++)
+    {
+        if (!is_supported(block->operations[i].instruction.opcode))
+        {
+            return false;
+        }
+        traps += can_overflow(block->operations[i].instruction.opcode);
+    }
+
+    // An overflow in a delay slot is reported at its branch, which is left to the interpreter
+    if (block->delayed && can_overflow(block->operations[block->length - 1].instruction.opcode))
+    {
+        return false;
+    }
+
+    if (buffer->memory == NULL)
+    {
+        void *memory = mmap(NULL, JIT_BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            return false;
+        }
+
+        buffer->memory = memory;
+        buffer->size = JIT_BUFFER_SIZE;
+        buffer->used = 0;
+    }
+
+    // Every instruction plus the alignment, the limit check and its stub, the instruction counter, the two
+    // exits of a conditional branch and the traps
+    size_t start = (buffer->used + BLOCK_ALIGNMENT - 1) & ~(size_t)(BLOCK_ALIGNMENT - 1);
+    size_t worst = LIMIT_SIZE + LIMIT_STUB_SIZE + COUNTER_SIZE + block->length * MAX_INSTRUCTION_SIZE + 2 * EXIT_SIZE +
+                   traps * TRAP_SIZE + TRAP_EXIT_SIZE;
+    if (start + worst > buffer->size || !make_writable(buffer->memory + start, worst))
+    {
+        return false;
+    }
+
+    Emitter emitter = {.code = buffer->memory + start, .used = 0, .flags_register = REGISTER_ZERO};
+    unsigned int next = block->start + 4 * block->length;
+
+    unsigned int length = block->delayed ? block->length - 1 : block->length;
+
+    if (buffer->bounded)
+    {
+        emit_limit(&emitter);
+    }
+    size_t entry = emitter.used;
+
+    emit_counter(&emitter, block->length);
+    for (unsigned int i = 0; i < length; i++)
+    {
+        const Instruction *delay_slot = block->delayed && i == length - 1 ? &block->operations[length].instruction : NULL;
+        emitter.index = i;
+        emit_instruction(&emitter, &block->operations[i].instruction, next, delay_slot);
+    }
+
+    // Blocks that do not end in a branch or jump fall through to the next address
+    if (!block->delayed && !ends_block(block->operations[block->length - 1].instruction.opcode))
+    {
+        emit_exit(&emitter, next);
+    }
+
+    if (emitter.trap_count > 0)
+    {
+        emit_trap_exit(&emitter, block->length, block->start);
+    }
+
+    if (buffer->bounded)
+    {
+        emit_limit_stub(&emitter, block->start);
+    }
+
+    make_executable(emitter.code, emitter.used);
+
+    block->native = (NativeBlock)(void *)(emitter.code + entry);
+    buffer->used = start + emitter.used;
+    return true;
+}
+
+void jit_link(const JitBuffer *buffer, uint8_t *exit, NativeBlock target)
+{
+    // Bounded blocks are entered through their limit check
+    uint8_t *entry = (uint8_t *)(void *)target - (buffer->bounded ? LIMIT_SIZE : 0);
+    int32_t displacement = (int32_t)(entry - (exit + 5));
+
+    // An exit that cannot be written to keeps going back to the interpreter, which still works
+    if (!make_writable(exit, 5))
+    {
+        return;
+    }
+
+    // Replaces "mov eax, next" with a jump of the same size
+    exit[0] = 0xE9;
+    memcpy(&exit[1], &displacement, sizeof(displacement));
+
+    make_executable(exit, 5);
+}
+
+void jit_reset(JitBuffer *buffer)
+{
+    buffer->used = 0;
+}
+
+void jit_free(JitBuffer *buffer)
+{
+    if (buffer->memory != NULL)
+    {
+        munmap(buffer->memory, buffer->size);
+    }
+
+    buffer->memory = NULL;
+    buffer->size = 0;
+    buffer->used = 0;
+}
+
+static bool is_supported(uint8_t opcode)
+{
+    switch (opcode)
+    {
+    case OPCODE_ADD:
+    case OPCODE_ADDU:
+    case OPCODE_ADDI:
+    case OPCODE_SUB:
+    case OPCODE_SUBU:
+    case OPCODE_MUL:
+    case OPCODE_MULT:
+    case OPCODE_MULTU:
+    case OPCODE_MFHI:
+    case OPCODE_MFLO:
+    case OPCODE_MTHI:
+    case OPCODE_MTLO:
+    case OPCODE_AND:
+    case OPCODE_OR:
+    case OPCODE_XOR:
+    case OPCODE_NOR:
+    case OPCODE_SLT:
+    case OPCODE_SLTU:
+    case OPCODE_SLL:
+    case OPCODE_SRL:
+    case OPCODE_SRA:
+    case OPCODE_SLLV:
+    case OPCODE_SRLV:
+    case OPCODE_SRAV:
+    case OPCODE_ADDIU:
+    case OPCODE_SLTI:
+    case OPCODE_SLTIU:
+    case OPCODE_ANDI:
+    case OPCODE_ORI:
+    case OPCODE_XORI:
+    case OPCODE_LUI:
+    case OPCODE_BEQ:
+    case OPCODE_BNE:
+    case OPCODE_BLEZ:
+    case OPCODE_BGTZ:
+    case OPCODE_BLTZ:
+    case OPCODE_BGEZ:
+    case OPCODE_BLTZAL:
+    case OPCODE_BGEZAL:
+    case OPCODE_J:
+    case OPCODE_JAL:
+    case OPCODE_JR:
+    case OPCODE_JALR:
+    case OPCODE_NOP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool can_overflow(uint8_t opcode)
+{
+    return opcode == OPCODE_ADD || opcode == OPCODE_ADDI || opcode == OPCODE_SUB;
+}
+
+/// @brief Whether instruction branches on flags_register against $zero, which the flags already compare.
+///
+/// Every branch tests whether it is zero, the signed ones only when OF is known to be clear as well.
+static bool reuses_flags(const Instruction *instruction, uint8_t flags_register, bool flags_signed)
+{
+    if (flags_register == REGISTER_ZERO)
+    {
+        return false;
+    }
+
+    switch (instruction->opcode)
+    {
+    case OPCODE_BEQ:
+    case OPCODE_BNE:
+        return (instruction->rs == flags_register && instruction->rt == REGISTER_ZERO) ||
+               (instruction->rs == REGISTER_ZERO && instruction->rt == flags_register);
+    case OPCODE_BLEZ:
+    case OPCODE_BGTZ:
+        return flags_signed && instruction->rs == flags_register && instruction->rt == REGISTER_ZERO;
+    case OPCODE_BLTZ:
+    case OPCODE_BLTZAL:
+    case OPCODE_BGEZ:
+    case OPCODE_BGEZAL:
+        return flags_signed && instruction->rs == flags_register;
+    default:
+        return false;
+    }
+}
+
+/// @brief Emits instruction, which goes on to next, the address after the block that branches and jumps
+/// link as well, and runs delay_slot before leaving if it is not NULL.
+static void emit_instruction(Emitter *emitter, const Instruction *instruction, unsigned int next,
+                             const Instruction *delay_slot)
+{
+    // Only the ALU instructions that leave flags for their result set them again
+    bool flags_set = reuses_flags(instruction, emitter->flags_register, emitter->flags_signed);
+    emitter->flags_register = REGISTER_ZERO;
+
+    switch (instruction->opcode)
+    {
+    case OPCODE_ADD:
+    case OPCODE_ADDU:
+    case OPCODE_SUB:
+    case OPCODE_SUBU:
+    case OPCODE_MUL:
+    case OPCODE_AND:
+    case OPCODE_OR:
+    case OPCODE_XOR:
+    case OPCODE_NOR:
+    case OPCODE_SLT:
+    case OPCODE_SLTU:
+        // mov eax, rs
+        emit_register(emitter, 0x8B, instruction->rs);
+
+        switch (instruction->opcode)
+        {
+        case OPCODE_ADD:
+        case OPCODE_ADDU:
+            emit_register(emitter, 0x03, instruction->rt);
+            break;
+        case OPCODE_SUB:
+        case OPCODE_SUBU:
+            emit_register(emitter, 0x2B, instruction->rt);
+            break;
+        case OPCODE_MUL:
+            emit_byte(emitter, 0x0F);
+            emit_register(emitter, 0xAF, instruction->rt);
+            break;
+        case OPCODE_AND:
+            emit_register(emitter, 0x23, instruction->rt);
+            break;
+        case OPCODE_OR:
+            emit_register(emitter, 0x0B, instruction->rt);
+            break;
+        case OPCODE_XOR:
+            emit_register(emitter, 0x33, instruction->rt);
+            break;
+        case OPCODE_NOR:
+            // or eax, rt; not eax
+            emit_register(emitter, 0x0B, instruction->rt);
+            emit_byte(emitter, 0xF7);
+            emit_byte(emitter, 0xD0);
+            break;
+        case OPCODE_SLT:
+            // cmp eax, rt; setl al
+            emit_register(emitter, 0x3B, instruction->rt);
+            emit_compare(emitter, 0x9C);
+            break;
+        case OPCODE_SLTU:
+            // cmp eax, rt; setb al
+            emit_register(emitter, 0x3B, instruction->rt);
+            emit_compare(emitter, 0x92);
+            break;
+        }
+
+        // Leaves before rd is written
+        if (can_overflow(instruction->opcode))
+        {
+            emit_trap(emitter);
+        }
+
+        // Writes to $zero are dropped, exactly like resetting it after every instruction
+        if (instruction->rd != REGISTER_ZERO)
+        {
+            // mov rd, eax
+            emit_register(emitter, 0x89, instruction->rd);
+        }
+
+        // MUL, NOR, SLT and SLTU leave flags that say nothing about rd
+        if (instruction->opcode != OPCODE_MUL && instruction->opcode != OPCODE_NOR && instruction->opcode != OPCODE_SLT &&
+            instruction->opcode != OPCODE_SLTU)
+        {
+            emitter->flags_register = instruction->rd;
+            emitter->flags_signed = instruction->opcode != OPCODE_ADDU && instruction->opcode != OPCODE_SUBU;
+        }
+        break;
+
+    case OPCODE_ADDI:
+    case OPCODE_ADDIU:
+    case OPCODE_ANDI:
+    case OPCODE_ORI:
+    case OPCODE_XORI:
+    case OPCODE_SLTI:
+    case OPCODE_SLTIU:
+        emit_register(emitter, 0x8B, instruction->rs);
+
+        switch (instruction->opcode)
+        {
+        case OPCODE_ADDI:
+        case OPCODE_ADDIU:
+            emit_byte(emitter, 0x05);
+            break;
+        case OPCODE_ANDI:
+            emit_byte(emitter, 0x25);
+            break;
+        case OPCODE_ORI:
+            emit_byte(emitter, 0x0D);
+            break;
+        case OPCODE_XORI:
+            emit_byte(emitter, 0x35);
+            break;
+        case OPCODE_SLTI:
+        case OPCODE_SLTIU:
+            // cmp eax, immediate
+            emit_byte(emitter, 0x3D);
+            break;
+        }
+        emit_int(emitter, instruction->immediate);
+
+        if (can_overflow(instruction->opcode))
+        {
+            emit_trap(emitter);
+        }
+
+        if (instruction->opcode == OPCODE_SLTI || instruction->opcode == OPCODE_SLTIU)
+        {
+            emit_compare(emitter, instruction->opcode == OPCODE_SLTI ? 0x9C : 0x92);
+        }
+
+        if (instruction->rt != REGISTER_ZERO)
+        {
+            emit_register(emitter, 0x89, instruction->rt);
+        }
+
+        if (instruction->opcode != OPCODE_SLTI && instruction->opcode != OPCODE_SLTIU)
+        {
+            emitter->flags_register = instruction->rt;
+            emitter->flags_signed = instruction->opcode != OPCODE_ADDIU;
+        }
+        break;
+
+    case OPCODE_LUI:
+        if (instruction->rt != REGISTER_ZERO)
+        {
+            // mov dword [rdi + rt], immediate << 16
+            emit_register(emitter, 0xC7, instruction->rt);
+            emit_int(emitter, (uint32_t)instruction->immediate << 16);
+        }
+        break;
+
+    case OPCODE_SLL:
+    case OPCODE_SRL:
+    case OPCODE_SRA:
+    case OPCODE_SLLV:
+    case OPCODE_SRLV:
+    case OPCODE_SRAV:
+        if (instruction->rd == REGISTER_ZERO)
+        {
+            break;
+        }
+
+        // x86 masks the amount to 5 bits as well, so the variable shifts only need it in cl
+        if (instruction->opcode == OPCODE_SLLV || instruction->opcode == OPCODE_SRLV || instruction->opcode == OPCODE_SRAV)
+        {
+            // mov ecx, rs
+            emit_operand(emitter, 0x8B, HOST_ECX, REGISTER_OFFSET(instruction->rs));
+        }
+        emit_register(emitter, 0x8B, instruction->rt);
+
+        switch (instruction->opcode)
+        {
+        case OPCODE_SLL:
+        case OPCODE_SRL:
+        case OPCODE_SRA:
+            // shl, shr or sar eax, amount
+            emit_byte(emitter, 0xC1);
+            emit_byte(emitter, instruction->opcode == OPCODE_SLL ? 0xE0 : instruction->opcode == OPCODE_SRL ? 0xE8 : 0xF8);
+            emit_byte(emitter, instruction->immediate);
+            break;
+        default:
+            // shl, shr or sar eax, cl
+            emit_byte(emitter, 0xD3);
+            emit_byte(emitter, instruction->opcode == OPCODE_SLLV ? 0xE0 : instruction->opcode == OPCODE_SRLV ? 0xE8 : 0xF8);
+            break;
+        }
+
+        emit_register(emitter, 0x89, instruction->rd);
+        break;
+
+    case OPCODE_MULT:
+    case OPCODE_MULTU:
+        // mov eax, rs; imul or mul dword rt, which leaves the product in edx:eax
+        emit_register(emitter, 0x8B, instruction->rs);
+        emit_operand(emitter, 0xF7, instruction->opcode == OPCODE_MULT ? 5 : 4, REGISTER_OFFSET(instruction->rt));
+        emit_operand(emitter, 0x89, HOST_EAX, LO_OFFSET);
+        emit_operand(emitter, 0x89, HOST_EDX, HI_OFFSET);
+        break;
+
+    case OPCODE_MFHI:
+    case OPCODE_MFLO:
+        if (instruction->rd != REGISTER_ZERO)
+        {
+            emit_operand(emitter, 0x8B, HOST_EAX, instruction->opcode == OPCODE_MFHI ? HI_OFFSET : LO_OFFSET);
+            emit_register(emitter, 0x89, instruction->rd);
+        }
+        break;
+
+    case OPCODE_MTHI:
+    case OPCODE_MTLO:
+        emit_register(emitter, 0x8B, instruction->rs);
+        emit_operand(emitter, 0x89, HOST_EAX, instruction->opcode == OPCODE_MTHI ? HI_OFFSET : LO_OFFSET);
+        break;
+
+    // The condition is inverted, jumping to the exit that falls through
+    case OPCODE_BEQ:
+        emit_branch(emitter, instruction, 0x85, flags_set, next, delay_slot);
+        break;
+    case OPCODE_BNE:
+        emit_branch(emitter, instruction, 0x84, flags_set, next, delay_slot);
+        break;
+    case OPCODE_BLEZ:
+        emit_branch(emitter, instruction, 0x8F, flags_set, next, delay_slot);
+        break;
+    case OPCODE_BGTZ:
+        emit_branch(emitter, instruction, 0x8E, flags_set, next, delay_slot);
+        break;
+    case OPCODE_BLTZ:
+    case OPCODE_BLTZAL:
+        emit_zero_branch(emitter, instruction, 0x8D, instruction->opcode == OPCODE_BLTZAL, flags_set, next,
+                         delay_slot);
+        break;
+    case OPCODE_BGEZ:
+    case OPCODE_BGEZAL:
+        emit_zero_branch(emitter, instruction, 0x8C, instruction->opcode == OPCODE_BGEZAL, flags_set, next,
+                         delay_slot);
+        break;
+
+    case OPCODE_JAL:
+        // mov dword [rdi + ra], next
+        emit_register(emitter, 0xC7, REGISTER_RA);
+        emit_int(emitter, next);
+        emit_delay_slot(emitter, delay_slot);
+        emit_exit(emitter, instruction->immediate);
+        break;
+    case OPCODE_J:
+        emit_delay_slot(emitter, delay_slot);
+        emit_exit(emitter, instruction->immediate);
+        break;
+
+    case OPCODE_NOP:
+        break;
+
+    case OPCODE_JR:
+    case OPCODE_JALR:
+        // The target varies, so this exit is never linked. It is read before rd is linked, into r8d
+        // when a delay slot runs before leaving: mov eax or r8d, rs
+        if (delay_slot != NULL)
+        {
+            emit_byte(emitter, 0x44);
+        }
+        emit_register(emitter, 0x8B, instruction->rs);
+
+        if (instruction->opcode == OPCODE_JALR && instruction->rd != REGISTER_ZERO)
+        {
+            emit_register(emitter, 0xC7, instruction->rd);
+            emit_int(emitter, next);
+        }
+
+        if (delay_slot != NULL)
+        {
+            emit_delay_slot(emitter, delay_slot);
+
+            // mov eax, r8d
+            emit_byte(emitter, 0x44);
+            emit_byte(emitter, 0x89);
+            emit_byte(emitter, 0xC0);
+        }
+
+        // xor edx, edx; ret
+        emit_byte(emitter, 0x31);
+        emit_byte(emitter, 0xD2);
+        emit_byte(emitter, 0xC3);
+        break;
+    }
+}
+
+/// @brief Emits a branch that compares rs and rt, or only tests the flags when flags_set says they already
+/// compare one of them against $zero.
+static void emit_branch(Emitter *emitter, const Instruction *instruction, uint8_t not_taken_jump, bool flags_set,
+                        unsigned int next, const Instruction *delay_slot)
+{
+    if (!flags_set)
+    {
+        // mov eax, rs; cmp eax, rt
+        emit_register(emitter, 0x8B, instruction->rs);
+        emit_register(emitter, 0x3B, instruction->rt);
+    }
+    emit_jump(emitter, not_taken_jump, delay_slot);
+
+    emit_exit(emitter, instruction->immediate);
+    emit_exit(emitter, next);
+}
+
+static void emit_zero_branch(Emitter *emitter, const Instruction *instruction, uint8_t not_taken_jump, bool link,
+                             bool flags_set, unsigned int next, const Instruction *delay_slot)
+{
+    if (!flags_set)
+    {
+        // cmp dword [rdi + rs], 0
+        emit_operand(emitter, 0x83, 7, REGISTER_OFFSET(instruction->rs));
+        emit_byte(emitter, 0);
+    }
+
+    // Linking leaves the flags alone, so it happens after rs is compared: mov dword [rdi + ra], next
+    if (link)
+    {
+        emit_register(emitter, 0xC7, REGISTER_RA);
+        emit_int(emitter, next);
+    }
+
+    emit_jump(emitter, not_taken_jump, delay_slot);
+
+    emit_exit(emitter, instruction->immediate);
+    emit_exit(emitter, next);
+}
+
+/// @brief Jumps over the taken exit with not_taken_jump on the flags of a comparison, after running delay_slot.
+static void emit_jump(Emitter *emitter, uint8_t not_taken_jump, const Instruction *delay_slot)
+{
+    if (delay_slot != NULL)
+    {
+        // setcc r8b, with the opposite condition of not_taken_jump
+        emit_byte(emitter, 0x41);
+        emit_byte(emitter, 0x0F);
+        emit_byte(emitter, 0x90 | ((not_taken_jump & 0x0F) ^ 1));
+        emit_byte(emitter, 0xC0);
+
+        emit_delay_slot(emitter, delay_slot);
+
+        // test r8b, r8b, then jz not_taken
+        emit_byte(emitter, 0x45);
+        emit_byte(emitter, 0x84);
+        emit_byte(emitter, 0xC0);
+        not_taken_jump = 0x84;
+    }
+
+    // jcc not_taken
+    emit_byte(emitter, 0x0F);
+    emit_byte(emitter, not_taken_jump);
+    emit_int(emitter, EXIT_SIZE);
+}
+
+/// @brief Emits the instruction in a delay slot, if any, where a branch does nothing.
+static void emit_delay_slot(Emitter *emitter, const Instruction *delay_slot)
+{
+    if (delay_slot != NULL && !ends_block(delay_slot->opcode))
+    {
+        emit_instruction(emitter, delay_slot, 0, NULL);
+    }
+}
+
+/// @brief Turns the flags of a comparison into 0 or 1 in eax, with setcc for condition.
+static void emit_compare(Emitter *emitter, uint8_t condition)
+{
+    // setcc al; movzx eax, al
+    emit_byte(emitter, 0x0F);
+    emit_byte(emitter, condition);
+    emit_byte(emitter, 0xC0);
+    emit_byte(emitter, 0x0F);
+    emit_byte(emitter, 0xB6);
+    emit_byte(emitter, 0xC0);
+}
+
+/// @brief Leaves the block through emit_limit_stub when CPU.instructions has reached the limit.
+///
+/// Always LIMIT_SIZE bytes long, so jit_link finds it right before the block it checks.
+static void emit_limit(Emitter *emitter)
+{
+    // cmp [rdi + instructions], rsi
+    emit_byte(emitter, 0x48);
+    emit_operand(emitter, 0x39, HOST_ESI, offsetof(CPU, instructions));
+
+    // jae stub, whose displacement is filled in by emit_limit_stub
+    emit_byte(emitter, 0x0F);
+    emit_byte(emitter, 0x83);
+    emitter->limit_jump = emitter->used;
+    emit_int(emitter, 0);
+}
+
+/// @brief Returns program_counter, the start of the block, as an exit that cannot be linked.
+static void emit_limit_stub(Emitter *emitter, uint32_t program_counter)
+{
+    int32_t displacement = (int32_t)(emitter->used - (emitter->limit_jump + 4));
+    memcpy(&emitter->code[emitter->limit_jump], &displacement, sizeof(displacement));
+
+    // mov eax, program_counter; xor edx, edx; ret
+    emit_byte(emitter, 0xB8);
+    emit_int(emitter, program_counter);
+    emit_byte(emitter, 0x31);
+    emit_byte(emitter, 0xD2);
+    emit_byte(emitter, 0xC3);
+}
+
+static void emit_counter(Emitter *emitter, unsigned int length)
+{
+    // add qword [rdi + instructions], length
+    emit_byte(emitter, 0x48);
+    emit_byte(emitter, 0x81);
+    emit_byte(emitter, 0x87);
+    emit_int(emitter, offsetof(CPU, instructions));
+    emit_int(emitter, length);
+}
+
+static void emit_exit(Emitter *emitter, uint32_t program_counter)
+{
+    // mov eax, program_counter
+    emit_byte(emitter, 0xB8);
+    emit_int(emitter, program_counter);
+
+    // lea rdx, [rip - 12], the address of this exit
+    emit_byte(emitter, 0x48);
+    emit_byte(emitter, 0x8D);
+    emit_byte(emitter, 0x15);
+    emit_int(emitter, -12);
+
+    // ret
+    emit_byte(emitter, 0xC3);
+}
+
+/// @brief Jumps to the trap exit for the current instruction when the flags say it overflowed.
+static void emit_trap(Emitter *emitter)
+{
+    // jo entry, whose displacement is filled in by emit_trap_exit
+    emit_byte(emitter, 0x0F);
+    emit_byte(emitter, 0x80);
+    emitter->traps[emitter->trap_count] = emitter->used;
+    emitter->trap_indices[emitter->trap_count++] = emitter->index;
+    emit_int(emitter, 0);
+}
+
+/// @brief Emits an entry for every jo that sets cl to the index of its instruction, then the exit they
+/// all lead to, which returns that instruction's address as JIT_TRAP.
+static void emit_trap_exit(Emitter *emitter, unsigned int length, uint32_t start)
+{
+    size_t exit = emitter->used + emitter->trap_count * TRAP_SIZE;
+
+    for (unsigned int i = 0; i < emitter->trap_count; i++)
+    {
+        int32_t displacement = (int32_t)(emitter->used - (emitter->traps[i] + 4));
+        memcpy(&emitter->code[emitter->traps[i]], &displacement, sizeof(displacement));
+
+        // mov cl, index; jmp exit
+        emit_byte(emitter, 0xB1);
+        emit_byte(emitter, emitter->trap_indices[i]);
+        emit_byte(emitter, 0xE9);
+        emit_int(emitter, (int32_t)(exit - (emitter->used + 4)));
+    }
+
+    // movzx ecx, cl
+    emit_byte(emitter, 0x0F);
+    emit_byte(emitter, 0xB6);
+    emit_byte(emitter, 0xC9);
+
+    // The instructions from index on did not retire: lea rax, [rcx - length]; add [rdi + instructions], rax
+    emit_byte(emitter, 0x48);
+    emit_byte(emitter, 0x8D);
+    emit_byte(emitter, 0x81);
+    emit_int(emitter, -(int32_t)length);
+    emit_byte(emitter, 0x48);
+    emit_operand(emitter, 0x01, HOST_EAX, offsetof(CPU, instructions));
+
+    // lea eax, [rcx * 4 + start]; mov edx, JIT_TRAP; ret
+    emit_byte(emitter, 0x8D);
+    emit_byte(emitter, 0x04);
+    emit_byte(emitter, 0x8D);
+    emit_int(emitter, start);
+    emit_byte(emitter, 0xBA);
+    emit_int(emitter, (int32_t)(uintptr_t)JIT_TRAP);
+    emit_byte(emitter, 0xC3);
+}
+
+/// @brief Makes the host pages that hold [start, start + length) writable and no longer executable.
+static bool make_writable(uint8_t *start, size_t length)
+{
+    uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t first = (uintptr_t)start & ~(page_size - 1);
+    uintptr_t end = ((uintptr_t)start + length + page_size - 1) & ~(page_size - 1);
+
+    return mprotect((void *)first, end - first, PROT_READ | PROT_WRITE) == 0;
+}
+
+/// @brief Makes the host pages that hold [start, start + length) executable and no longer writable.
+static void make_executable(uint8_t *start, size_t length)
+{
+    uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t first = (uintptr_t)start & ~(page_size - 1);
+    uintptr_t end = ((uintptr_t)start + length + page_size - 1) & ~(page_size - 1);
+
+    // Earlier blocks may share these pages, so should the kernel refuse, they stay writable as well
+    // rather than leave code that jumps into them crashing
+    if (mprotect((void *)first, end - first, PROT_READ | PROT_EXEC) != 0)
+    {
+        mprotect((void *)first, end - first, PROT_READ | PROT_WRITE | PROT_EXEC);
+    }
+}
+
+static void emit_byte(Emitter *emitter, uint8_t byte)
+{
+    emitter->code[emitter->used++] = byte;
+}
+
+static void emit_int(Emitter *emitter, int32_t value)
+{
+    memcpy(&emitter->code[emitter->used], &value, sizeof(value));
+    emitter->used += sizeof(value);
+}
+
+static void emit_register(Emitter *emitter, uint8_t opcode, uint8_t index)
+{
+    emit_operand(emitter, opcode, HOST_EAX, REGISTER_OFFSET(index));
+}
+
+/// @brief Emits opcode with host, or the opcode extension, as its register and [rdi + offset] as its memory operand.
+static void emit_operand(Emitter *emitter, uint8_t opcode, uint8_t host, int32_t offset)
+{
+    // ModRM for [rdi + disp32]
+    emit_byte(emitter, opcode);
+    emit_byte(emitter, 0x87 | host << 3);
+    emit_int(emitter, offset);
+}
+
+#else
+
+bool jit_compile(JitBuffer *buffer, Block *block)
+{
+    // Only x86-64 hosts have a backend, everything else stays interpreted
+    (void)buffer;
+    (void)block;
+    return false;
+}
+
+void jit_link(const JitBuffer *buffer, uint8_t *exit, NativeBlock target)
+{
+    (void)buffer;
+    (void)exit;
+    (void)target;
+}
+
+void jit_reset(JitBuffer *buffer)
+{
+    buffer->used = 0;
+}
+
+void jit_free(JitBuffer *buffer)
+{
+    (void)buffer;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#include <string.h>
+
+#include "instruction.h"
+#include "keyword.h"
+
+/*
+ * Mnemonics and register names are looked up through a perfect hash, built when the interpreter is
+ * built by tools/keyword_table.c out of includes/keywords.def. Words are split into KEYWORD_BUCKETS
+ * buckets by their hash, and each bucket has a seed that displaces its words into slots no other word
+ * takes, so a lookup is one hash, one slot and one comparison, whether or not the word is a keyword.
+ */
+#include "keyword_table.h"
+
+/// @brief The keyword that is exactly the first length characters of word, or NULL.
+const Keyword *find_keyword(const char *word, size_t length)
+{
+    uint64_t hash = hash_keyword(word, length);
+    const Keyword *keyword = &KEYWORDS[keyword_slot(hash, KEYWORD_SEEDS[hash & (KEYWORD_BUCKETS - 1)])];
+
+    if (keyword->name == NULL || keyword->length != length || memcmp(keyword->name, word, length) != 0)
+    {
+        return NULL;
+    }
+
+    return keyword;
+}
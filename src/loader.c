@@ -0,0 +1,324 @@
+#include <elf.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "assembler.h"
+#include "loader.h"
+#include "syscall.h"
+
+static bool load_segments(Memory *memory, const uint8_t *image, size_t size, bool little_endian, uint64_t *end,
+                          FILE *output);
+static bool table_fits(uint32_t offset, uint16_t entry_size, uint16_t count, size_t minimum, size_t size);
+static bool has_extension(const char *path, const char *extension);
+static uint16_t read16(const uint8_t *bytes, bool little_endian);
+static uint32_t read32(const uint8_t *bytes, bool little_endian);
+
+/*
+ * The file is memory mapped and decoded straight from the mapping: ELF executables and raw ".bin"
+ * images are read word by word, anything else is parsed as assembly text.
+ */
+bool load_file(Program *program, CPU *cpu, const char *path, bool little_endian, FILE *output)
+{
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor == -1)
+    {
+        fprintf(output, "ERRO: Não foi possível abrir o arquivo \"%s\"\n", path);
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(descriptor, &status) == -1)
+    {
+        fprintf(output, "ERRO: Não foi possível ler o arquivo \"%s\"\n", path);
+        close(descriptor);
+        return false;
+    }
+
+    size_t size = status.st_size;
+
+    // An empty file is an empty program, and mmap does not accept a zero length
+    if (size == 0)
+    {
+        close(descriptor);
+        return true;
+    }
+
+    uint8_t *image = mmap(NULL, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+
+    if (image == MAP_FAILED)
+    {
+        fprintf(output, "ERRO: Não foi possível mapear o arquivo \"%s\"\n", path);
+        return false;
+    }
+
+    bool loaded;
+    if (size >= SELFMAG && memcmp(image, ELFMAG, SELFMAG) == 0)
+    {
+        loaded = load_elf(program, cpu, image, size, output);
+    }
+    else if (has_extension(path, ".bin"))
+    {
+        loaded = load_words(program, image, size, 0, little_endian, output);
+        cpu->program_counter = 0;
+    }
+    else
+    {
+        Source source;
+        open_text(&source, (const char *)image, size);
+        loaded = assemble_program(program, &cpu->memory, &source, output);
+    }
+
+    munmap(image, size);
+    return loaded;
+}
+
+bool load_elf(Program *program, CPU *cpu, const uint8_t *image, size_t size, FILE *output)
+{
+    if (size < sizeof(Elf32_Ehdr) || image[EI_CLASS] != ELFCLASS32 ||
+        (image[EI_DATA] != ELFDATA2LSB && image[EI_DATA] != ELFDATA2MSB))
+    {
+        fprintf(output, "ERRO: O arquivo não é um ELF32 válido\n");
+        return false;
+    }
+
+    bool little_endian = image[EI_DATA] == ELFDATA2LSB;
+
+    if (read16(image + offsetof(Elf32_Ehdr, e_machine), little_endian) != EM_MIPS)
+    {
+        fprintf(output, "ERRO: O ELF não é de um processador MIPS\n");
+        return false;
+    }
+
+    uint32_t entry = read32(image + offsetof(Elf32_Ehdr, e_entry), little_endian);
+    uint32_t section_offset = read32(image + offsetof(Elf32_Ehdr, e_shoff), little_endian);
+    uint16_t section_size = read16(image + offsetof(Elf32_Ehdr, e_shentsize), little_endian);
+    uint16_t section_count = read16(image + offsetof(Elf32_Ehdr, e_shnum), little_endian);
+    uint16_t names_index = read16(image + offsetof(Elf32_Ehdr, e_shstrndx), little_endian);
+    uint32_t segment_offset = read32(image + offsetof(Elf32_Ehdr, e_phoff), little_endian);
+    uint16_t segment_size = read16(image + offsetof(Elf32_Ehdr, e_phentsize), little_endian);
+    uint16_t segment_count = read16(image + offsetof(Elf32_Ehdr, e_phnum), little_endian);
+
+    // Every header is read through these tables, so they have to hold whole headers inside the file
+    if ((section_offset != 0 && !table_fits(section_offset, section_size, section_count, sizeof(Elf32_Shdr), size)) ||
+        !table_fits(segment_offset, segment_size, segment_count, sizeof(Elf32_Phdr), size))
+    {
+        fprintf(output, "ERRO: As tabelas de cabeçalhos do ELF não cabem no arquivo\n");
+        return false;
+    }
+
+    const uint8_t *text = NULL;
+    uint32_t text_address = 0;
+    uint32_t text_size = 0;
+
+    // Looks for the .text section by name
+    if (section_offset != 0 && names_index < section_count)
+    {
+        const uint8_t *names_header = image + section_offset + (size_t)names_index * section_size;
+        uint32_t names_offset = read32(names_header + offsetof(Elf32_Shdr, sh_offset), little_endian);
+
+        for (uint16_t i = 0; i < section_count && names_offset < size; i++)
+        {
+            const uint8_t *header = image + section_offset + (size_t)i * section_size;
+            uint32_t name = read32(header + offsetof(Elf32_Shdr, sh_name), little_endian);
+            uint32_t offset = read32(header + offsetof(Elf32_Shdr, sh_offset), little_endian);
+            uint32_t length = read32(header + offsetof(Elf32_Shdr, sh_size), little_endian);
+
+            if ((uint64_t)names_offset + name + sizeof(".text") > size ||
+                memcmp(image + names_offset + name, ".text", sizeof(".text")) != 0)
+            {
+                continue;
+            }
+
+            if ((uint64_t)offset + length <= size)
+            {
+                text = image + offset;
+                text_address = read32(header + offsetof(Elf32_Shdr, sh_addr), little_endian);
+                text_size = length;
+            }
+            break;
+        }
+    }
+
+    // Stripped executables may have no sections, so the first executable segment is used instead
+    if (text == NULL)
+    {
+        for (uint16_t i = 0; i < segment_count; i++)
+        {
+            const uint8_t *header = image + segment_offset + (size_t)i * segment_size;
+            uint32_t type = read32(header + offsetof(Elf32_Phdr, p_type), little_endian);
+            uint32_t flags = read32(header + offsetof(Elf32_Phdr, p_flags), little_endian);
+            uint32_t offset = read32(header + offsetof(Elf32_Phdr, p_offset), little_endian);
+            uint32_t length = read32(header + offsetof(Elf32_Phdr, p_filesz), little_endian);
+
+            if (type == PT_LOAD && (flags & PF_X) != 0 && (uint64_t)offset + length <= size)
+            {
+                text = image + offset;
+                text_address = read32(header + offsetof(Elf32_Phdr, p_vaddr), little_endian);
+                text_size = length;
+                break;
+            }
+        }
+    }
+
+    if (text == NULL)
+    {
+        fprintf(output, "ERRO: O ELF não possui uma seção .text\n");
+        return false;
+    }
+
+    if (!load_words(program, text, text_size, text_address, little_endian, output))
+    {
+        return false;
+    }
+
+    // Compilers fill the delay slot after every branch and jump of a MIPS executable
+    program->delay_slots = true;
+
+    // Data is read with the byte order of the executable
+    cpu->memory.little_endian = little_endian;
+    uint64_t end;
+    if (!load_segments(&cpu->memory, image, size, little_endian, &end, output))
+    {
+        return false;
+    }
+
+    // The heap starts on the first page after the data, or at HEAP_BASE when there is none
+    uint64_t heap_break = end != 0 ? (end + PAGE_MASK) & ~(uint64_t)PAGE_MASK : HEAP_BASE;
+    if (heap_break > UINT32_MAX)
+    {
+        fprintf(output, "ERRO: Os segmentos do ELF não deixam espaço para o heap\n");
+        return false;
+    }
+    cpu->heap_break = heap_break;
+
+    cpu->program_counter = entry;
+    return true;
+}
+
+bool load_words(Program *program, const uint8_t *words, size_t size, uint32_t base, bool little_endian, FILE *output)
+{
+    if (size % 4 != 0)
+    {
+        fprintf(output, "ERRO: O código tem %zu bytes, que não formam palavras de 32 bits\n", size);
+        return false;
+    }
+
+    program->base = base;
+
+    unsigned int unsupported = 0;
+    for (size_t offset = 0; offset < size; offset += 4)
+    {
+        uint32_t program_counter = base + offset;
+        uint32_t word = read32(words + offset, little_endian);
+
+        Instruction instruction;
+        if (!decode_word(word, program_counter, &instruction))
+        {
+            // Kept as it is, so executing it raises a reserved instruction exception
+            instruction = (Instruction){.opcode = OPCODE_RESERVED, .immediate = (int32_t)word};
+            unsupported++;
+        }
+
+        if (!store_instruction(program, program_counter, instruction, output))
+        {
+            return false;
+        }
+    }
+
+    if (unsupported > 0)
+    {
+        fprintf(output,
+                "AVISO: %u instruções não são suportadas, executar uma delas causa uma exceção de instrução "
+                "reservada\n",
+                unsupported);
+    }
+
+    return true;
+}
+
+/// @brief Copies every loadable segment into memory, the rest of each segment (.bss) reads as zero.
+///
+/// end is set to the address right after the segment that ends last, 0 when there is none. The program
+/// header table must already be known to fit in the image.
+static bool load_segments(Memory *memory, const uint8_t *image, size_t size, bool little_endian, uint64_t *end,
+                          FILE *output)
+{
+    *end = 0;
+
+    uint32_t segment_offset = read32(image + offsetof(Elf32_Ehdr, e_phoff), little_endian);
+    uint16_t segment_size = read16(image + offsetof(Elf32_Ehdr, e_phentsize), little_endian);
+    uint16_t segment_count = read16(image + offsetof(Elf32_Ehdr, e_phnum), little_endian);
+
+    for (uint16_t i = 0; i < segment_count; i++)
+    {
+        const uint8_t *header = image + segment_offset + (size_t)i * segment_size;
+        uint32_t type = read32(header + offsetof(Elf32_Phdr, p_type), little_endian);
+        uint32_t offset = read32(header + offsetof(Elf32_Phdr, p_offset), little_endian);
+        uint32_t length = read32(header + offsetof(Elf32_Phdr, p_filesz), little_endian);
+        uint32_t address = read32(header + offsetof(Elf32_Phdr, p_vaddr), little_endian);
+        uint32_t memory_size = read32(header + offsetof(Elf32_Phdr, p_memsz), little_endian);
+
+        if (type != PT_LOAD || (uint64_t)offset + length > size)
+        {
+            continue;
+        }
+
+        // The file part is copied, so it has to fit in the segment, and the segment in the address space
+        if (length > memory_size || (uint64_t)address + memory_size > (uint64_t)UINT32_MAX + 1)
+        {
+            fprintf(output, "ERRO: O segmento %u do ELF não cabe no espaço de endereçamento\n", i);
+            return false;
+        }
+
+        if ((uint64_t)address + memory_size > *end)
+        {
+            *end = (uint64_t)address + memory_size;
+        }
+
+        if (!write_memory(memory, address, image + offset, length))
+        {
+            print_memory_fault(memory, output);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// @brief Whether a table of count entries of entry_size bytes at offset lies inside the file, with entries
+/// at least minimum bytes long. An empty table always fits.
+static bool table_fits(uint32_t offset, uint16_t entry_size, uint16_t count, size_t minimum, size_t size)
+{
+    return count == 0 || (entry_size >= minimum && (uint64_t)offset + (uint64_t)count * entry_size <= size);
+}
+
+static bool has_extension(const char *path, const char *extension)
+{
+    size_t path_length = strlen(path);
+    size_t extension_length = strlen(extension);
+
+    return path_length >= extension_length && strcmp(path + path_length - extension_length, extension) == 0;
+}
+
+static uint16_t read16(const uint8_t *bytes, bool little_endian)
+{
+    if (little_endian)
+    {
+        return bytes[0] | bytes[1] << 8;
+    }
+    return bytes[0] << 8 | bytes[1];
+}
+
+static uint32_t read32(const uint8_t *bytes, bool little_endian)
+{
+    if (little_endian)
+    {
+        return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+    }
+    return (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 8 | (uint32_t)bytes[3];
+}
@@ -1,1009 +1,651 @@
-#include <errno.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-#define LINE_LENGTH 64
-#define INSTRUCTION_ARGS 3
-
-typedef struct CPU CPU;
-typedef struct Registers Registers;
-
-struct Registers
-{
-    /// @brief Temporary registers.
-    int t[10];
-
-    /// @brief Saved registers.
-    int s[8];
-
-    /// @brief Argument registers.
-    int a[4];
-
-    /// @brief Reserved for kernel.
-    int k[2];
-
-    /// @brief Return value registers.
-    int v[2];
-
-    /// @brief Register zero
-    int zero;
-
-    /// @brief Global pointer.
-    int gp;
-
-    /// @brief Stack pointer.
-    int sp;
-
-    /// @brief Frame pointer
-    int fp;
-
-    /// @brief Return address.
-    int ra;
-
-    /// @brief Reserved for assembler.
-    int at;
-};
-
-struct CPU
-{
-    unsigned int program_counter;
-    Registers registers;
-};
+#include <time.h>
+#include <unistd.h>
+
+#include "assembler.h"
+#include "batch.h"
+#include "cpu.h"
+#include "fuzz.h"
+#include "instruction.h"
+#include "interpreter.h"
+#include "loader.h"
+#include "program.h"
+#include "snapshot.h"
+#include "source.h"
+#include "trace.h"
+
+int run_repl(CPU *cpu, Program *program, const Options *options);
+bool run_history_command(CPU *cpu, Program *program, const Options *options, Slice command);
+int run_assembler(char *path, char *output_path, bool little_endian);
+
+bool parse_count(const char *argument, uint64_t *count);
 
 void print_help();
-void print_registers(Registers *registers);
-void execute_instruction(char instruction[LINE_LENGTH], CPU *cpu);
-
-void add(CPU *cpu, char **arguments, int length);
-void addi(CPU *cpu, char **arguments, int length);
-void addu(CPU *cpu, char **arguments, int length);
-void sub(CPU *cpu, char **arguments, int length);
-void subu(CPU *cpu, char **arguments, int length);
-void j(CPU *cpu, char **arguments, int length);
-void mult(CPU *cpu, char **arguments, int length);
-void _and(CPU *cpu, char **arguments, int length);
-void _or(CPU *cpu, char **arguments, int length);
-void andi(CPU *cpu, char **arguments, int length);
-void ori(CPU *cpu, char **arguments, int length);
-void beq(CPU *cpu, char **arguments, int length);
-void bne(CPU *cpu, char **arguments, int length);
-void blez(CPU *cpu, char **arguments, int length);
-void bgtz(CPU *cpu, char **arguments, int length);
-void jal(CPU *cpu, char **arguments, int length);
-void jr(CPU *cpu, char **arguments, int length);
-
-void print_instruction_r(char *reg0, char *reg1, char *reg2, unsigned char funct);
-void print_instruction_i(unsigned char opcode, char *reg0, char *reg1, short immediate);
-void print_instruction_j(unsigned char opcode, int address);
-
-int *get_register(Registers *registers, char *register_name);
-char get_register_index(char *register_name);
-
-char *trim(char *string);
-bool is_whitespace(char character);
-
-int main()
-{
-    CPU cpu;
-    cpu.program_counter = 0;
-
-    print_registers(&cpu.registers);
-
-    while (true)
-    {
-        cpu.registers.zero = 0;
-
-        // Gets the instruction from the user
-        char instruction_buffer[LINE_LENGTH] = {0};
-        printf("%11u > ", cpu.program_counter);
-        char *_ = fgets(instruction_buffer, sizeof(instruction_buffer), stdin);
-        (void)_;
-
-        char *instruction = trim(instruction_buffer);
 
-        // If instruction is HELP, show supported tags
-        if (strcmp(instruction, "HELP") == 0)
+int main(int argc, char **argv)
+{
+    CPU cpu = {0};
+    Program program = {0};
+
+    Options options = {.output = stdout, .jit_threshold = DEFAULT_JIT_THRESHOLD};
+    TraceLevel trace_level = TRACE_WORDS;
+    bool trace_chosen = false;
+    char *trace_path = NULL;
+    char *profile_path = NULL;
+    bool timed = false;
+    char *batch_path = NULL;
+    uint64_t fuzz_count = 0;
+    uint64_t fuzz_seed = time(NULL);
+    const char *restore_paths[SNAPSHOT_MAX_RESTORES];
+    unsigned int threads = 0;
+    uint32_t undo_capacity = UNDO_DEFAULT_CAPACITY;
+    char *path = NULL;
+    char *assemble_path = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quiet") == 0)
         {
-            print_help();
-            continue;
+            trace_level = TRACE_OFF;
+            trace_chosen = true;
         }
-
-        // If instruction is DEBUG, show register values
-        if (strcmp(instruction, "DEBUG") == 0)
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
         {
-            print_registers(&cpu.registers);
-            continue;
+            i++;
+            trace_chosen = true;
+            if (strcmp(argv[i], "off") == 0)
+            {
+                trace_level = TRACE_OFF;
+            }
+            else if (strcmp(argv[i], "words") == 0)
+            {
+                trace_level = TRACE_WORDS;
+            }
+            else if (strcmp(argv[i], "disasm") == 0)
+            {
+                trace_level = TRACE_DISASSEMBLY;
+            }
+            else
+            {
+                printf("ERRO: Nível de rastreamento inválido \"%s\"\n", argv[i]);
+                return 1;
+            }
         }
-
-        // If instruction is EXIT, end program
-        if (strcmp(instruction, "EXIT") == 0)
+        else if (strcmp(argv[i], "--delay-slots") == 0 && i + 1 < argc)
         {
-            break;
+            i++;
+            if (strcmp(argv[i], "on") == 0)
+            {
+                options.delay_slots = DELAY_SLOTS_ON;
+            }
+            else if (strcmp(argv[i], "off") == 0)
+            {
+                options.delay_slots = DELAY_SLOTS_OFF;
+            }
+            else
+            {
+                printf("ERRO: Modo de delay slot inválido \"%s\"\n", argv[i]);
+                return 1;
+            }
         }
-
-        execute_instruction(instruction, &cpu);
-
-        cpu.program_counter += 4;
-    }
-
-    return 0;
-}
-
-void print_help()
-{
-    printf("\n");
-    printf("HELP\n");
-    printf("\n");
-
-    printf("Instruções implementadas\n");
-    printf("\n");
-
-    printf("Instruções R\n");
-    printf("\n");
-    printf("ADD registrador0, registrador1, registrador2\n");
-    printf("SUB registrador0, registrador1, registrador2\n");
-    printf("ADDU registrador0, registrador1, registrador2\n");
-    printf("SUBU registrador0, registrador1, registrador2\n");
-    printf("MULT registrador0, registrador1, registrador2\n");
-    printf("AND registrador0, registrador1, registrador2\n");
-    printf("OR registrador0, registrador1, registrador2\n");
-    printf("JR registrador0\n");
-    printf("\n");
-
-    printf("Instruções I\n");
-    printf("\n");
-    printf("ADDI registrador0, registrador1, imediato\n");
-    printf("ANDI registrador0, registrador1, imediato\n");
-    printf("ORI registrador0, registrador1, imediato\n");
-    printf("BEQ registrador0, registrador1, endereço\n");
-    printf("BNE registrador0, registrador1, endereço\n");
-    printf("BLEZ registrador0, registrador1, endereço\n");
-    printf("BGTZ registrador0, registrador1, endereço\n");
-    printf("\n");
-
-    printf("Instruções J\n");
-    printf("\n");
-    printf("J endereço\n");
-    printf("JAL endereço\n");
-    printf("\n");
-}
-
-void print_registers(Registers *registers)
-{
-    printf("+-------------------------------------------------------------------------------------------------------------------------------------------------------+\n");
-
-    printf("| $s0: %11d | $s1: %11d | $s2: %11d | $s3: %11d | $s4: %11d | $s5: %11d | $s6: %11d | $s7: %11d |\n",
-           registers->s[0],
-           registers->s[1],
-           registers->s[2],
-           registers->s[3],
-           registers->s[4],
-           registers->s[5],
-           registers->s[6],
-           registers->s[7]);
-
-    printf("|------------------+------------------+------------------+------------------+------------------+------------------+------------------+------------------|\n");
-
-    printf("| $a0: %11d | $a1: %11d | $a2: %11d | $a3: %11d | $v0: %11d | $v1: %11d | $k0: %11d | $k1: %11d |\n",
-           registers->a[0],
-           registers->a[1],
-           registers->a[2],
-           registers->a[3],
-           registers->v[0],
-           registers->v[1],
-           registers->k[0],
-           registers->k[1]);
-
-    printf("|------------------+------------------+------------------+------------------+------------------+------------------+------------------+------------------|\n");
-
-    printf("| $t0: %11d | $t1: %11d | $t2: %11d | $t3: %11d | $t4: %11d | $t5: %11d | $t6: %11d | $t7: %11d |\n",
-           registers->t[0],
-           registers->t[1],
-           registers->t[2],
-           registers->t[3],
-           registers->t[4],
-           registers->t[5],
-           registers->t[6],
-           registers->t[7]);
-
-    printf("|------------------+------------------+------------------+------------------+------------------+------------------+------------------+------------------|\n");
-
-    printf("| $t8: %11d | $t9: %11d | $zero: %9d | $gp: %11d | $sp: %11d | $fp: %11d | $ra: %11d | $at: %11d |\n",
-           registers->t[8],
-           registers->t[9],
-           registers->zero,
-           registers->gp,
-           registers->sp,
-           registers->fp,
-           registers->ra,
-           registers->at);
-
-    printf("+-------------------------------------------------------------------------------------------------------------------------------------------------------+\n");
-}
-
-void execute_instruction(char instruction[LINE_LENGTH], CPU *cpu)
-{
-    // Gets the instruction tag
-    char *tag = strtok(instruction, " ");
-    if (tag == NULL)
-    {
-        printf("ERRO: Nenhuma tag fornecida\n");
-        return;
-    }
-
-    // Gets the instruction arguments
-    int args_length = 0;
-    char *args[INSTRUCTION_ARGS] = {0};
-    while (true)
-    {
-        char *argument = strtok(NULL, ",");
-        if (argument == NULL)
+        else if (strcmp(argv[i], "--trace-file") == 0 && i + 1 < argc)
         {
-            break;
+            trace_path = argv[++i];
         }
-
-        if (args_length >= INSTRUCTION_ARGS)
+        else if (strcmp(argv[i], "--jit-threshold") == 0 && i + 1 < argc)
         {
-            printf("ERRO: Foram providos mais argumentos do que os %d permitidos\n", INSTRUCTION_ARGS);
-            return;
+            char *end;
+            options.jit_threshold = strtoul(argv[++i], &end, 10);
+            if (*end != '\0')
+            {
+                printf("ERRO: Limite do JIT inválido \"%s\"\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--assemble") == 0 && i + 1 < argc)
+        {
+            assemble_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+        {
+            profile_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+        {
+            batch_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--fuzz") == 0 && i + 1 < argc)
+        {
+            char *end;
+            fuzz_count = strtoull(argv[++i], &end, 10);
+            if (*end != '\0' || fuzz_count == 0)
+            {
+                printf("ERRO: Quantidade de programas inválida \"%s\"\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            char *end;
+            fuzz_seed = strtoull(argv[++i], &end, 10);
+            if (*end != '\0')
+            {
+                printf("ERRO: Semente inválida \"%s\"\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            char *end;
+            threads = strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || threads == 0)
+            {
+                printf("ERRO: Quantidade de threads inválida \"%s\"\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--undo") == 0 && i + 1 < argc)
+        {
+            char *end;
+            unsigned long capacity = strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || capacity > UINT32_MAX)
+            {
+                printf("ERRO: Tamanho do histórico inválido \"%s\"\n", argv[i]);
+                return 1;
+            }
+            undo_capacity = capacity;
+        }
+        else if (strcmp(argv[i], "--stop-after") == 0 && i + 1 < argc)
+        {
+            if (!parse_count(argv[++i], &options.instruction_limit))
+            {
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 2 < argc)
+        {
+            if (!parse_count(argv[++i], &options.checkpoint_interval))
+            {
+                return 1;
+            }
+            options.checkpoint_prefix = argv[++i];
+        }
+        else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc)
+        {
+            options.snapshot_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc)
+        {
+            if (options.restore_count == SNAPSHOT_MAX_RESTORES)
+            {
+                printf("ERRO: No máximo %d snapshots podem ser restaurados\n", SNAPSHOT_MAX_RESTORES);
+                return 1;
+            }
+            restore_paths[options.restore_count++] = argv[++i];
+            options.restore_paths = restore_paths;
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+        {
+            options.statistics = true;
+        }
+        else if (strcmp(argv[i], "--pipeline") == 0)
+        {
+            timed = true;
+        }
+        else if (strcmp(argv[i], "--little-endian") == 0)
+        {
+            options.little_endian = true;
+        }
+        else if (argv[i][0] == '-' || path != NULL)
+        {
+            printf("Uso: %s [--quiet] [--trace off|words|disasm] [--trace-file rastro.bin] [--jit-threshold N] [--little-endian] "
+                   "[--delay-slots on|off] [--stats] [--pipeline] [--profile pilhas.folded] "
+                   "[--stop-after N] [--checkpoint-every N prefixo] [--snapshot estado.snap] [--restore estado.snap]... "
+                   "[programa.asm|programa.bin|programa.elf]\n",
+                   argv[0]);
+            printf("     %s [--undo N]\n", argv[0]);
+            printf("     %s --assemble saida.bin [--little-endian] programa.asm\n", argv[0]);
+            printf("     %s --batch diretório [--threads N] [--quiet] [--trace off|words|disasm] [--jit-threshold N] [--little-endian] "
+                   "[--delay-slots on|off] [--stop-after N] [--restore estado.snap]...\n",
+                   argv[0]);
+            printf("     %s --fuzz N [--seed S] [--threads N]\n", argv[0]);
+            return 1;
+        }
+        else
+        {
+            path = argv[i];
         }
-
-        args[args_length] = trim(argument);
-        args_length++;
-    }
-
-    // Executes the instruction
-    if (strcmp(tag, "ADD") == 0)
-    {
-        add(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "ADDU") == 0)
-    {
-        addu(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "ADDI") == 0)
-    {
-        addi(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "SUB") == 0)
-    {
-        sub(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "SUBU") == 0)
-    {
-        subu(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "J") == 0)
-    {
-        j(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "MULT") == 0)
-    {
-        mult(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "AND") == 0)
-    {
-        _and(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "OR") == 0)
-    {
-        _or(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "ANDI") == 0)
-    {
-        andi(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "ORI") == 0)
-    {
-        ori(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "BEQ") == 0)
-    {
-        beq(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "BNE") == 0)
-    {
-        bne(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "BLEZ") == 0)
-    {
-        blez(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "BGTZ") == 0)
-    {
-        bgtz(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "JAL") == 0)
-    {
-        jal(cpu, args, args_length);
-    }
-    else if (strcmp(tag, "JR") == 0)
-    {
-        jr(cpu, args, args_length);
-    }
-    else
-    {
-        printf("ERRO: \"%s\" não é uma tag válida\n", tag);
-        cpu->program_counter -= 4;
-    }
-}
-
-void add(CPU *cpu, char **arguments, int length)
-{
-    if (length != 3)
-    {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 3 e foram recebidos %d\n", length);
-        return;
-    }
-
-    int *ret = get_register(&cpu->registers, arguments[0]);
-    int *arg1 = get_register(&cpu->registers, arguments[1]);
-    int *arg2 = get_register(&cpu->registers, arguments[2]);
-
-    if (ret == NULL || arg1 == NULL || arg2 == NULL)
-    {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
-    }
-
-    *ret = *arg1 + *arg2;
-
-    print_instruction_r(arguments[0], arguments[1], arguments[2], 0x20);
-}
-
-void addi(CPU *cpu, char **arguments, int length)
-{
-    if (length != 3)
-    {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 3 e foram recebidos %d\n", length);
-        return;
-    }
-
-    int *ret = get_register(&cpu->registers, arguments[0]);
-    int *arg1 = get_register(&cpu->registers, arguments[1]);
-
-    if (ret == NULL || arg1 == NULL)
-    {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
-    }
-
-    errno = 0;
-    char *endarg2;
-    int arg2 = strtol(arguments[2], &endarg2, 10);
-
-    if (errno != 0 || arguments[2] == endarg2 || *endarg2 != '\0')
-    {
-        printf("ERRO: Instrução inválida, número imediato inválido\n");
-    }
-
-    *ret = *arg1 + arg2;
-
-    print_instruction_i(0x8, arguments[0], arguments[1], arg2);
-}
-
-void addu(CPU *cpu, char **arguments, int length)
-{
-    if (length != 3)
-    {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 3 e foram recebidos %d\n", length);
-        return;
-    }
-
-    unsigned int *ret = (unsigned int *)get_register(&cpu->registers, arguments[0]);
-    unsigned int *arg1 = (unsigned int *)get_register(&cpu->registers, arguments[1]);
-    unsigned int *arg2 = (unsigned int *)get_register(&cpu->registers, arguments[2]);
-
-    if (ret == NULL || arg1 == NULL || arg2 == NULL)
-    {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
-    }
-
-    *ret = *arg1 + *arg2;
-
-    print_instruction_r(arguments[0], arguments[1], arguments[2], 0x21);
-}
-
-void sub(CPU *cpu, char **arguments, int length)
-{
-    if (length != 3)
-    {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 3 e foram recebidos %d\n", length);
-        return;
-    }
-
-    int *ret = get_register(&cpu->registers, arguments[0]);
-    int *arg1 = get_register(&cpu->registers, arguments[1]);
-    int *arg2 = get_register(&cpu->registers, arguments[2]);
-
-    if (ret == NULL || arg1 == NULL || arg2 == NULL)
-    {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
-    }
-
-    *ret = *arg1 - *arg2;
-
-    print_instruction_r(arguments[0], arguments[1], arguments[2], 0x22);
-}
-
-void subu(CPU *cpu, char **arguments, int length)
-{
-    if (length != 3)
-    {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 3 e foram recebidos %d\n", length);
-        return;
-    }
-
-    unsigned int *ret = (unsigned int *)get_register(&cpu->registers, arguments[0]);
-    unsigned int *arg1 = (unsigned int *)get_register(&cpu->registers, arguments[1]);
-    unsigned int *arg2 = (unsigned int *)get_register(&cpu->registers, arguments[2]);
-
-    if (ret == NULL || arg1 == NULL || arg2 == NULL)
-    {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
-    }
-
-    *ret = *arg1 - *arg2;
-
-    print_instruction_r(arguments[0], arguments[1], arguments[2], 0x23);
-}
-
-void j(CPU *cpu, char **arguments, int length)
-{
-    if (length != 1)
-    {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 1 e foram recebidos %d\n", length);
-        return;
-    }
-
-    errno = 0;
-    char *end;
-    int arg = strtol(arguments[0], &end, 10);
-
-    if (errno != 0 || arguments[0] == end || *end != '\0')
-    {
-        printf("ERRO: Instrução inválida, endereço inválido\n");
-    }
-
-    cpu->program_counter = arg - 4;
-
-    print_instruction_j(0x2, arg);
-}
-
-void mult(CPU *cpu, char **arguments, int length)
-{
-    if (length != 3)
-    {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 3 e foram recebidos %d\n", length);
-        return;
-    }
-
-    int *ret = get_register(&cpu->registers, arguments[0]);
-    int *arg1 = get_register(&cpu->registers, arguments[1]);
-    int *arg2 = get_register(&cpu->registers, arguments[2]);
-
-    if (ret == NULL || arg1 == NULL || arg2 == NULL)
-    {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
-    }
-
-    *ret = *arg1 * *arg2;
-
-    print_instruction_r(arguments[0], arguments[1], arguments[2], 0x18);
-}
-
-void _and(CPU *cpu, char **arguments, int length)
-{
-    if (length != 3)
-    {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 3 e foram recebidos %d\n", length);
-        return;
-    }
-
-    int *ret = get_register(&cpu->registers, arguments[0]);
-    int *arg1 = get_register(&cpu->registers, arguments[1]);
-    int *arg2 = get_register(&cpu->registers, arguments[2]);
-
-    if (ret == NULL || arg1 == NULL || arg2 == NULL)
-    {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
-    }
-
-    *ret = *arg1 & *arg2;
-
-    print_instruction_r(arguments[0], arguments[1], arguments[2], 0x24);
-}
-
-void _or(CPU *cpu, char **arguments, int length)
-{
-    if (length != 3)
-    {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 3 e foram recebidos %d\n", length);
-        return;
-    }
-
-    int *ret = get_register(&cpu->registers, arguments[0]);
-    int *arg1 = get_register(&cpu->registers, arguments[1]);
-    int *arg2 = get_register(&cpu->registers, arguments[2]);
-
-    if (ret == NULL || arg1 == NULL || arg2 == NULL)
-    {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
-    }
-
-    *ret = *arg1 | *arg2;
-
-    print_instruction_r(arguments[0], arguments[1], arguments[2], 0x25);
-}
-
-void andi(CPU *cpu, char **arguments, int length)
-{
-    if (length != 3)
-    {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 3 e foram recebidos %d\n", length);
-        return;
-    }
-
-    int *ret = get_register(&cpu->registers, arguments[0]);
-    int *arg1 = get_register(&cpu->registers, arguments[1]);
-
-    if (ret == NULL || arg1 == NULL)
-    {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
-    }
-
-    errno = 0;
-    char *endarg2;
-    int arg2 = strtol(arguments[2], &endarg2, 10);
-
-    if (errno != 0 || arguments[2] == endarg2 || *endarg2 != '\0')
-    {
-        printf("ERRO: Instrução inválida, número imediato inválido\n");
-    }
-
-    *ret = *arg1 & arg2;
-
-    print_instruction_i(0x0C, arguments[0], arguments[1], arg2);
-}
-
-void ori(CPU *cpu, char **arguments, int length)
-{
-
-    if (length != 3)
-    {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 3 e foram recebidos %d\n", length);
-        return;
-    }
-
-    int *ret = get_register(&cpu->registers, arguments[0]);
-    int *arg1 = get_register(&cpu->registers, arguments[1]);
-
-    if (ret == NULL || arg1 == NULL)
-    {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
-    }
-
-    errno = 0;
-    char *endarg2;
-    int arg2 = strtol(arguments[2], &endarg2, 10);
-
-    if (errno != 0 || arguments[2] == endarg2 || *endarg2 != '\0')
-    {
-        printf("ERRO: Instrução inválida, número imediato inválido\n");
-    }
-
-    *ret = *arg1 | arg2;
-
-    print_instruction_i(0x0D, arguments[0], arguments[1], arg2);
-}
-
-void beq(CPU *cpu, char **arguments, int length)
-{
-    if (length != 3)
-    {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 3 e foram recebidos %d\n", length);
-        return;
     }
 
-    int *arg1 = get_register(&cpu->registers, arguments[0]);
-    int *arg2 = get_register(&cpu->registers, arguments[1]);
+    cpu.memory.little_endian = options.little_endian;
 
-    if (arg1 == NULL || arg2 == NULL)
+    if (assemble_path != NULL)
     {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
+        return run_assembler(path, assemble_path, options.little_endian);
     }
 
-    errno = 0;
-    char *endlabel;
-    int label = strtol(arguments[2], &endlabel, 10);
-
-    if (errno != 0 || arguments[2] == endlabel || *endlabel != '\0')
+    // Generated programs run on every engine with nothing else attached, as that is what is compared
+    if (fuzz_count != 0)
     {
-        printf("ERRO: Instrução inválida, número imediato inválido\n");
+        if (path != NULL || batch_path != NULL)
+        {
+            printf("ERRO: --fuzz gera os próprios programas e não pode ser combinado com um programa ou --batch\n");
+            return 1;
+        }
+        return run_fuzz(fuzz_count, fuzz_seed, threads);
     }
 
-    if (*arg1 == *arg2)
+    if (batch_path != NULL)
     {
-        cpu->program_counter = label - 4;
+        // Each program of a batch gets its own trace inside its own output, only when asked for
+        if (trace_path != NULL || profile_path != NULL || options.statistics || timed || path != NULL ||
+            options.snapshot_path != NULL || options.checkpoint_interval != 0)
+        {
+            printf("ERRO: --batch não pode ser combinado com um programa, --trace-file, --profile, --stats, --pipeline, "
+                   "--snapshot ou --checkpoint-every\n");
+            return 1;
+        }
+        return run_directory(batch_path, &options, trace_chosen ? trace_level : TRACE_OFF, threads);
     }
 
-    print_instruction_j(0x4, label);
-}
-
-void bne(CPU *cpu, char **arguments, int length)
-{
-    if (length != 3)
+    // Instructions typed one at a time run as soon as they are entered, with nothing to fill a delay slot yet
+    if (path == NULL && options.delay_slots == DELAY_SLOTS_ON)
     {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 3 e foram recebidos %d\n", length);
-        return;
+        printf("ERRO: O modo interativo não tem delay slots\n");
+        return 1;
     }
 
-    int *arg1 = get_register(&cpu->registers, arguments[0]);
-    int *arg2 = get_register(&cpu->registers, arguments[1]);
-
-    if (arg1 == NULL || arg2 == NULL)
+    // Without a text or binary trace nothing is reported, and the interpreter skips tracing entirely
+    Trace trace;
+    if (trace_level != TRACE_OFF || trace_path != NULL)
     {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
+        if (!open_trace(&trace, trace_level, stdout, trace_path))
+        {
+            return 1;
+        }
+        options.trace = &trace;
     }
 
-    errno = 0;
-    char *endlabel;
-    int label = strtol(arguments[2], &endlabel, 10);
-
-    if (errno != 0 || arguments[2] == endlabel || *endlabel != '\0')
+    Profile profile = {0};
+    if (profile_path != NULL)
     {
-        printf("ERRO: Instrução inválida, número imediato inválido\n");
+        options.profile = &profile;
     }
 
-    if (*arg1 != *arg2)
+    Pipeline pipeline = {0};
+    if (timed)
     {
-        cpu->program_counter = label - 4;
+        options.pipeline = &pipeline;
     }
 
-    print_instruction_j(0x5, label);
-}
-
-void blez(CPU *cpu, char **arguments, int length)
-{
-
-    if (length != 3)
+    // Only the REPL can go back through the history, so only it keeps one
+    UndoLog undo;
+    if (path == NULL && undo_capacity != 0)
     {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 3 e foram recebidos %d\n", length);
-        return;
+        if (!open_undo(&undo, undo_capacity))
+        {
+            printf("ERRO: Memória insuficiente para o histórico de execução\n");
+            return 1;
+        }
+        options.undo = &undo;
     }
 
-    int *arg1 = get_register(&cpu->registers, arguments[0]);
-    int *arg2 = get_register(&cpu->registers, arguments[1]);
-
-    if (arg1 == NULL || arg2 == NULL)
+    // The REPL reads its instructions from stdin, so only a program run from a file can read it
+    Console console;
+    if (!open_console(&console, stdout, path != NULL ? stdin : NULL))
     {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
+        return 1;
     }
+    options.console = &console;
 
-    errno = 0;
-    char *endlabel;
-    int label = strtol(arguments[2], &endlabel, 10);
-
-    if (errno != 0 || arguments[2] == endlabel || *endlabel != '\0')
+    int status;
+    if (path != NULL)
     {
-        printf("ERRO: Instrução inválida, número imediato inválido\n");
+        status = run_file(&cpu, &program, path, &options);
     }
-
-    if (*arg1 <= *arg2)
+    else
     {
-        cpu->program_counter = label - 4;
+        status = run_repl(&cpu, &program, &options);
     }
 
-    print_instruction_j(0x6, label);
-}
+    close_console(&console);
 
-void bgtz(CPU *cpu, char **arguments, int length)
-{
-
-    if (length != 3)
+    if (options.undo != NULL)
     {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 3 e foram recebidos %d\n", length);
-        return;
+        free_undo(options.undo);
     }
 
-    int *arg1 = get_register(&cpu->registers, arguments[0]);
-    int *arg2 = get_register(&cpu->registers, arguments[1]);
-
-    if (arg1 == NULL || arg2 == NULL)
+    if (options.profile != NULL)
     {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
+        print_profile(&profile, &program);
+        if (!write_folded_stacks(&profile, profile_path))
+        {
+            status = 1;
+        }
+        free_profile(&profile);
     }
 
-    errno = 0;
-    char *endlabel;
-    int label = strtol(arguments[2], &endlabel, 10);
-
-    if (errno != 0 || arguments[2] == endlabel || *endlabel != '\0')
+    if (options.pipeline != NULL)
     {
-        printf("ERRO: Instrução inválida, número imediato inválido\n");
+        print_pipeline(&pipeline, stdout);
     }
 
-    if (*arg1 > *arg2)
+    if (options.trace != NULL)
     {
-        cpu->program_counter = label - 4;
+        close_trace(options.trace);
     }
 
-    print_instruction_j(0x7, label);
+    free_program(&program);
+    free_memory(&cpu.memory);
+    return status;
 }
 
-void jal(CPU *cpu, char **arguments, int length)
+int run_repl(CPU *cpu, Program *program, const Options *options)
 {
-    if (length != 1)
-    {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 1 e foram recebidos %d\n", length);
-        return;
-    }
-
-    errno = 0;
-    char *end;
-    int label = strtol(arguments[0], &end, 10);
-
-    if (errno != 0 || arguments[0] == end || *end != '\0')
-    {
-        printf("ERRO: Instrução inválida, endereço inválido\n");
-    }
+    print_registers(cpu, options->output);
 
-    cpu->registers.ra = cpu->program_counter;
-    cpu->program_counter = label - 4;
+    // Instructions piped in are not prompted for
+    bool interactive = isatty(STDIN_FILENO);
 
-    print_instruction_j(0x3, label);
-}
+    Source input;
+    open_stream(&input, STDIN_FILENO);
 
-void jr(CPU *cpu, char **arguments, int length)
-{
-    if (length != 1)
-    {
-        printf("ERRO: Quantidade inesperada de argumetos, eram esperados 1 e foram recebidos %d\n", length);
-        return;
-    }
-
-    int *reg = get_register(&cpu->registers, arguments[0]);
-
-    if (reg == NULL)
+    while (true)
     {
-        printf("ERRO: Instrução inválida, registrador não encontrado\n");
-        return;
-    }
-
-    cpu->program_counter = *reg - 4;
-
-    print_instruction_r(arguments[0], "$zero", "$zero", 0x8);
-}
+        // Gets the instruction from the user
+        Slice instruction;
+        if (interactive)
+        {
+            printf("%11u > ", cpu->program_counter);
+            fflush(stdout);
+        }
+        if (!next_line(&input, &instruction))
+        {
+            break;
+        }
 
-int *get_register(Registers *registers, char *register_name)
-{
-    if (register_name[0] != '$')
-    {
-        return NULL;
-    }
+        // Lines with only a comment are skipped
+        if (instruction.length == 0)
+        {
+            continue;
+        }
 
-    char first = register_name[1];
-    char second = register_name[2];
+        // If instruction is HELP, show supported tags
+        if (slice_equals(instruction, "HELP"))
+        {
+            print_help();
+            continue;
+        }
 
-    switch (first)
-    {
-    case 't':
-    case 's':
-    case 'a':
-    case 'k':
-    case 'v':
-        if (second < '0' || second > '9')
+        // If instruction is DEBUG, show register values
+        if (slice_equals(instruction, "DEBUG"))
         {
-            break;
+            print_registers(cpu, options->output);
+            continue;
         }
-        int index = second - '0';
 
-        if (first == 't')
+        // If instruction is EXIT, end program
+        if (slice_equals(instruction, "EXIT"))
         {
-            return &registers->t[index];
+            break;
         }
-        if (first == 's' && index < 8)
+
+        if (run_history_command(cpu, program, options, instruction))
         {
-            return &registers->s[index];
+            continue;
         }
-        if (first == 'a' && index < 4)
+
+        Instruction decoded;
+        if (!decode_instruction(instruction, &decoded, NULL, options->output))
         {
-            return &registers->a[index];
+            continue;
         }
-        if (first == 'k' && index < 2)
+
+        // Replaying from a checkpoint would execute the new instruction instead of the one it replaces
+        if (options->undo != NULL && cpu->program_counter - program->base < 4 * program->length)
         {
-            return &registers->k[index];
+            forget_checkpoints(options->undo);
         }
-        if (first == 'v' && index < 2)
+
+        // An address the program cannot hold leaves the session as it was
+        if (!store_instruction(program, cpu->program_counter, decoded, options->output))
         {
-            return &registers->v[index];
+            continue;
         }
-        return NULL;
-    }
 
-    if (strcmp(register_name, "$zero") == 0)
-    {
-        return &registers->zero;
-    }
-    if (strcmp(register_name, "$gp") == 0)
-    {
-        return &registers->gp;
-    }
-    if (strcmp(register_name, "$sp") == 0)
-    {
-        return &registers->sp;
-    }
-    if (strcmp(register_name, "$fp") == 0)
-    {
-        return &registers->fp;
-    }
-    if (strcmp(register_name, "$ra") == 0)
-    {
-        return &registers->ra;
-    }
-    if (strcmp(register_name, "$at") == 0)
-    {
-        return &registers->at;
+        // Runs the stored program, so a branch back to a previous address executes it again
+        run_program(cpu, program, options);
     }
 
-    return NULL;
+    close_source(&input);
+    return 0;
 }
 
-char get_register_index(char *register_name)
+/// @brief Handles BACK [N], STEP [N] and REVERSE endereço, returning false for anything else.
+///
+/// Moving through the history is silent, the registers are printed once it is done.
+bool run_history_command(CPU *cpu, Program *program, const Options *options, Slice command)
 {
-    if (register_name[0] != '$')
-    {
-        return -1;
-    }
+    Slice rest = command;
+    Slice name = next_word(&rest);
 
-    char first = register_name[1];
-    char second = register_name[2];
-
-    if (strcmp(register_name, "$zero") == 0)
+    bool back = slice_equals(name, "BACK");
+    bool step = slice_equals(name, "STEP");
+    bool reverse = slice_equals(name, "REVERSE");
+    if (!back && !step && !reverse)
     {
-        return 0;
+        return false;
     }
 
-    if (strcmp(register_name, "$at") == 0)
-    {
-        return 1;
-    }
+    int64_t count = 1;
+    Slice number = next_word(&rest);
+    bool valid = number.length == 0 ? !reverse : parse_integer(number, 0, INT64_MAX, &count);
+    unsigned long long argument = count;
 
-    if (first == 'v' && second - '0' < 2)
+    if (!valid || rest.length != 0)
     {
-        return 2 + second - '0';
+        fprintf(options->output, "ERRO: Uso: BACK [N], STEP [N] ou REVERSE endereço\n");
+        return true;
     }
 
-    if (first == 'a' && second - '0' < 4)
+    if (options->undo == NULL)
     {
-        return 4 + second - '0';
+        fprintf(options->output, "ERRO: O histórico de execução está desligado\n");
+        return true;
     }
 
-    if (first == 't' && second - '0' < 8)
+    if (back)
     {
-        return 8 + second - '0';
+        uint64_t target = cpu->instructions > argument ? cpu->instructions - argument : 0;
+        if (!seek_instruction(cpu, program, options, target))
+        {
+            fprintf(options->output, "AVISO: O histórico só alcança a instrução %llu\n",
+                    (unsigned long long)cpu->instructions);
+        }
     }
-
-    if (first == 's' && second - '0' < 8)
+    else if (step)
     {
-        return 16 + second - '0';
+        if (!seek_instruction(cpu, program, options, cpu->instructions + argument))
+        {
+            fprintf(options->output, "AVISO: O programa parou na instrução %llu\n", (unsigned long long)cpu->instructions);
+        }
     }
-
-    if (first == 't' && second - '8' < 2)
+    else if (!reverse_to(cpu, program, options, argument))
     {
-        return 24 + second - '8';
+        fprintf(options->output, "AVISO: O endereço %llu não foi executado desde a instrução %llu\n", argument,
+                (unsigned long long)cpu->instructions);
     }
 
-    if (first == 'k' && second - '0' < 8)
-    {
-        return 26 + second - '0';
-    }
+    print_registers(cpu, options->output);
+    return true;
+}
 
-    if (strcmp(register_name, "$gp") == 0)
+int run_assembler(char *path, char *output_path, bool little_endian)
+{
+    if (path == NULL)
     {
-        return 28;
+        printf("ERRO: Nenhum programa para montar\n");
+        return 1;
     }
 
-    if (strcmp(register_name, "$sp") == 0)
+    // Errors are printed to stdout, so the words cannot go there as well, and "-" would only name a file
+    if (strcmp(output_path, "-") == 0)
     {
-        return 29;
+        printf("ERRO: --assemble precisa de um arquivo de saída, \"-\" não é aceito\n");
+        return 1;
     }
 
-    if (strcmp(register_name, "$fp") == 0)
+    Source input;
+    if (!open_source(&input, path, stdout))
     {
-        return 30;
+        return 1;
     }
 
-    if (strcmp(register_name, "$ra") == 0)
+    FILE *output = fopen(output_path, "wb");
+    if (output == NULL)
     {
-        return 31;
+        printf("ERRO: Não foi possível criar o arquivo \"%s\"\n", output_path);
+        close_source(&input);
+        return 1;
     }
 
-    printf("ERRO: Registrador não encontrado");
-    return -1;
-}
-
-char *trim(char *string)
-{
-    while (true)
-    {
-        if (!is_whitespace(string[0]))
-        {
-            break;
-        }
-        string = string + 1;
-    }
+    bool assembled = assemble_file(&input, output, little_endian);
+    close_source(&input);
 
-    int length = strlen(string);
-    while (length > 0)
+    if (fclose(output) != 0 || !assembled)
     {
-        if (!is_whitespace(string[length - 1]))
-        {
-            break;
-        }
-        string[length - 1] = '\0';
-        length--;
+        remove(output_path);
+        return 1;
     }
 
-    return string;
+    return 0;
 }
 
-bool is_whitespace(char character)
+bool parse_count(const char *argument, uint64_t *count)
 {
-    switch (character)
+    char *end;
+    *count = strtoull(argument, &end, 10);
+    if (*end != '\0' || *count == 0)
     {
-    case ' ':
-    case '\n':
-        return true;
-    default:
+        printf("ERRO: Quantidade de instruções inválida \"%s\"\n", argument);
         return false;
     }
+
+    return true;
 }
 
-void print_instruction_r(char *reg0, char *reg1, char *reg2, unsigned char funct)
+void print_help()
 {
-    char reg0_index = get_register_index(reg0);
-    char reg1_index = get_register_index(reg1);
-    char reg2_index = get_register_index(reg2);
+    printf("\n");
+    printf("HELP\n");
+    printf("\n");
 
-    if (reg0_index == -1 || reg1_index == -1 || reg2_index == -1)
-    {
-        printf("ERRO: Registrador não encontrado\n");
-        return;
-    }
+    printf("Instruções implementadas\n");
+    printf("\n");
 
-    printf("EXECUTE -> 0 %d %d %d 0 %d\n", reg0_index, reg1_index, reg2_index, funct);
-}
+    printf("Instruções R\n");
+    printf("\n");
+    printf("ADD registrador0, registrador1, registrador2\n");
+    printf("SUB registrador0, registrador1, registrador2\n");
+    printf("ADDU registrador0, registrador1, registrador2\n");
+    printf("SUBU registrador0, registrador1, registrador2\n");
+    printf("MUL registrador0, registrador1, registrador2\n");
+    printf("AND registrador0, registrador1, registrador2\n");
+    printf("OR registrador0, registrador1, registrador2\n");
+    printf("XOR registrador0, registrador1, registrador2\n");
+    printf("NOR registrador0, registrador1, registrador2\n");
+    printf("SLT registrador0, registrador1, registrador2\n");
+    printf("SLTU registrador0, registrador1, registrador2\n");
+    printf("MOVZ registrador0, registrador1, registrador2\n");
+    printf("MOVN registrador0, registrador1, registrador2\n");
+    printf("SLL registrador0, registrador1, deslocamento\n");
+    printf("SRL registrador0, registrador1, deslocamento\n");
+    printf("SRA registrador0, registrador1, deslocamento\n");
+    printf("SLLV registrador0, registrador1, registrador2\n");
+    printf("SRLV registrador0, registrador1, registrador2\n");
+    printf("SRAV registrador0, registrador1, registrador2\n");
+    printf("CLZ registrador0, registrador1\n");
+    printf("CLO registrador0, registrador1\n");
+    printf("JR registrador0\n");
+    printf("JALR [registrador0,] registrador1\n");
+    printf("NOP\n");
+    printf("SYSCALL\n");
+    printf("\n");
 
-void print_instruction_i(unsigned char opcode, char *reg0, char *reg1, short immediate)
-{
-    char reg0_index = get_register_index(reg0);
-    char reg1_index = get_register_index(reg1);
+    printf("Instruções com HI e LO\n");
+    printf("\n");
+    printf("MULT registrador0, registrador1\n");
+    printf("MULTU registrador0, registrador1\n");
+    printf("DIV registrador0, registrador1\n");
+    printf("DIVU registrador0, registrador1\n");
+    printf("MADD registrador0, registrador1\n");
+    printf("MADDU registrador0, registrador1\n");
+    printf("MSUB registrador0, registrador1\n");
+    printf("MSUBU registrador0, registrador1\n");
+    printf("MFHI registrador0\n");
+    printf("MFLO registrador0\n");
+    printf("MTHI registrador0\n");
+    printf("MTLO registrador0\n");
+    printf("\n");
 
-    if (reg0_index == -1 || reg1_index == -1)
-    {
-        printf("ERRO: Registrador não encontrado\n");
-        return;
-    }
+    printf("Instruções I\n");
+    printf("\n");
+    printf("ADDI registrador0, registrador1, imediato\n");
+    printf("ADDIU registrador0, registrador1, imediato\n");
+    printf("SLTI registrador0, registrador1, imediato\n");
+    printf("SLTIU registrador0, registrador1, imediato\n");
+    printf("ANDI registrador0, registrador1, imediato\n");
+    printf("ORI registrador0, registrador1, imediato\n");
+    printf("XORI registrador0, registrador1, imediato\n");
+    printf("LUI registrador0, imediato\n");
+    printf("BEQ registrador0, registrador1, endereço\n");
+    printf("BNE registrador0, registrador1, endereço\n");
+    printf("BLEZ registrador0, registrador1, endereço\n");
+    printf("BGTZ registrador0, registrador1, endereço\n");
+    printf("BLTZ registrador0, endereço\n");
+    printf("BGEZ registrador0, endereço\n");
+    printf("BLTZAL registrador0, endereço\n");
+    printf("BGEZAL registrador0, endereço\n");
+    printf("\n");
 
-    printf("EXECUTE -> %d %d %d %d\n", opcode, reg0_index, reg1_index, immediate);
-}
+    printf("Instruções J\n");
+    printf("\n");
+    printf("J endereço\n");
+    printf("JAL endereço\n");
+    printf("\n");
+    printf("Desvios e saltos não têm delay slot: valem logo, e os que ligam guardam o endereço seguinte\n");
+    printf("\n");
 
-void print_instruction_j(unsigned char opcode, int address)
-{
-    printf("EXECUTE -> %d %d\n", opcode, address);
+    printf("Instruções de memória\n");
+    printf("\n");
+    printf("LW registrador0, deslocamento(registrador1)\n");
+    printf("LWL registrador0, deslocamento(registrador1)\n");
+    printf("LWR registrador0, deslocamento(registrador1)\n");
+    printf("LH registrador0, deslocamento(registrador1)\n");
+    printf("LHU registrador0, deslocamento(registrador1)\n");
+    printf("LB registrador0, deslocamento(registrador1)\n");
+    printf("LBU registrador0, deslocamento(registrador1)\n");
+    printf("SW registrador0, deslocamento(registrador1)\n");
+    printf("SWL registrador0, deslocamento(registrador1)\n");
+    printf("SWR registrador0, deslocamento(registrador1)\n");
+    printf("SH registrador0, deslocamento(registrador1)\n");
+    printf("SB registrador0, deslocamento(registrador1)\n");
+    printf("\n");
+
+    printf("Chamadas de sistema, com o número em $v0 e os argumentos em $a0 e $a1\n");
+    printf("\n");
+    printf("1 imprime inteiro       4 imprime string       5 lê inteiro           8 lê string\n");
+    printf("9 sbrk                  10 encerra             11 imprime caractere   12 lê caractere\n");
+    printf("17 encerra com $a0      34 imprime hexadecimal 35 imprime binário     36 imprime sem sinal\n");
+    printf("\n");
+
+    printf("Histórico de execução\n");
+    printf("\n");
+    printf("BACK [N]           volta N instruções, 1 se omitido\n");
+    printf("STEP [N]           executa N instruções, 1 se omitido\n");
+    printf("REVERSE endereço   volta até a última execução do endereço\n");
+    printf("\n");
 }
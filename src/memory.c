@@ -0,0 +1,244 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "memory.h"
+
+static PageTable *find_table(Memory *memory, uint32_t page_number, uint32_t address);
+static uint8_t *allocate_page(Memory *memory);
+
+/// @brief Slow path of translate_address, walks the page table and allocates what is missing.
+uint8_t *find_page(Memory *memory, uint32_t address)
+{
+    uint32_t page_number = address >> PAGE_BITS;
+    PageTable *table = find_table(memory, page_number, address);
+    if (table == NULL)
+    {
+        return NULL;
+    }
+
+    uint8_t **page = &table->pages[page_number & (TABLE_SIZE - 1)];
+    if (*page == NULL)
+    {
+        *page = allocate_page(memory);
+        if (*page == NULL)
+        {
+            memory->fault = MEMORY_EXHAUSTED;
+            memory->fault_address = address;
+            return NULL;
+        }
+    }
+
+    memory->cached_tag = page_number + 1;
+    memory->cached_page = *page;
+    return *page + (address & PAGE_MASK);
+}
+
+/// @brief Slow path of translate_write, which also marks the page dirty.
+uint8_t *find_written_page(Memory *memory, uint32_t address)
+{
+    uint8_t *byte = find_page(memory, address);
+    if (byte == NULL)
+    {
+        return NULL;
+    }
+
+    uint32_t page_number = address >> PAGE_BITS;
+    unsigned int index = page_number & (TABLE_SIZE - 1);
+    memory->directory[page_number >> TABLE_BITS]->dirty[index / 32] |= 1u << (index % 32);
+
+    memory->written_tag = page_number + 1;
+    memory->written_page = memory->cached_page;
+    return byte;
+}
+
+/// @brief Backs a page with data owned by someone else, such as a mapped snapshot, replacing what it held.
+bool map_page(Memory *memory, uint32_t page_number, uint8_t *data)
+{
+    PageTable *table = find_table(memory, page_number, page_number << PAGE_BITS);
+    if (table == NULL)
+    {
+        return false;
+    }
+
+    unsigned int index = page_number & (TABLE_SIZE - 1);
+    table->pages[index] = data;
+    table->dirty[index / 32] &= ~(1u << (index % 32));
+
+    // Either cache may point to the page that was replaced
+    memory->cached_tag = 0;
+    memory->written_tag = 0;
+    return true;
+}
+
+/// @brief Forgets which pages were written, so the next incremental snapshot starts from here.
+void clean_pages(Memory *memory)
+{
+    for (unsigned int i = 0; i < TABLE_SIZE; i++)
+    {
+        if (memory->directory[i] != NULL)
+        {
+            memset(memory->directory[i]->dirty, 0, sizeof(memory->directory[i]->dirty));
+        }
+    }
+
+    // The next write to the cached page has to mark it again
+    memory->written_tag = 0;
+}
+
+/// @brief Numbers of the pages that exist, or only of those written since the last snapshot, in ascending order.
+///
+/// The list is allocated, and NULL when that fails.
+uint32_t *list_pages(const Memory *memory, bool dirty, uint32_t *page_count)
+{
+    uint32_t count = 0;
+    uint32_t capacity = 64;
+    uint32_t *page_numbers = malloc(capacity * sizeof(*page_numbers));
+
+    for (uint32_t table = 0; page_numbers != NULL && table < TABLE_SIZE; table++)
+    {
+        if (memory->directory[table] == NULL)
+        {
+            continue;
+        }
+
+        for (uint32_t index = 0; index < TABLE_SIZE; index++)
+        {
+            if (memory->directory[table]->pages[index] == NULL || (dirty && !is_dirty(memory->directory[table], index)))
+            {
+                continue;
+            }
+
+            if (count == capacity)
+            {
+                uint32_t *grown = realloc(page_numbers, 2 * capacity * sizeof(*page_numbers));
+                if (grown == NULL)
+                {
+                    free(page_numbers);
+                    return NULL;
+                }
+                page_numbers = grown;
+                capacity *= 2;
+            }
+
+            page_numbers[count++] = table << TABLE_BITS | index;
+        }
+    }
+
+    *page_count = count;
+    return page_numbers;
+}
+
+void misaligned_access(Memory *memory, uint32_t address)
+{
+    memory->fault = MEMORY_MISALIGNED;
+    memory->fault_address = address;
+}
+
+void print_memory_fault(const Memory *memory, FILE *output)
+{
+    switch (memory->fault)
+    {
+    case MEMORY_MISALIGNED:
+        fprintf(output, "ERRO: Acesso desalinhado ao endereço 0x%08x\n", memory->fault_address);
+        break;
+    case MEMORY_EXHAUSTED:
+        fprintf(output, "ERRO: Memória insuficiente para o endereço 0x%08x\n", memory->fault_address);
+        break;
+    case MEMORY_OK:
+        break;
+    }
+}
+
+/// @brief Copies bytes into memory as they are, such as the data segments of an executable.
+bool write_memory(Memory *memory, uint32_t address, const uint8_t *bytes, size_t length)
+{
+    while (length > 0)
+    {
+        uint8_t *destination = translate_write(memory, address);
+        if (destination == NULL)
+        {
+            return false;
+        }
+
+        // Copies up to the end of the current page
+        size_t chunk = PAGE_SIZE - (address & PAGE_MASK);
+        if (chunk > length)
+        {
+            chunk = length;
+        }
+
+        memcpy(destination, bytes, chunk);
+        address += chunk;
+        bytes += chunk;
+        length -= chunk;
+    }
+
+    return true;
+}
+
+void free_memory(Memory *memory)
+{
+    for (unsigned int i = 0; i < TABLE_SIZE; i++)
+    {
+        free(memory->directory[i]);
+        memory->directory[i] = NULL;
+    }
+
+    while (memory->arena != NULL)
+    {
+        PageArena *next = memory->arena->next;
+        free(memory->arena);
+        memory->arena = next;
+    }
+
+    while (memory->mappings != NULL)
+    {
+        Mapping *next = memory->mappings->next;
+        munmap(memory->mappings->address, memory->mappings->size);
+        free(memory->mappings);
+        memory->mappings = next;
+    }
+
+    memory->cached_tag = 0;
+    memory->cached_page = NULL;
+    memory->written_tag = 0;
+    memory->written_page = NULL;
+
+    // No incremental snapshot applies to whatever is written next
+    memory->snapshot_series = 0;
+}
+
+static PageTable *find_table(Memory *memory, uint32_t page_number, uint32_t address)
+{
+    PageTable **table = &memory->directory[page_number >> TABLE_BITS];
+    if (*table == NULL)
+    {
+        *table = calloc(1, sizeof(PageTable));
+        if (*table == NULL)
+        {
+            memory->fault = MEMORY_EXHAUSTED;
+            memory->fault_address = address;
+        }
+    }
+
+    return *table;
+}
+
+static uint8_t *allocate_page(Memory *memory)
+{
+    if (memory->arena == NULL || memory->arena->used == ARENA_PAGES)
+    {
+        // Pages must read as zero until they are written
+        PageArena *arena = calloc(1, sizeof(PageArena));
+        if (arena == NULL)
+        {
+            return NULL;
+        }
+
+        arena->next = memory->arena;
+        memory->arena = arena;
+    }
+
+    return memory->arena->pages[memory->arena->used++];
+}
@@ -0,0 +1,266 @@
+#include <stdio.h>
+
+#include "pipeline.h"
+
+/*
+ * The model follows the textbook IF/ID/EX/MEM/WB pipeline with full forwarding. Every result can be
+ * forwarded from the end of the stage that computes it: EX for arithmetic and JAL, MEM for loads.
+ * Branches and JR compare or read their registers in ID, where their target is known, and
+ * instructions after them are fetched as if they were not taken, except that a delay slot is never
+ * dropped. An instruction waits in ID until each of its operands can reach the stage that needs it,
+ * which is all a hazard costs here.
+ *
+ * It only sees the instructions once they have executed, a block at a time, so execution itself is
+ * the same with or without it.
+ */
+
+typedef enum Stage Stage;
+typedef enum Destination Destination;
+typedef struct Timing Timing;
+
+enum Stage
+{
+    /// @brief The register is not read, or nothing is written.
+    STAGE_NONE,
+    STAGE_IF,
+    STAGE_ID,
+    STAGE_EX,
+    STAGE_MEM,
+    STAGE_WB,
+};
+
+enum Destination
+{
+    DESTINATION_NONE,
+    DESTINATION_RD,
+    DESTINATION_RT,
+    DESTINATION_RA,
+};
+
+/// @brief When an instruction goes through the pipeline, as far as hazards are concerned.
+struct Timing
+{
+    /// @brief Stages rs and rt are needed in.
+    uint8_t rs;
+    uint8_t rt;
+
+    /// @brief Register the result goes to, one of Destination.
+    uint8_t destination;
+
+    /// @brief Stage the result is known at the end of.
+    uint8_t result;
+};
+
+#define TIMING_R {STAGE_EX, STAGE_EX, DESTINATION_RD, STAGE_EX}
+#define TIMING_I {STAGE_EX, STAGE_NONE, DESTINATION_RT, STAGE_EX}
+#define TIMING_BRANCH {STAGE_ID, STAGE_ID, DESTINATION_NONE, STAGE_NONE}
+#define TIMING_LOAD {STAGE_EX, STAGE_NONE, DESTINATION_RT, STAGE_MEM}
+#define TIMING_STORE {STAGE_EX, STAGE_MEM, DESTINATION_NONE, STAGE_NONE}
+#define TIMING_SHIFT {STAGE_NONE, STAGE_EX, DESTINATION_RD, STAGE_EX}
+#define TIMING_UNARY {STAGE_EX, STAGE_NONE, DESTINATION_RD, STAGE_EX}
+#define TIMING_BRANCH_ZERO {STAGE_ID, STAGE_NONE, DESTINATION_NONE, STAGE_NONE}
+
+// HI and LO are not tracked, as if the multiply and divide unit always had them ready by the time
+// MFHI or MFLO reads them
+#define TIMING_HI_LO {STAGE_EX, STAGE_EX, DESTINATION_NONE, STAGE_NONE}
+
+static const Timing TIMINGS[OPCODE_COUNT] = {
+    [OPCODE_ADD] = TIMING_R,
+    [OPCODE_ADDU] = TIMING_R,
+    [OPCODE_ADDI] = TIMING_I,
+    [OPCODE_SUB] = TIMING_R,
+    [OPCODE_SUBU] = TIMING_R,
+    [OPCODE_J] = {STAGE_NONE, STAGE_NONE, DESTINATION_NONE, STAGE_NONE},
+    [OPCODE_MULT] = TIMING_HI_LO,
+    [OPCODE_AND] = TIMING_R,
+    [OPCODE_OR] = TIMING_R,
+    [OPCODE_ANDI] = TIMING_I,
+    [OPCODE_ORI] = TIMING_I,
+    [OPCODE_BEQ] = TIMING_BRANCH,
+    [OPCODE_BNE] = TIMING_BRANCH,
+    [OPCODE_BLEZ] = TIMING_BRANCH,
+    [OPCODE_BGTZ] = TIMING_BRANCH,
+    [OPCODE_JAL] = {STAGE_NONE, STAGE_NONE, DESTINATION_RA, STAGE_EX},
+    [OPCODE_JR] = {STAGE_ID, STAGE_NONE, DESTINATION_NONE, STAGE_NONE},
+    [OPCODE_NOP] = {STAGE_NONE, STAGE_NONE, DESTINATION_NONE, STAGE_NONE},
+    [OPCODE_LB] = TIMING_LOAD,
+    [OPCODE_LBU] = TIMING_LOAD,
+    [OPCODE_LH] = TIMING_LOAD,
+    [OPCODE_LHU] = TIMING_LOAD,
+    [OPCODE_LW] = TIMING_LOAD,
+    [OPCODE_SB] = TIMING_STORE,
+    [OPCODE_SH] = TIMING_STORE,
+    [OPCODE_SW] = TIMING_STORE,
+    [OPCODE_MUL] = TIMING_R,
+    [OPCODE_MULTU] = TIMING_HI_LO,
+    [OPCODE_DIV] = TIMING_HI_LO,
+    [OPCODE_DIVU] = TIMING_HI_LO,
+    [OPCODE_MADD] = TIMING_HI_LO,
+    [OPCODE_MADDU] = TIMING_HI_LO,
+    [OPCODE_MSUB] = TIMING_HI_LO,
+    [OPCODE_MSUBU] = TIMING_HI_LO,
+    [OPCODE_MFHI] = {STAGE_NONE, STAGE_NONE, DESTINATION_RD, STAGE_EX},
+    [OPCODE_MFLO] = {STAGE_NONE, STAGE_NONE, DESTINATION_RD, STAGE_EX},
+    [OPCODE_MTHI] = {STAGE_EX, STAGE_NONE, DESTINATION_NONE, STAGE_NONE},
+    [OPCODE_MTLO] = {STAGE_EX, STAGE_NONE, DESTINATION_NONE, STAGE_NONE},
+    [OPCODE_XOR] = TIMING_R,
+    [OPCODE_NOR] = TIMING_R,
+    [OPCODE_SLT] = TIMING_R,
+    [OPCODE_SLTU] = TIMING_R,
+    [OPCODE_MOVZ] = TIMING_R,
+    [OPCODE_MOVN] = TIMING_R,
+    [OPCODE_SLL] = TIMING_SHIFT,
+    [OPCODE_SRL] = TIMING_SHIFT,
+    [OPCODE_SRA] = TIMING_SHIFT,
+    [OPCODE_SLLV] = TIMING_R,
+    [OPCODE_SRLV] = TIMING_R,
+    [OPCODE_SRAV] = TIMING_R,
+    [OPCODE_CLZ] = TIMING_UNARY,
+    [OPCODE_CLO] = TIMING_UNARY,
+    [OPCODE_ADDIU] = TIMING_I,
+    [OPCODE_SLTI] = TIMING_I,
+    [OPCODE_SLTIU] = TIMING_I,
+    [OPCODE_XORI] = TIMING_I,
+    [OPCODE_LUI] = {STAGE_NONE, STAGE_NONE, DESTINATION_RT, STAGE_EX},
+    [OPCODE_BLTZ] = TIMING_BRANCH_ZERO,
+    [OPCODE_BGEZ] = TIMING_BRANCH_ZERO,
+    [OPCODE_BLTZAL] = {STAGE_ID, STAGE_NONE, DESTINATION_RA, STAGE_EX},
+    [OPCODE_BGEZAL] = {STAGE_ID, STAGE_NONE, DESTINATION_RA, STAGE_EX},
+    [OPCODE_JALR] = {STAGE_ID, STAGE_NONE, DESTINATION_RD, STAGE_EX},
+
+    // The bytes left alone come from rt, so it is needed along with the word loaded
+    [OPCODE_LWL] = {STAGE_EX, STAGE_MEM, DESTINATION_RT, STAGE_MEM},
+    [OPCODE_LWR] = {STAGE_EX, STAGE_MEM, DESTINATION_RT, STAGE_MEM},
+    [OPCODE_SWL] = TIMING_STORE,
+    [OPCODE_SWR] = TIMING_STORE,
+
+    // The registers a syscall reads and writes are not in its fields, so it is timed as a NOP
+    [OPCODE_SYSCALL] = {STAGE_NONE, STAGE_NONE, DESTINATION_NONE, STAGE_NONE},
+
+    // Raises its exception before it gets to the pipeline
+    [OPCODE_RESERVED] = {STAGE_NONE, STAGE_NONE, DESTINATION_NONE, STAGE_NONE},
+};
+
+static uint64_t wait_operand(const Pipeline *pipeline, uint8_t number, uint8_t stage, uint64_t cycle);
+static void count_forwarding(Pipeline *pipeline, uint8_t number, uint8_t stage, uint64_t cycle);
+
+/// @brief Moves the first count instructions of block through the pipeline, in the order they executed.
+///
+/// next is the address executed after them: when the whole block ran and next does not follow it,
+/// its last instruction was a taken branch or a jump.
+void time_block(Pipeline *pipeline, const Block *block, unsigned int count, unsigned int next)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const Instruction *instruction = &block->operations[i].instruction;
+        const Timing *timing = &TIMINGS[instruction->opcode];
+
+        uint64_t cycle = pipeline->cycle;
+        cycle = wait_operand(pipeline, instruction->rs, timing->rs, cycle);
+        cycle = wait_operand(pipeline, instruction->rt, timing->rt, cycle);
+
+        uint64_t stalls = cycle - pipeline->cycle;
+        if (stalls > 0 && (timing->rs == STAGE_ID || timing->rt == STAGE_ID))
+        {
+            pipeline->branch_stalls += stalls;
+            pipeline->branch_hazards++;
+        }
+        else if (stalls > 0)
+        {
+            // Anything else gets arithmetic results right after they are computed, so it only waits on loads
+            pipeline->load_stalls += stalls;
+            pipeline->load_hazards++;
+        }
+
+        count_forwarding(pipeline, instruction->rs, timing->rs, cycle);
+        count_forwarding(pipeline, instruction->rt, timing->rt, cycle);
+
+        uint8_t destination = REGISTER_ZERO;
+        switch (timing->destination)
+        {
+        case DESTINATION_RD:
+            destination = instruction->rd;
+            break;
+        case DESTINATION_RT:
+            destination = instruction->rt;
+            break;
+        case DESTINATION_RA:
+            destination = REGISTER_RA;
+            break;
+        }
+
+        // Writes to $zero are thrown away, so nothing ever waits on them
+        if (destination != REGISTER_ZERO)
+        {
+            pipeline->ready[destination] = cycle + (timing->result - STAGE_ID) + 1;
+            pipeline->written[destination] = cycle + (STAGE_WB - STAGE_ID);
+        }
+
+        pipeline->cycle = cycle + 1;
+        pipeline->instructions++;
+    }
+
+    // The instruction fetched after a taken branch or a jump is the wrong one, and is dropped, unless it is
+    // the delay slot, which executes anyway
+    if (count == block->length && !block->delayed && next != block->start + 4 * block->length)
+    {
+        pipeline->cycle += PIPELINE_BRANCH_PENALTY;
+        pipeline->flush_cycles += PIPELINE_BRANCH_PENALTY;
+        pipeline->flushes++;
+    }
+}
+
+void print_pipeline(const Pipeline *pipeline, FILE *output)
+{
+    // The last instruction leaves WB as many cycles after it leaves ID as it took the first one to get there
+    uint64_t instructions = pipeline->instructions;
+    uint64_t fill = instructions > 0 ? STAGE_WB - STAGE_IF : 0;
+    uint64_t cycles = pipeline->cycle + fill;
+
+    fprintf(output, "\n");
+    fprintf(output, "PIPELINE\n");
+    fprintf(output, "\n");
+    fprintf(output, "IF/ID/EX/MEM/WB com adiantamento, desvios resolvidos em ID e previstos como não tomados\n");
+    fprintf(output, "\n");
+    fprintf(output, "Instruções executadas: %llu\n", (unsigned long long)instructions);
+    fprintf(output, "Ciclos: %llu (CPI %.2f)\n", (unsigned long long)cycles,
+            instructions > 0 ? (double)cycles / instructions : 0);
+    fprintf(output, "Operandos adiantados: %llu\n", (unsigned long long)pipeline->forwarded);
+    fprintf(output, "\n");
+
+    fprintf(output, "Ciclos perdidos\n");
+    fprintf(output, "\n");
+    fprintf(output, "  causa                     ciclos    ocorrências        %%\n");
+    fprintf(output, "  enchimento        %14llu %14u %7.2f%%\n", (unsigned long long)fill,
+            (unsigned int)(instructions > 0), cycles > 0 ? 100.0 * fill / cycles : 0);
+    fprintf(output, "  uso de load       %14llu %14llu %7.2f%%\n", (unsigned long long)pipeline->load_stalls,
+            (unsigned long long)pipeline->load_hazards, cycles > 0 ? 100.0 * pipeline->load_stalls / cycles : 0);
+    fprintf(output, "  operando de desvio%14llu %14llu %7.2f%%\n", (unsigned long long)pipeline->branch_stalls,
+            (unsigned long long)pipeline->branch_hazards, cycles > 0 ? 100.0 * pipeline->branch_stalls / cycles : 0);
+    fprintf(output, "  desvio ou salto   %14llu %14llu %7.2f%%\n", (unsigned long long)pipeline->flush_cycles,
+            (unsigned long long)pipeline->flushes, cycles > 0 ? 100.0 * pipeline->flush_cycles / cycles : 0);
+    fprintf(output, "\n");
+}
+
+/// @brief Earliest cycle, from cycle on, an instruction can leave ID in with the register ready for stage.
+static uint64_t wait_operand(const Pipeline *pipeline, uint8_t number, uint8_t stage, uint64_t cycle)
+{
+    if (stage == STAGE_NONE)
+    {
+        return cycle;
+    }
+
+    // An instruction in ID at cycle reaches stage at cycle + (stage - STAGE_ID)
+    uint64_t ready = pipeline->ready[number];
+    return ready > cycle + (stage - STAGE_ID) ? ready - (stage - STAGE_ID) : cycle;
+}
+
+/// @brief Counts the operand as forwarded when the register file did not have it yet in ID.
+static void count_forwarding(Pipeline *pipeline, uint8_t number, uint8_t stage, uint64_t cycle)
+{
+    // WB writes in the first half of its cycle and ID reads in the second half
+    if (stage != STAGE_NONE && number != REGISTER_ZERO && pipeline->written[number] > cycle)
+    {
+        pipeline->forwarded++;
+    }
+}
@@ -0,0 +1,365 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "block.h"
+#include "profile.h"
+
+typedef struct HotSpot HotSpot;
+
+struct HotSpot
+{
+    unsigned int index;
+    uint64_t count;
+};
+
+/// @brief Rough cost of every opcode on a single issue, in order core, only meant to rank hot spots.
+///
+/// Taken branches cost one more cycle on top of these.
+static const uint8_t CYCLES[OPCODE_COUNT] = {
+    [OPCODE_ADD] = 1, [OPCODE_ADDU] = 1, [OPCODE_ADDI] = 1, [OPCODE_SUB] = 1, [OPCODE_SUBU] = 1,
+    [OPCODE_MULT] = 4, [OPCODE_AND] = 1, [OPCODE_OR] = 1, [OPCODE_ANDI] = 1, [OPCODE_ORI] = 1,
+    [OPCODE_BEQ] = 1, [OPCODE_BNE] = 1, [OPCODE_BLEZ] = 1, [OPCODE_BGTZ] = 1,
+    [OPCODE_J] = 2, [OPCODE_JAL] = 2, [OPCODE_JR] = 2, [OPCODE_NOP] = 1,
+    [OPCODE_LB] = 2, [OPCODE_LBU] = 2, [OPCODE_LH] = 2, [OPCODE_LHU] = 2, [OPCODE_LW] = 2,
+    [OPCODE_SB] = 1, [OPCODE_SH] = 1, [OPCODE_SW] = 1,
+    [OPCODE_MUL] = 4, [OPCODE_MULTU] = 4, [OPCODE_MADD] = 4, [OPCODE_MADDU] = 4, [OPCODE_MSUB] = 4,
+    [OPCODE_MSUBU] = 4, [OPCODE_DIV] = 12, [OPCODE_DIVU] = 12,
+    [OPCODE_MFHI] = 1, [OPCODE_MFLO] = 1, [OPCODE_MTHI] = 1, [OPCODE_MTLO] = 1,
+    [OPCODE_XOR] = 1, [OPCODE_NOR] = 1, [OPCODE_SLT] = 1, [OPCODE_SLTU] = 1, [OPCODE_MOVZ] = 1, [OPCODE_MOVN] = 1,
+    [OPCODE_SLL] = 1, [OPCODE_SRL] = 1, [OPCODE_SRA] = 1, [OPCODE_SLLV] = 1, [OPCODE_SRLV] = 1, [OPCODE_SRAV] = 1,
+    [OPCODE_CLZ] = 1, [OPCODE_CLO] = 1, [OPCODE_ADDIU] = 1, [OPCODE_SLTI] = 1, [OPCODE_SLTIU] = 1,
+    [OPCODE_XORI] = 1, [OPCODE_LUI] = 1,
+    [OPCODE_BLTZ] = 1, [OPCODE_BGEZ] = 1, [OPCODE_BLTZAL] = 1, [OPCODE_BGEZAL] = 1, [OPCODE_JALR] = 2,
+    [OPCODE_LWL] = 2, [OPCODE_LWR] = 2, [OPCODE_SWL] = 1, [OPCODE_SWR] = 1, [OPCODE_SYSCALL] = 1,
+    [OPCODE_RESERVED] = 1,
+};
+
+static bool is_branch(uint8_t opcode);
+static int compare_hot_spots(const void *first, const void *second);
+
+bool reserve_profile(Profile *profile, unsigned int length, uint32_t entry)
+{
+    if (length > profile->length)
+    {
+        uint64_t *entries = realloc(profile->entries, length * sizeof(*entries));
+        if (entries != NULL)
+        {
+            profile->entries = entries;
+        }
+
+        uint64_t *taken = realloc(profile->taken, length * sizeof(*taken));
+        if (taken != NULL)
+        {
+            profile->taken = taken;
+        }
+
+        if (entries == NULL || taken == NULL)
+        {
+            printf("ERRO: Memória insuficiente para o perfil\n");
+            return false;
+        }
+
+        memset(entries + profile->length, 0, (length - profile->length) * sizeof(*entries));
+        memset(taken + profile->length, 0, (length - profile->length) * sizeof(*taken));
+        profile->length = length;
+    }
+
+    if (profile->node_count == 0)
+    {
+        profile->nodes = malloc(PROFILE_INITIAL_NODES * sizeof(CallNode));
+        profile->frames = malloc(PROFILE_INITIAL_FRAMES * sizeof(CallFrame));
+        if (profile->nodes == NULL || profile->frames == NULL)
+        {
+            printf("ERRO: Memória insuficiente para o perfil\n");
+            return false;
+        }
+
+        profile->node_capacity = PROFILE_INITIAL_NODES;
+        profile->frame_capacity = PROFILE_INITIAL_FRAMES;
+        profile->nodes[0] = (CallNode){.function = entry};
+        profile->node_count = 1;
+        profile->frames[0] = (CallFrame){.node = 0};
+        profile->depth = 1;
+    }
+
+    return true;
+}
+
+/// @brief Enters the function at target, staying in the current one if there is no memory left.
+void profile_call(Profile *profile, uint32_t call_site, uint32_t target)
+{
+    unsigned int caller = profile->frames[profile->depth - 1].node;
+
+    unsigned int callee = profile->nodes[caller].child;
+    while (callee != 0 && profile->nodes[callee].function != target)
+    {
+        callee = profile->nodes[callee].sibling;
+    }
+
+    if (callee == 0)
+    {
+        if (profile->node_count == profile->node_capacity)
+        {
+            CallNode *nodes = realloc(profile->nodes, 2 * profile->node_capacity * sizeof(*nodes));
+            if (nodes == NULL)
+            {
+                return;
+            }
+            profile->nodes = nodes;
+            profile->node_capacity *= 2;
+        }
+
+        callee = profile->node_count++;
+        profile->nodes[callee] = (CallNode){
+            .function = target,
+            .parent = caller,
+            .sibling = profile->nodes[caller].child,
+        };
+        profile->nodes[caller].child = callee;
+    }
+
+    if (profile->depth == profile->frame_capacity)
+    {
+        CallFrame *frames = realloc(profile->frames, 2 * profile->frame_capacity * sizeof(*frames));
+        if (frames == NULL)
+        {
+            return;
+        }
+        profile->frames = frames;
+        profile->frame_capacity *= 2;
+    }
+
+    profile->frames[profile->depth++] = (CallFrame){.node = callee, .call_site = call_site};
+}
+
+/// @brief Leaves every call up to the one that returns to target, a jump to anywhere else is no return.
+void profile_return(Profile *profile, uint32_t target)
+{
+    for (unsigned int depth = profile->depth - 1; depth > 0; depth--)
+    {
+        // Either just after the JAL, or after its delay slot
+        uint32_t distance = target - profile->frames[depth].call_site;
+        if (distance == 4 || distance == 8)
+        {
+            profile->depth = depth;
+            return;
+        }
+    }
+}
+
+/// @brief Counts the branch or jump at address, the index-th instruction, that went to target before its
+/// delay slot, which its own handler counts otherwise.
+void profile_delayed(Profile *profile, uint8_t opcode, unsigned int index, uint32_t address, uint32_t target, bool taken)
+{
+    switch (opcode)
+    {
+    case OPCODE_J:
+        break;
+    case OPCODE_JR:
+        profile_return(profile, target);
+        break;
+    case OPCODE_JAL:
+    case OPCODE_JALR:
+        profile_call(profile, address, target);
+        break;
+    default:
+        if (taken)
+        {
+            profile->taken[index]++;
+            if (opcode == OPCODE_BLTZAL || opcode == OPCODE_BGEZAL)
+            {
+                profile_call(profile, address, target);
+            }
+        }
+        break;
+    }
+}
+
+void print_profile(const Profile *profile, const Program *program)
+{
+    unsigned int length = profile->length < program->length ? profile->length : program->length;
+
+    uint64_t *counts = calloc(length + 1, sizeof(*counts));
+    HotSpot *hot_spots = malloc((length + 1) * sizeof(*hot_spots));
+    if (counts == NULL || hot_spots == NULL)
+    {
+        printf("ERRO: Memória insuficiente para o perfil\n");
+        free(counts);
+        free(hot_spots);
+        return;
+    }
+
+    // Every instruction of a block ran each time the block was entered
+    for (unsigned int index = 0; index < length; index++)
+    {
+        if (profile->entries[index] == 0)
+        {
+            continue;
+        }
+
+        unsigned int block_length = measure_block(program->instructions, length, index, program->delay_slots);
+        for (unsigned int i = 0; i < block_length; i++)
+        {
+            counts[index + i] += profile->entries[index];
+        }
+    }
+
+    uint64_t total = 0;
+    uint64_t cycles = 0;
+    uint64_t opcodes[OPCODE_COUNT] = {0};
+    uint64_t opcode_cycles[OPCODE_COUNT] = {0};
+    unsigned int executed = 0;
+
+    for (unsigned int index = 0; index < length; index++)
+    {
+        if (counts[index] == 0)
+        {
+            continue;
+        }
+
+        uint8_t opcode = program->instructions[index].opcode;
+        uint64_t instruction_cycles = counts[index] * CYCLES[opcode] + profile->taken[index];
+
+        total += counts[index];
+        cycles += instruction_cycles;
+        opcodes[opcode] += counts[index];
+        opcode_cycles[opcode] += instruction_cycles;
+        hot_spots[executed++] = (HotSpot){index, counts[index]};
+    }
+
+    qsort(hot_spots, executed, sizeof(*hot_spots), compare_hot_spots);
+
+    printf("\n");
+    printf("PERFIL\n");
+    printf("\n");
+    printf("Instruções executadas: %llu\n", (unsigned long long)total);
+    printf("Ciclos estimados: %llu (CPI %.2f)\n", (unsigned long long)cycles, total > 0 ? (double)cycles / total : 0);
+    printf("\n");
+
+    printf("Pontos quentes\n");
+    printf("\n");
+    printf("  endereço        execuções        %%  instrução\n");
+    for (unsigned int i = 0; i < executed && i < PROFILE_HOT_SPOTS; i++)
+    {
+        char assembly[64];
+        disassemble_instruction(&program->instructions[hot_spots[i].index], assembly, sizeof(assembly));
+        printf("  0x%08x %14llu %7.2f%%  %s\n", program->base + 4 * hot_spots[i].index,
+               (unsigned long long)hot_spots[i].count, 100.0 * hot_spots[i].count / total, assembly);
+    }
+    printf("\n");
+
+    printf("Instruções por opcode\n");
+    printf("\n");
+    printf("  opcode        execuções        %%         ciclos\n");
+    for (unsigned int opcode = 0; opcode < OPCODE_COUNT; opcode++)
+    {
+        if (opcodes[opcode] > 0)
+        {
+            printf("  %-8s %14llu %7.2f%% %14llu\n", opcode_name(opcode), (unsigned long long)opcodes[opcode],
+                   100.0 * opcodes[opcode] / total, (unsigned long long)opcode_cycles[opcode]);
+        }
+    }
+    printf("\n");
+
+    printf("Desvios\n");
+    printf("\n");
+    printf("  endereço        execuções        tomados    não tomados  tomados\n");
+    for (unsigned int index = 0; index < length; index++)
+    {
+        if (counts[index] > 0 && is_branch(program->instructions[index].opcode))
+        {
+            printf("  0x%08x %14llu %14llu %14llu %7.2f%%\n", program->base + 4 * index,
+                   (unsigned long long)counts[index], (unsigned long long)profile->taken[index],
+                   (unsigned long long)(counts[index] - profile->taken[index]),
+                   100.0 * profile->taken[index] / counts[index]);
+        }
+    }
+    printf("\n");
+
+    free(counts);
+    free(hot_spots);
+}
+
+/// @brief Writes one "caller;callee count" line per calling context, the format flamegraph.pl reads.
+bool write_folded_stacks(const Profile *profile, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    unsigned int *stack = malloc((profile->node_count + 1) * sizeof(*stack));
+    if (file == NULL || stack == NULL)
+    {
+        printf("ERRO: Não foi possível criar o arquivo \"%s\"\n", path);
+        if (file != NULL)
+        {
+            fclose(file);
+        }
+        free(stack);
+        return false;
+    }
+
+    for (unsigned int node = 0; node < profile->node_count; node++)
+    {
+        if (profile->nodes[node].instructions == 0)
+        {
+            continue;
+        }
+
+        // Walks up to the root, then prints the path from the root down
+        unsigned int depth = 0;
+        for (unsigned int ancestor = node; ancestor != 0; ancestor = profile->nodes[ancestor].parent)
+        {
+            stack[depth++] = ancestor;
+        }
+        stack[depth++] = 0;
+
+        while (depth > 0)
+        {
+            depth--;
+            fprintf(file, "0x%08x%c", profile->nodes[stack[depth]].function, depth > 0 ? ';' : ' ');
+        }
+        fprintf(file, "%llu\n", (unsigned long long)profile->nodes[node].instructions);
+    }
+
+    free(stack);
+    return fclose(file) == 0;
+}
+
+void free_profile(Profile *profile)
+{
+    free(profile->entries);
+    free(profile->taken);
+    free(profile->nodes);
+    free(profile->frames);
+    *profile = (Profile){0};
+}
+
+static bool is_branch(uint8_t opcode)
+{
+    switch (opcode)
+    {
+    case OPCODE_BEQ:
+    case OPCODE_BNE:
+    case OPCODE_BLEZ:
+    case OPCODE_BGTZ:
+    case OPCODE_BLTZ:
+    case OPCODE_BGEZ:
+    case OPCODE_BLTZAL:
+    case OPCODE_BGEZAL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static int compare_hot_spots(const void *first, const void *second)
+{
+    const HotSpot *a = first;
+    const HotSpot *b = second;
+
+    // Most executed first, then by address
+    if (a->count != b->count)
+    {
+        return a->count < b->count ? 1 : -1;
+    }
+    return a->index < b->index ? -1 : a->index > b->index;
+}
@@ -0,0 +1,75 @@
+#include "program.h"
+
+bool store_instruction(Program *program, unsigned int program_counter, Instruction instruction, FILE *output)
+{
+    if (program_counter < program->base)
+    {
+        fprintf(output, "ERRO: O endereço %u é anterior ao início do programa\n", program_counter);
+        return false;
+    }
+
+    unsigned int index = (program_counter - program->base) / 4;
+    if (index > program->length && index - program->length > PROGRAM_MAX_GAP)
+    {
+        fprintf(output, "ERRO: O endereço %u está longe demais do fim do programa, em %u\n", program_counter,
+                program->base + 4 * program->length);
+        return false;
+    }
+
+    if (index >= program->capacity)
+    {
+        unsigned int capacity = program->capacity == 0 ? PROGRAM_INITIAL_CAPACITY : program->capacity;
+        while (index >= capacity)
+        {
+            capacity *= 2;
+        }
+
+        Instruction *instructions = arena_grow(&program->arena, program->instructions,
+                                               program->capacity * sizeof(*instructions), capacity * sizeof(*instructions));
+        if (instructions == NULL)
+        {
+            fprintf(output, "ERRO: Memória insuficiente para armazenar o programa\n");
+            return false;
+        }
+
+        program->instructions = instructions;
+        program->capacity = capacity;
+    }
+
+    // Translated blocks may cover the instruction being replaced
+    if (index < program->length)
+    {
+        flush_blocks(&program->blocks);
+    }
+
+    // Addresses skipped by a jump forward are left empty
+    while (program->length <= index)
+    {
+        program->instructions[program->length] = (Instruction){.opcode = OPCODE_EMPTY};
+        program->length++;
+    }
+
+    program->instructions[index] = instruction;
+    return true;
+}
+
+/// @brief Empties the program for the next one, keeping the memory it took to reuse it.
+void reset_program(Program *program)
+{
+    flush_blocks(&program->blocks);
+    reset_arena(&program->arena);
+    program->base = 0;
+    program->instructions = NULL;
+    program->length = 0;
+    program->capacity = 0;
+    program->delay_slots = false;
+}
+
+void free_program(Program *program)
+{
+    free_blocks(&program->blocks);
+    free_arena(&program->arena);
+    program->instructions = NULL;
+    program->length = 0;
+    program->capacity = 0;
+}
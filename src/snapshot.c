@@ -0,0 +1,206 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "snapshot.h"
+
+static size_t pages_offset(uint32_t page_count);
+static uint64_t new_series(void);
+
+/// @brief Writes the CPU and its memory, or only the pages written since the last snapshot.
+///
+/// Pages count as clean again afterwards, so a series of incremental snapshots each hold what changed
+/// since the one before. A full snapshot starts a new series, and each incremental one takes the next
+/// place in the current one.
+bool write_snapshot(CPU *cpu, const char *path, bool incremental, FILE *output)
+{
+    Memory *memory = &cpu->memory;
+
+    uint32_t page_count;
+    uint32_t *page_numbers = list_pages(memory, incremental, &page_count);
+
+    FILE *file = page_numbers != NULL ? fopen(path, "wb") : NULL;
+    if (file == NULL)
+    {
+        fprintf(output, "ERRO: Não foi possível criar o arquivo \"%s\"\n", path);
+        free(page_numbers);
+        return false;
+    }
+
+    if (incremental)
+    {
+        memory->snapshot_sequence++;
+    }
+    else
+    {
+        memory->snapshot_series = new_series();
+        memory->snapshot_sequence = 0;
+    }
+
+    SnapshotHeader header = {
+        .version = SNAPSHOT_VERSION,
+        .flags = (incremental ? SNAPSHOT_INCREMENTAL : 0) | (memory->little_endian ? SNAPSHOT_LITTLE_ENDIAN : 0) |
+                 (cpu->exited ? SNAPSHOT_EXITED : 0),
+        .series = memory->snapshot_series,
+        .sequence = memory->snapshot_sequence,
+        .program_counter = cpu->program_counter,
+        .hi = cpu->hi,
+        .lo = cpu->lo,
+        .heap_break = cpu->heap_break,
+        .exit_status = cpu->exit_status,
+        .cop0 = cpu->cop0,
+        .page_count = page_count,
+        .instructions = cpu->instructions,
+    };
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    memcpy(header.gpr, cpu->gpr, sizeof(header.gpr));
+
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(page_numbers, sizeof(*page_numbers), page_count, file);
+
+    // Pads up to the first page, so every page starts at a multiple of PAGE_SIZE
+    static const uint8_t ZEROES[PAGE_SIZE];
+    fwrite(ZEROES, 1, pages_offset(page_count) - sizeof(header) - page_count * sizeof(*page_numbers), file);
+
+    for (uint32_t i = 0; i < page_count; i++)
+    {
+        uint32_t page_number = page_numbers[i];
+        fwrite(memory->directory[page_number >> TABLE_BITS]->pages[page_number & (TABLE_SIZE - 1)], 1, PAGE_SIZE, file);
+    }
+
+    free(page_numbers);
+
+    if (ferror(file) | fclose(file))
+    {
+        fprintf(output, "ERRO: Não foi possível escrever o arquivo \"%s\"\n", path);
+        return false;
+    }
+
+    clean_pages(memory);
+    return true;
+}
+
+/// @brief Restores the CPU from a snapshot, on top of the current one if it is incremental.
+///
+/// The file is mapped privately and its pages are used where they are, so restoring copies nothing and
+/// a page is only duplicated by the kernel once the program writes to it. An incremental snapshot only
+/// holds what changed since the one before it in its series, so it is refused unless that one was the
+/// last restored.
+bool restore_snapshot(CPU *cpu, const char *path, FILE *output)
+{
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor == -1)
+    {
+        fprintf(output, "ERRO: Não foi possível abrir o arquivo \"%s\"\n", path);
+        return false;
+    }
+
+    struct stat status;
+    uint8_t *image = MAP_FAILED;
+    if (fstat(descriptor, &status) == 0 && (size_t)status.st_size >= sizeof(SnapshotHeader))
+    {
+        image = mmap(NULL, status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+    }
+    close(descriptor);
+
+    if (image == MAP_FAILED)
+    {
+        fprintf(output, "ERRO: O arquivo \"%s\" não é um snapshot válido\n", path);
+        return false;
+    }
+
+    size_t size = status.st_size;
+    SnapshotHeader header;
+    memcpy(&header, image, sizeof(header));
+
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION ||
+        pages_offset(header.page_count) + (size_t)header.page_count * PAGE_SIZE > size)
+    {
+        fprintf(output, "ERRO: O arquivo \"%s\" não é um snapshot válido desta versão\n", path);
+        munmap(image, size);
+        return false;
+    }
+
+    bool incremental = (header.flags & SNAPSHOT_INCREMENTAL) != 0;
+    if (incremental && (cpu->memory.snapshot_series == 0 || header.series != cpu->memory.snapshot_series ||
+                        header.sequence != cpu->memory.snapshot_sequence + 1))
+    {
+        fprintf(output, "ERRO: O snapshot incremental \"%s\" não continua o último snapshot restaurado\n", path);
+        munmap(image, size);
+        return false;
+    }
+
+    Mapping *mapping = malloc(sizeof(Mapping));
+    if (mapping == NULL)
+    {
+        fprintf(output, "ERRO: Memória insuficiente para restaurar \"%s\"\n", path);
+        munmap(image, size);
+        return false;
+    }
+
+    // A full snapshot replaces the whole address space
+    if (!incremental)
+    {
+        free_memory(&cpu->memory);
+    }
+    cpu->memory.snapshot_series = header.series;
+    cpu->memory.snapshot_sequence = header.sequence;
+
+    *mapping = (Mapping){.next = cpu->memory.mappings, .address = image, .size = size};
+    cpu->memory.mappings = mapping;
+    cpu->memory.little_endian = (header.flags & SNAPSHOT_LITTLE_ENDIAN) != 0;
+
+    cpu->program_counter = header.program_counter;
+    memcpy(cpu->gpr, header.gpr, sizeof(cpu->gpr));
+    cpu->hi = header.hi;
+    cpu->lo = header.lo;
+    cpu->heap_break = header.heap_break;
+    cpu->exited = (header.flags & SNAPSHOT_EXITED) != 0;
+    cpu->exit_status = header.exit_status;
+    cpu->cop0 = header.cop0;
+    cpu->instructions = header.instructions;
+
+    const uint8_t *page_numbers = image + sizeof(header);
+    uint8_t *pages = image + pages_offset(header.page_count);
+
+    for (uint32_t i = 0; i < header.page_count; i++)
+    {
+        uint32_t page_number;
+        memcpy(&page_number, page_numbers + i * sizeof(page_number), sizeof(page_number));
+
+        if (page_number >= TABLE_SIZE * TABLE_SIZE)
+        {
+            fprintf(output, "ERRO: O arquivo \"%s\" não é um snapshot válido desta versão\n", path);
+            return false;
+        }
+
+        if (!map_page(&cpu->memory, page_number, pages + (size_t)i * PAGE_SIZE))
+        {
+            print_memory_fault(&cpu->memory, output);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static size_t pages_offset(uint32_t page_count)
+{
+    size_t end = sizeof(SnapshotHeader) + (size_t)page_count * sizeof(uint32_t);
+    return (end + PAGE_MASK) & ~(size_t)PAGE_MASK;
+}
+
+/// @brief A series number that is never 0 and differs between snapshots taken at different times or by
+/// different processes.
+static uint64_t new_series(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    uint64_t series = ((uint64_t)now.tv_sec * 1000000000u + now.tv_nsec) ^ ((uint64_t)getpid() << 40);
+    return series != 0 ? series : 1;
+}
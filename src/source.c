@@ -0,0 +1,309 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "source.h"
+
+/*
+ * Lines are handed out as slices of the text they were read into, which is never copied or written
+ * to. Files are mapped whole, and descriptors such as stdin are read in blocks of SOURCE_BLOCK_SIZE,
+ * where a line that does not fit in the buffer makes it grow, so lines can be of any length.
+ */
+
+static bool fill_buffer(Source *source);
+static size_t strip_comment(const char *line, size_t length);
+
+/// @brief Maps the whole file at path.
+bool open_source(Source *source, const char *path, FILE *output)
+{
+    *source = (Source){.descriptor = -1};
+
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor == -1)
+    {
+        fprintf(output, "ERRO: Não foi possível abrir o arquivo \"%s\"\n", path);
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(descriptor, &status) == -1)
+    {
+        fprintf(output, "ERRO: Não foi possível ler o arquivo \"%s\"\n", path);
+        close(descriptor);
+        return false;
+    }
+
+    // An empty file has no lines, and mmap does not accept a zero length
+    if (status.st_size == 0)
+    {
+        close(descriptor);
+        return true;
+    }
+
+    void *text = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+
+    if (text == MAP_FAILED)
+    {
+        fprintf(output, "ERRO: Não foi possível mapear o arquivo \"%s\"\n", path);
+        return false;
+    }
+
+    madvise(text, status.st_size, MADV_SEQUENTIAL);
+    source->text = text;
+    source->size = status.st_size;
+    source->mapped = true;
+    return true;
+}
+
+/// @brief Reads lines out of text, which must outlive the source.
+void open_text(Source *source, const char *text, size_t size)
+{
+    *source = (Source){.text = text, .size = size, .descriptor = -1};
+}
+
+/// @brief Reads lines from descriptor as they arrive, so an interactive terminal works as well.
+void open_stream(Source *source, int descriptor)
+{
+    *source = (Source){.descriptor = descriptor};
+}
+
+/// @brief Gets the next line, without its line break, comment and surrounding whitespace.
+///
+/// A line read from a descriptor is only valid until the next call. Returns false once the text ends.
+bool next_line(Source *source, Slice *line)
+{
+    const char *end = NULL;
+    while (end == NULL)
+    {
+        size_t available = source->size - source->position;
+        end = available > 0 ? memchr(source->text + source->position, '\n', available) : NULL;
+
+        if (end == NULL && !fill_buffer(source))
+        {
+            if (source->position == source->size)
+            {
+                return false;
+            }
+
+            // The last line may have no line break
+            end = source->text + source->size;
+        }
+    }
+
+    const char *start = source->text + source->position;
+    source->position = end - source->text + (end < source->text + source->size ? 1 : 0);
+    source->line_number++;
+
+    *line = trim_slice((Slice){start, strip_comment(start, end - start)});
+    return true;
+}
+
+void close_source(Source *source)
+{
+    if (source->mapped)
+    {
+        munmap((void *)source->text, source->size);
+    }
+
+    free(source->buffer);
+    *source = (Source){.descriptor = -1};
+}
+
+/// @brief The slice without whitespace at either end.
+Slice trim_slice(Slice slice)
+{
+    while (slice.length > 0 && is_whitespace(slice.start[0]))
+    {
+        slice.start++;
+        slice.length--;
+    }
+
+    while (slice.length > 0 && is_whitespace(slice.start[slice.length - 1]))
+    {
+        slice.length--;
+    }
+
+    return slice;
+}
+
+/// @brief Splits off the first word of rest, leaving rest with what comes after it, trimmed.
+Slice next_word(Slice *rest)
+{
+    Slice trimmed = trim_slice(*rest);
+
+    size_t length = 0;
+    while (length < trimmed.length && !is_whitespace(trimmed.start[length]))
+    {
+        length++;
+    }
+
+    *rest = trim_slice((Slice){trimmed.start + length, trimmed.length - length});
+    return (Slice){trimmed.start, length};
+}
+
+/// @brief Splits off what comes before the first separator, trimmed, leaving rest with what comes after it.
+///
+/// Without a separator the whole of rest is returned, and rest is left with a NULL start.
+Slice split_slice(Slice *rest, char separator)
+{
+    const char *found = memchr(rest->start, separator, rest->length);
+    if (found == NULL)
+    {
+        Slice last = trim_slice(*rest);
+        *rest = (Slice){NULL, 0};
+        return last;
+    }
+
+    Slice before = {rest->start, found - rest->start};
+    *rest = (Slice){found + 1, rest->length - before.length - 1};
+    return trim_slice(before);
+}
+
+bool slice_equals(Slice slice, const char *string)
+{
+    return strlen(string) == slice.length && memcmp(slice.start, string, slice.length) == 0;
+}
+
+/// @brief Parses a decimal integer with an optional sign, that must be within minimum and maximum.
+bool parse_integer(Slice slice, int64_t minimum, int64_t maximum, int64_t *value)
+{
+    size_t i = 0;
+    bool negative = false;
+    if (slice.length > 0 && (slice.start[0] == '-' || slice.start[0] == '+'))
+    {
+        negative = slice.start[0] == '-';
+        i++;
+    }
+
+    if (i == slice.length)
+    {
+        return false;
+    }
+
+    uint64_t magnitude = 0;
+    for (; i < slice.length; i++)
+    {
+        char digit = slice.start[i];
+        if (digit < '0' || digit > '9' || magnitude > (uint64_t)INT64_MAX / 10)
+        {
+            return false;
+        }
+        magnitude = magnitude * 10 + (digit - '0');
+    }
+
+    if (magnitude > (uint64_t)INT64_MAX)
+    {
+        return false;
+    }
+
+    int64_t number = negative ? -(int64_t)magnitude : (int64_t)magnitude;
+    if (number < minimum || number > maximum)
+    {
+        return false;
+    }
+
+    *value = number;
+    return true;
+}
+
+bool is_whitespace(char character)
+{
+    switch (character)
+    {
+    case ' ':
+    case '\t':
+    case '\r':
+    case '\n':
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// @brief Reads another block from the descriptor, keeping the line it is in the middle of.
+///
+/// Returns false at the end of the descriptor, or right away for text that is all in memory.
+static bool fill_buffer(Source *source)
+{
+    if (source->descriptor == -1)
+    {
+        return false;
+    }
+
+    // Moves the line being read to the start, then makes room for a block after it
+    size_t kept = source->size - source->position;
+    if (kept > 0)
+    {
+        memmove(source->buffer, source->buffer + source->position, kept);
+    }
+    source->position = 0;
+    source->size = kept;
+
+    if (source->capacity - kept < SOURCE_BLOCK_SIZE)
+    {
+        size_t capacity = source->capacity == 0 ? SOURCE_BLOCK_SIZE : 2 * source->capacity;
+        char *buffer = realloc(source->buffer, capacity);
+        if (buffer == NULL)
+        {
+            return false;
+        }
+
+        source->buffer = buffer;
+        source->capacity = capacity;
+    }
+    source->text = source->buffer;
+
+    ssize_t length;
+    do
+    {
+        length = read(source->descriptor, source->buffer + kept, source->capacity - kept);
+    } while (length == -1 && errno == EINTR);
+
+    if (length <= 0)
+    {
+        return false;
+    }
+
+    source->size += length;
+    return true;
+}
+
+/// @brief Length of the line before a "#" that starts a comment, which is not one inside quotes.
+static size_t strip_comment(const char *line, size_t length)
+{
+    const char *hash = memchr(line, '#', length);
+    if (hash == NULL)
+    {
+        return length;
+    }
+
+    // Only a string of .asciiz can hold a "#", so quotes are only looked for when there is one
+    if (memchr(line, '"', hash - line) == NULL)
+    {
+        return hash - line;
+    }
+
+    bool quoted = false;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (line[i] == '"')
+        {
+            quoted = !quoted;
+        }
+        else if (line[i] == '\\' && quoted)
+        {
+            i++;
+        }
+        else if (line[i] == '#' && !quoted)
+        {
+            return i;
+        }
+    }
+
+    return length;
+}
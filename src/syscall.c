@@ -0,0 +1,274 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "syscall.h"
+
+static bool is_supported(uint32_t number);
+static bool print_string(CPU *cpu, Console *console, uint32_t address);
+static void print_number(Console *console, uint32_t value, unsigned int base, unsigned int digits, const char *prefix);
+static int32_t read_int(Console *console);
+static bool read_string(CPU *cpu, Console *console, UndoLog *undo, uint32_t address, uint32_t size);
+static bool store_string_byte(CPU *cpu, UndoLog *undo, uint32_t address, uint8_t byte, bool first);
+static int read_byte(Console *console);
+static void write_console(Console *console, const void *bytes, size_t length);
+
+/*
+ * Syscalls run inside the interpreter, on the CPU that executed them, so one costs a switch and a copy
+ * into the console buffer, the same as a few instructions. Programs that print a lot go as fast as
+ * the rest of their code, and the host only sees a write per CONSOLE_BUFFER_SIZE bytes.
+ *
+ * The heap is plain memory past CPU.heap_break, whose pages are allocated once they are touched, so
+ * sbrk only moves the break.
+ */
+bool open_console(Console *console, FILE *output, FILE *input)
+{
+    *console = (Console){.output = output, .input = input};
+
+    console->buffer = malloc(CONSOLE_BUFFER_SIZE);
+    if (console->buffer == NULL)
+    {
+        fprintf(output, "ERRO: Memória insuficiente para a saída do programa\n");
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief Carries out the syscall whose number is in $v0.
+///
+/// With a NULL console whatever the program prints is dropped and it has no input, which is how
+/// replays run. With an undo log, the memory a syscall writes is recorded along with the record made
+/// for it before it ran.
+SyscallStatus run_syscall(CPU *cpu, Console *console, UndoLog *undo)
+{
+    uint32_t argument = cpu->gpr[REGISTER_A0];
+
+    switch (cpu->gpr[REGISTER_V0])
+    {
+    case SYSCALL_PRINT_INT:
+        print_number(console, (int32_t)argument < 0 ? 0u - argument : argument, 10, 1,
+                     (int32_t)argument < 0 ? "-" : "");
+        return SYSCALL_RETURNED;
+    case SYSCALL_PRINT_STRING:
+        return print_string(cpu, console, argument) ? SYSCALL_RETURNED : SYSCALL_FAILED;
+    case SYSCALL_READ_INT:
+        cpu->gpr[REGISTER_V0] = read_int(console);
+        return SYSCALL_RETURNED;
+    case SYSCALL_READ_STRING:
+        return read_string(cpu, console, undo, argument, cpu->gpr[REGISTER_A1]) ? SYSCALL_RETURNED : SYSCALL_FAILED;
+    case SYSCALL_SBRK:
+        if (cpu->heap_break == 0)
+        {
+            cpu->heap_break = HEAP_BASE;
+        }
+        cpu->gpr[REGISTER_V0] = cpu->heap_break;
+        cpu->heap_break += (argument + 3) & ~3u;
+        return SYSCALL_RETURNED;
+    case SYSCALL_EXIT:
+        cpu->exited = true;
+        cpu->exit_status = 0;
+        return SYSCALL_EXITED;
+    case SYSCALL_PRINT_CHAR:
+    {
+        uint8_t character = argument;
+        write_console(console, &character, 1);
+        return SYSCALL_RETURNED;
+    }
+    case SYSCALL_READ_CHAR:
+        cpu->gpr[REGISTER_V0] = read_byte(console);
+        return SYSCALL_RETURNED;
+    case SYSCALL_EXIT2:
+        cpu->exited = true;
+        cpu->exit_status = argument;
+        return SYSCALL_EXITED;
+    case SYSCALL_PRINT_HEX:
+        print_number(console, argument, 16, 8, "0x");
+        return SYSCALL_RETURNED;
+    case SYSCALL_PRINT_BINARY:
+        print_number(console, argument, 2, 32, "");
+        return SYSCALL_RETURNED;
+    case SYSCALL_PRINT_UNSIGNED:
+        print_number(console, argument, 10, 1, "");
+        return SYSCALL_RETURNED;
+    default:
+        return SYSCALL_FAILED;
+    }
+}
+
+/// @brief Reports why the syscall the CPU is about to execute failed.
+void print_syscall_fault(const CPU *cpu, FILE *output)
+{
+    if (is_supported(cpu->gpr[REGISTER_V0]))
+    {
+        print_memory_fault(&cpu->memory, output);
+    }
+    else
+    {
+        fprintf(output, "ERRO: Chamada de sistema %u não suportada\n", cpu->gpr[REGISTER_V0]);
+    }
+}
+
+void flush_console(Console *console)
+{
+    if (console->used > 0)
+    {
+        fwrite(console->buffer, 1, console->used, console->output);
+        fflush(console->output);
+        console->used = 0;
+    }
+}
+
+void close_console(Console *console)
+{
+    flush_console(console);
+    free(console->buffer);
+    *console = (Console){0};
+}
+
+static bool is_supported(uint32_t number)
+{
+    switch (number)
+    {
+    case SYSCALL_PRINT_INT:
+    case SYSCALL_PRINT_STRING:
+    case SYSCALL_READ_INT:
+    case SYSCALL_READ_STRING:
+    case SYSCALL_SBRK:
+    case SYSCALL_EXIT:
+    case SYSCALL_PRINT_CHAR:
+    case SYSCALL_READ_CHAR:
+    case SYSCALL_EXIT2:
+    case SYSCALL_PRINT_HEX:
+    case SYSCALL_PRINT_BINARY:
+    case SYSCALL_PRINT_UNSIGNED:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// @brief Copies the string a page at a time, up to its zero byte.
+static bool print_string(CPU *cpu, Console *console, uint32_t address)
+{
+    while (true)
+    {
+        const uint8_t *bytes = translate_address(&cpu->memory, address);
+        if (bytes == NULL)
+        {
+            return false;
+        }
+
+        size_t available = PAGE_SIZE - (address & PAGE_MASK);
+        const uint8_t *end = memchr(bytes, 0, available);
+        size_t length = end != NULL ? (size_t)(end - bytes) : available;
+
+        write_console(console, bytes, length);
+        if (end != NULL)
+        {
+            return true;
+        }
+        address += length;
+    }
+}
+
+/// @brief Prints value with at least the given amount of digits, after prefix.
+static void print_number(Console *console, uint32_t value, unsigned int base, unsigned int digits, const char *prefix)
+{
+    // Enough for 32 binary digits and a prefix of up to 2 characters
+    char text[34];
+    char *end = text + sizeof(text);
+    char *start = end;
+
+    do
+    {
+        *--start = "0123456789abcdef"[value % base];
+        value /= base;
+    } while (value != 0 || (unsigned int)(end - start) < digits);
+
+    size_t prefix_length = strlen(prefix);
+    start -= prefix_length;
+    memcpy(start, prefix, prefix_length);
+
+    write_console(console, start, end - start);
+}
+
+/// @brief Reads a line and parses the decimal at its start, which wraps around to 32 bits.
+static int32_t read_int(Console *console)
+{
+    char line[CONSOLE_LINE_LENGTH];
+    size_t length = 0;
+
+    int character;
+    while ((character = read_byte(console)) != EOF && character != '\n')
+    {
+        if (length + 1 < sizeof(line))
+        {
+            line[length++] = character;
+        }
+    }
+    line[length] = '\0';
+
+    return (int32_t)strtoll(line, NULL, 10);
+}
+
+/// @brief Reads like fgets: up to size - 1 bytes, stopping after a newline, then a zero byte.
+static bool read_string(CPU *cpu, Console *console, UndoLog *undo, uint32_t address, uint32_t size)
+{
+    if ((int32_t)size <= 0)
+    {
+        return true;
+    }
+
+    uint32_t length = 0;
+    int character = 0;
+    while (length + 1 < size && character != '\n' && (character = read_byte(console)) != EOF)
+    {
+        if (!store_string_byte(cpu, undo, address + length, character, length == 0))
+        {
+            return false;
+        }
+        length++;
+    }
+
+    return store_string_byte(cpu, undo, address + length, 0, length == 0);
+}
+
+/// @brief Stores a byte of a string read, after recording its word if it is the first byte written there.
+static bool store_string_byte(CPU *cpu, UndoLog *undo, uint32_t address, uint8_t byte, bool first)
+{
+    if (undo != NULL && (first || (address & 3) == 0))
+    {
+        record_continued_store(undo, &cpu->memory, address);
+    }
+
+    return store_byte(&cpu->memory, address, byte);
+}
+
+/// @brief Next byte of the input, or EOF, once whatever was printed before has been written.
+static int read_byte(Console *console)
+{
+    if (console == NULL || console->input == NULL)
+    {
+        return EOF;
+    }
+
+    // Prompts are shown before the program waits for an answer to them
+    flush_console(console);
+    return getc(console->input);
+}
+
+static void write_console(Console *console, const void *bytes, size_t length)
+{
+    if (console == NULL)
+    {
+        return;
+    }
+
+    if (console->used + length > CONSOLE_BUFFER_SIZE)
+    {
+        flush_console(console);
+    }
+
+    memcpy(console->buffer + console->used, bytes, length);
+    console->used += length;
+}
@@ -0,0 +1,144 @@
+#include <stdlib.h>
+
+#include "trace.h"
+
+static void trace_word(Trace *trace, uint32_t word, bool encoded);
+static void trace_disassembly(Trace *trace, const Instruction *instruction, uint32_t program_counter);
+
+bool open_trace(Trace *trace, TraceLevel level, FILE *output, const char *binary_path)
+{
+    *trace = (Trace){.level = level, .output = output};
+
+    if (level != TRACE_OFF)
+    {
+        trace->buffer = malloc(TRACE_BUFFER_SIZE);
+        if (trace->buffer == NULL)
+        {
+            fprintf(output, "ERRO: Memória insuficiente para o rastreamento\n");
+            return false;
+        }
+    }
+
+    if (binary_path != NULL)
+    {
+        trace->binary = fopen(binary_path, "wb");
+        trace->records = malloc(TRACE_RECORDS * sizeof(TraceRecord));
+        if (trace->binary == NULL || trace->records == NULL)
+        {
+            fprintf(output, "ERRO: Não foi possível criar o arquivo \"%s\"\n", binary_path);
+            close_trace(trace);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// @brief Records instruction, encoding it only for the binary trace and the words level, which print its word.
+void trace_instruction(Trace *trace, const Instruction *instruction, uint32_t program_counter)
+{
+    uint32_t word = TRACE_NO_WORD;
+    bool encoded = false;
+    if (trace->binary != NULL || trace->level == TRACE_WORDS)
+    {
+        encoded = encode_instruction(instruction, program_counter, &word);
+    }
+
+    if (trace->binary != NULL)
+    {
+        if (trace->recorded == TRACE_RECORDS)
+        {
+            flush_trace(trace);
+        }
+
+        trace->records[trace->recorded++] = (TraceRecord){program_counter, encoded ? word : TRACE_NO_WORD};
+    }
+
+    if (trace->level == TRACE_OFF)
+    {
+        return;
+    }
+
+    if (trace->used + TRACE_LINE_LENGTH > TRACE_BUFFER_SIZE)
+    {
+        flush_trace(trace);
+    }
+
+    if (trace->level == TRACE_WORDS)
+    {
+        trace_word(trace, word, encoded);
+    }
+    else
+    {
+        trace_disassembly(trace, instruction, program_counter);
+    }
+}
+
+void flush_trace(Trace *trace)
+{
+    if (trace->used > 0)
+    {
+        fwrite(trace->buffer, 1, trace->used, trace->output);
+        fflush(trace->output);
+        trace->used = 0;
+    }
+
+    if (trace->recorded > 0)
+    {
+        fwrite(trace->records, sizeof(TraceRecord), trace->recorded, trace->binary);
+        trace->recorded = 0;
+    }
+}
+
+void close_trace(Trace *trace)
+{
+    flush_trace(trace);
+
+    if (trace->binary != NULL)
+    {
+        fclose(trace->binary);
+    }
+
+    free(trace->buffer);
+    free(trace->records);
+    *trace = (Trace){0};
+}
+
+/// @brief Writes the fields of the machine word, split by its format.
+static void trace_word(Trace *trace, uint32_t word, bool encoded)
+{
+    char *line = trace->buffer + trace->used;
+    int length;
+
+    uint8_t opcode = word >> 26;
+    if (!encoded)
+    {
+        length = snprintf(line, TRACE_LINE_LENGTH, "EXECUTE -> instrução sem codificação em 32 bits\n");
+    }
+    else if (opcode == 0x00 || opcode == 0x1C)
+    {
+        length = snprintf(line, TRACE_LINE_LENGTH, "EXECUTE -> %u %u %u %u %u %u\n", opcode, (word >> 21) & 0x1F,
+                          (word >> 16) & 0x1F, (word >> 11) & 0x1F, (word >> 6) & 0x1F, word & 0x3F);
+    }
+    else if (opcode == 0x02 || opcode == 0x03)
+    {
+        length = snprintf(line, TRACE_LINE_LENGTH, "EXECUTE -> %u %u\n", opcode, word & 0x03FFFFFF);
+    }
+    else
+    {
+        // ANDI, ORI, XORI and LUI zero extend their immediate, everything else sign extends it
+        int32_t immediate = opcode >= 0x0C && opcode <= 0x0F ? (int32_t)(word & 0xFFFF) : (int16_t)(word & 0xFFFF);
+        length = snprintf(line, TRACE_LINE_LENGTH, "EXECUTE -> %u %u %u %d\n", opcode, (word >> 21) & 0x1F,
+                          (word >> 16) & 0x1F, immediate);
+    }
+
+    trace->used += length;
+}
+
+static void trace_disassembly(Trace *trace, const Instruction *instruction, uint32_t program_counter)
+{
+    char assembly[TRACE_LINE_LENGTH - 16];
+    disassemble_instruction(instruction, assembly, sizeof(assembly));
+
+    trace->used += snprintf(trace->buffer + trace->used, TRACE_LINE_LENGTH, "%08x: %s\n", program_counter, assembly);
+}
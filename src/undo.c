@@ -0,0 +1,209 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "undo.h"
+
+static Checkpoint *newest_checkpoint(UndoLog *undo);
+static void drop_newest_checkpoint(UndoLog *undo);
+
+/// @brief Preallocates room for capacity records, rounded up to a power of two.
+bool open_undo(UndoLog *undo, uint32_t capacity)
+{
+    uint32_t rounded = 2;
+    while (rounded < capacity && rounded < 1u << 31)
+    {
+        rounded *= 2;
+    }
+
+    *undo = (UndoLog){.mask = rounded - 1, .interval = rounded / 2};
+    undo->records = malloc((size_t)rounded * sizeof(UndoRecord));
+    return undo->records != NULL;
+}
+
+/// @brief Forgets the records of the last instruction, which failed and never retired.
+void drop_undo(UndoLog *undo)
+{
+    bool continued;
+    do
+    {
+        continued = continues_record(&undo->records[--undo->top & undo->mask]);
+        undo->available--;
+    } while (continued && undo->available > 0);
+}
+
+/// @brief Takes the CPU back to right before the last instruction it executed, if it is still recorded.
+bool undo_instruction(UndoLog *undo, CPU *cpu)
+{
+    // Words written along with an instruction's first record come after it, and go back before it
+    const UndoRecord *record;
+    do
+    {
+        if (undo->available == 0)
+        {
+            // Nothing is recorded, or the ring dropped the start of this instruction and only a checkpoint
+            // can take it back
+            return false;
+        }
+
+        undo->available--;
+        record = &undo->records[--undo->top & undo->mask];
+
+        if ((record->location & 3) == 0)
+        {
+            store_word(&cpu->memory, record->location, record->value);
+        }
+        else if (record->location == UNDO_HI_LO)
+        {
+            cpu->hi = record->value >> 32;
+            cpu->lo = record->value;
+        }
+        else if (record->location == UNDO_SYSCALL)
+        {
+            cpu->heap_break = record->value >> 32;
+            cpu->gpr[REGISTER_V0] = record->value;
+        }
+        else if (record->location != UNDO_NOTHING)
+        {
+            cpu->gpr[record->location >> 2] = record->value;
+        }
+    } while (continues_record(record));
+
+    cpu->program_counter = record->program_counter;
+    cpu->instructions--;
+
+    // Checkpoints from later on are taken again if execution gets there
+    while (undo->checkpoint_count > 0 && newest_checkpoint(undo)->instructions > cpu->instructions)
+    {
+        drop_newest_checkpoint(undo);
+    }
+
+    return true;
+}
+
+/// @brief Copies the CPU and all of its memory, replacing the oldest checkpoint when they are all taken.
+///
+/// Running out of memory only leaves this checkpoint out.
+void take_checkpoint(UndoLog *undo, CPU *cpu, uint32_t program_counter)
+{
+    undo->next_checkpoint = cpu->instructions + undo->interval;
+
+    uint32_t page_count;
+    uint32_t *page_numbers = list_pages(&cpu->memory, false, &page_count);
+
+    // One byte more, so an empty memory does not look like a failed allocation
+    uint8_t *pages = page_numbers != NULL ? malloc((size_t)page_count * PAGE_SIZE + 1) : NULL;
+    if (pages == NULL)
+    {
+        free(page_numbers);
+        return;
+    }
+
+    for (uint32_t i = 0; i < page_count; i++)
+    {
+        uint32_t page_number = page_numbers[i];
+        memcpy(pages + (size_t)i * PAGE_SIZE,
+               cpu->memory.directory[page_number >> TABLE_BITS]->pages[page_number & (TABLE_SIZE - 1)], PAGE_SIZE);
+    }
+
+    if (undo->checkpoint_count == UNDO_CHECKPOINTS)
+    {
+        free(undo->checkpoints[undo->oldest].page_numbers);
+        free(undo->checkpoints[undo->oldest].pages);
+        undo->oldest = (undo->oldest + 1) % UNDO_CHECKPOINTS;
+        undo->checkpoint_count--;
+    }
+
+    undo->checkpoint_count++;
+    Checkpoint *checkpoint = newest_checkpoint(undo);
+    *checkpoint = (Checkpoint){
+        .program_counter = program_counter,
+        .hi = cpu->hi,
+        .lo = cpu->lo,
+        .heap_break = cpu->heap_break,
+        .instructions = cpu->instructions,
+        .page_count = page_count,
+        .page_numbers = page_numbers,
+        .pages = pages,
+    };
+    memcpy(checkpoint->gpr, cpu->gpr, sizeof(checkpoint->gpr));
+}
+
+/// @brief Puts the CPU back at the newest checkpoint taken at or before the given instruction, if any.
+///
+/// The records and the checkpoints after it belong to what comes next, so they are dropped and
+/// executing again from here takes them anew.
+bool restore_checkpoint(UndoLog *undo, CPU *cpu, uint64_t instructions)
+{
+    unsigned int count = undo->checkpoint_count;
+    while (count > 0 && undo->checkpoints[(undo->oldest + count - 1) % UNDO_CHECKPOINTS].instructions > instructions)
+    {
+        count--;
+    }
+
+    if (count == 0)
+    {
+        return false;
+    }
+
+    while (undo->checkpoint_count > count)
+    {
+        drop_newest_checkpoint(undo);
+    }
+
+    const Checkpoint *checkpoint = newest_checkpoint(undo);
+
+    free_memory(&cpu->memory);
+    for (uint32_t i = 0; i < checkpoint->page_count; i++)
+    {
+        if (!write_memory(&cpu->memory, checkpoint->page_numbers[i] << PAGE_BITS,
+                          checkpoint->pages + (size_t)i * PAGE_SIZE, PAGE_SIZE))
+        {
+            return false;
+        }
+    }
+
+    cpu->program_counter = checkpoint->program_counter;
+    memcpy(cpu->gpr, checkpoint->gpr, sizeof(cpu->gpr));
+    cpu->hi = checkpoint->hi;
+    cpu->lo = checkpoint->lo;
+    cpu->heap_break = checkpoint->heap_break;
+    cpu->instructions = checkpoint->instructions;
+
+    undo->available = 0;
+    undo->next_checkpoint = checkpoint->instructions + undo->interval;
+    return true;
+}
+
+/// @brief Drops every checkpoint, such as when the program they would replay changes.
+///
+/// The records stay, since they hold values and not instructions, and the next checkpoint is taken
+/// right away.
+void forget_checkpoints(UndoLog *undo)
+{
+    while (undo->checkpoint_count > 0)
+    {
+        drop_newest_checkpoint(undo);
+    }
+}
+
+void free_undo(UndoLog *undo)
+{
+    forget_checkpoints(undo);
+    free(undo->records);
+    undo->records = NULL;
+}
+
+static Checkpoint *newest_checkpoint(UndoLog *undo)
+{
+    return &undo->checkpoints[(undo->oldest + undo->checkpoint_count - 1) % UNDO_CHECKPOINTS];
+}
+
+static void drop_newest_checkpoint(UndoLog *undo)
+{
+    Checkpoint *checkpoint = newest_checkpoint(undo);
+    free(checkpoint->page_numbers);
+    free(checkpoint->pages);
+    undo->checkpoint_count--;
+
+    undo->next_checkpoint = undo->checkpoint_count > 0 ? newest_checkpoint(undo)->instructions + undo->interval : 0;
+}
@@ -0,0 +1,179 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "keyword.h"
+
+/*
+ * Generates the perfect hash table of find_keyword, since C cannot hash string literals in constant
+ * expressions. Words go into buckets by their hash and the buckets are placed largest first, each
+ * with the first seed that sends all of its words into slots still free, which with this many slots
+ * to spare is always one of the first few tried.
+ *
+ * Usage: keyword_table saída.h
+ */
+
+#define MAX_KEYWORDS KEYWORD_SLOTS
+
+typedef struct Entry Entry;
+
+struct Entry
+{
+    char name[8];
+    const char *kind;
+
+    /// @brief Opcode name of a mnemonic, or number of a register.
+    char value[16];
+
+    uint64_t hash;
+};
+
+static Entry entries[MAX_KEYWORDS];
+static unsigned int entry_count;
+
+static void add_entry(const char *name, const char *kind, const char *value);
+static bool place_bucket(unsigned int bucket, uint8_t seed, int *slots);
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Uso: %s saída.h\n", argv[0]);
+        return 1;
+    }
+
+    char value[16];
+
+#define MNEMONIC(name, format) add_entry(#name, "KEYWORD_MNEMONIC", "OPCODE_" #name);
+#define REGISTER(name, number) \
+    snprintf(value, sizeof(value), "%d", number); \
+    add_entry("$" #name, "KEYWORD_REGISTER", value);
+#include "keywords.def"
+#undef MNEMONIC
+#undef REGISTER
+
+    // Registers can also be written as their number
+    for (int number = 0; number < 32; number++)
+    {
+        char name[8];
+        snprintf(name, sizeof(name), "$%d", number);
+        snprintf(value, sizeof(value), "%d", number);
+        add_entry(name, "KEYWORD_REGISTER", value);
+    }
+
+    unsigned int sizes[KEYWORD_BUCKETS] = {0};
+    for (unsigned int i = 0; i < entry_count; i++)
+    {
+        sizes[entries[i].hash & (KEYWORD_BUCKETS - 1)]++;
+    }
+
+    int slots[KEYWORD_SLOTS];
+    memset(slots, -1, sizeof(slots));
+    uint8_t seeds[KEYWORD_BUCKETS] = {0};
+    bool placed[KEYWORD_BUCKETS] = {false};
+
+    for (unsigned int placed_count = 0; placed_count < KEYWORD_BUCKETS; placed_count++)
+    {
+        unsigned int bucket = 0;
+        for (unsigned int b = 0; b < KEYWORD_BUCKETS; b++)
+        {
+            if (!placed[b] && (placed[bucket] || sizes[b] > sizes[bucket]))
+            {
+                bucket = b;
+            }
+        }
+
+        unsigned int seed = 0;
+        while (seed <= UINT8_MAX && !place_bucket(bucket, seed, slots))
+        {
+            seed++;
+        }
+
+        if (seed > UINT8_MAX)
+        {
+            fprintf(stderr, "ERRO: Nenhuma semente separa as palavras do balde %u, aumente KEYWORD_SLOTS\n", bucket);
+            return 1;
+        }
+
+        seeds[bucket] = seed;
+        placed[bucket] = true;
+    }
+
+    FILE *output = fopen(argv[1], "w");
+    if (output == NULL)
+    {
+        fprintf(stderr, "ERRO: Não foi possível criar \"%s\"\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(output, "// Generated by tools/keyword_table.c from includes/keywords.def, do not edit\n\n");
+
+    fprintf(output, "static const uint8_t KEYWORD_SEEDS[KEYWORD_BUCKETS] = {");
+    for (unsigned int b = 0; b < KEYWORD_BUCKETS; b++)
+    {
+        fprintf(output, "%s%u", b % 16 == 0 ? "\n    " : " ", seeds[b]);
+        fputc(',', output);
+    }
+    fprintf(output, "\n};\n\n");
+
+    fprintf(output, "static const Keyword KEYWORDS[KEYWORD_SLOTS] = {\n");
+    for (unsigned int slot = 0; slot < KEYWORD_SLOTS; slot++)
+    {
+        if (slots[slot] >= 0)
+        {
+            const Entry *entry = &entries[slots[slot]];
+            fprintf(output, "    [%u] = {\"%s\", %zu, %s, %s},\n", slot, entry->name, strlen(entry->name), entry->kind,
+                    entry->value);
+        }
+    }
+    fprintf(output, "};\n");
+
+    return fclose(output) == 0 ? 0 : 1;
+}
+
+static void add_entry(const char *name, const char *kind, const char *value)
+{
+    if (entry_count == MAX_KEYWORDS)
+    {
+        fprintf(stderr, "ERRO: Mais de %d palavras reservadas\n", MAX_KEYWORDS);
+        exit(1);
+    }
+
+    Entry *entry = &entries[entry_count++];
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+    snprintf(entry->value, sizeof(entry->value), "%s", value);
+    entry->kind = kind;
+    entry->hash = hash_keyword(name, strlen(name));
+}
+
+/// @brief Takes the slots the words of the bucket get with seed, unless one of them is already taken.
+static bool place_bucket(unsigned int bucket, uint8_t seed, int *slots)
+{
+    unsigned int taken[MAX_KEYWORDS];
+    unsigned int taken_count = 0;
+
+    for (unsigned int i = 0; i < entry_count; i++)
+    {
+        if ((entries[i].hash & (KEYWORD_BUCKETS - 1)) != bucket)
+        {
+            continue;
+        }
+
+        unsigned int slot = keyword_slot(entries[i].hash, seed);
+        if (slots[slot] >= 0)
+        {
+            // Gives back what this seed took, including a slot two words of the bucket share
+            for (unsigned int t = 0; t < taken_count; t++)
+            {
+                slots[taken[t]] = -1;
+            }
+            return false;
+        }
+
+        slots[slot] = i;
+        taken[taken_count++] = slot;
+    }
+
+    return true;
+}